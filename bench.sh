@@ -0,0 +1,18 @@
+#!/usr/bin/env bash
+# build the host benchmarks in tests/host, run them and print their results as a JSON array
+# usage: bench.sh [results.json] [repeat]
+BUILD_DIR=_host_build
+cd "$(dirname "$0")" || exit
+OUT=${1:-/dev/stdout}
+REPEAT=${2:-1000}
+
+cmake -S tests/host -B ${BUILD_DIR} -DCMAKE_BUILD_TYPE=Release >/dev/null || exit
+cmake --build ${BUILD_DIR} --target bench_hot_paths bench_hot_paths_bitmap >/dev/null || exit
+
+{
+    echo "["
+    ${BUILD_DIR}/bench_hot_paths "${REPEAT}" || exit
+    echo ","
+    ${BUILD_DIR}/bench_hot_paths_bitmap "${REPEAT}" || exit
+    echo "]"
+} >"${OUT}"
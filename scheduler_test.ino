@@ -23,8 +23,8 @@ Queue qRequests(qData, sizeof(qData));
 #define  TWI_MAX_TASKS 4
 #define  TWI_MAX_BUFFER 248
 
-uint8_t controllerBuffer[sizeOfControllerBuffer(TWI_MAX_STREAMS, TWI_MAX_TASKS, TWI_MAX_BUFFER)];
-TwiController twiController(controllerBuffer, TWI_MAX_STREAMS, TWI_MAX_TASKS, TWI_MAX_BUFFER, 0);
+ControllerStorage<TWI_MAX_STREAMS, TWI_MAX_TASKS, TWI_MAX_BUFFER> controllerStorage;
+TwiController twiController(controllerStorage, 0);
 
 /*
   SerialEvent occurs whenever a new data comes in the hardware serial RX. This
@@ -114,7 +114,7 @@ Task *const taskTable[] PROGMEM = {
         &ledFlasher2,
 };
 
-time_t delayTable[lengthof(taskTable)];
+sched_time_t delayTable[lengthof(taskTable)];
 Scheduler scheduler = Scheduler(lengthof(taskTable), reinterpret_cast<PGM_P>(taskTable), delayTable);
 
 void setup() {
@@ -0,0 +1,189 @@
+#include "Arduino.h"
+#include <stdarg.h>
+#include "BinLog.h"
+#include "common_defs.h"
+
+static uint8_t *pLogBuffer;
+static uint16_t nLogSize;
+static volatile uint16_t nLogHead;          // read position
+static volatile uint16_t nLogTail;          // write position
+
+uint16_t binlog_dropped;
+
+void binlog_init(uint8_t *pBuffer, uint16_t nSize) {
+    CLI();
+    pLogBuffer = pBuffer;
+    nLogSize = nSize;
+    nLogHead = 0;
+    nLogTail = 0;
+    binlog_dropped = 0;
+    SEI();
+}
+
+// sets count to NULL_BYTE if the argument does not fit, the record is then dropped
+static inline void binlog_put_arg(uint8_t *pArgs, uint8_t *pCount, uint32_t value, uint8_t nSize) {
+    if (*pCount > BINLOG_MAX_ARGS - nSize) {
+        *pCount = NULL_BYTE;
+        return;
+    }
+
+    // little endian, as stored by avr-gcc
+    while (nSize--) {
+        pArgs[(*pCount)++] = value;
+        value >>= 8;
+    }
+}
+
+// collect argument bytes as given by the format conversions, NULL_BYTE if they do not fit in BINLOG_MAX_ARGS
+static uint8_t binlog_args(uint8_t *pArgs, const char *fmt, va_list ap) {
+    uint8_t nArgs = 0;
+    char c;
+
+    while ((c = pgm_read_byte(fmt++))) {
+        if (c != '%') continue;
+
+        uint8_t isLong = 0;
+        for (;;) {
+            c = pgm_read_byte(fmt++);
+
+            if (c == 'l') {
+                isLong = 1;
+            } else if (c == '*') {
+                binlog_put_arg(pArgs, &nArgs, va_arg(ap, int), 2);
+            } else if (!((c >= '0' && c <= '9') || c == '.' || c == '-' || c == '+' || c == ' ' || c == '#' || c == 'h')) {
+                break;
+            }
+        }
+
+        switch (c) {
+            case 0:
+                return nArgs;
+
+            case '%':
+                break;
+
+            case 's': {
+                const char *str = va_arg(ap, const char *);
+                uint8_t i = 0;
+                while (i < BINLOG_MAX_STRING && str[i]) {
+                    binlog_put_arg(pArgs, &nArgs, str[i++], 1);
+                }
+                binlog_put_arg(pArgs, &nArgs, 0, 1);
+                break;
+            }
+
+            case 'S':
+            case 'p':
+                binlog_put_arg(pArgs, &nArgs, (uint16_t) (uintptr_t) va_arg(ap, const void *), 2);
+                break;
+
+            case 'e':
+            case 'E':
+            case 'f':
+            case 'F':
+            case 'g':
+            case 'G': {
+                // avr-gcc double is 4 byte float
+                const float value = (float) va_arg(ap, double);
+                uint32_t bits;
+                memcpy(&bits, &value, sizeof(bits));
+                binlog_put_arg(pArgs, &nArgs, bits, 4);
+                break;
+            }
+
+            default:
+                if (isLong) {
+                    binlog_put_arg(pArgs, &nArgs, va_arg(ap, unsigned long), 4);
+                } else {
+                    binlog_put_arg(pArgs, &nArgs, va_arg(ap, unsigned int), 2);
+                }
+                break;
+        }
+    }
+    return nArgs;
+}
+
+static inline void binlog_put(uint8_t data) {
+    pLogBuffer[nLogTail] = data;
+    if (++nLogTail == nLogSize) nLogTail = 0;
+}
+
+static int binlog_write(const char *fmt, uint8_t flags, const uint8_t *pArgs, uint8_t nArgs) {
+    const uint16_t fmtAddr = (uint16_t) (uintptr_t) fmt;
+    const uint16_t nRecord = 4 + nArgs;
+
+    CLI();
+    if (!nLogSize) {
+        SEI();
+        return 0;
+    }
+
+    const uint16_t nFree = nLogSize - 1 - (uint16_t) (nLogTail >= nLogHead ? nLogTail - nLogHead : nLogSize - nLogHead + nLogTail);
+
+    if (nRecord + (binlog_dropped ? 6 : 0) > nFree) {
+        if (binlog_dropped < NULL_WORD) binlog_dropped++;
+        SEI();
+        return 0;
+    }
+
+    if (binlog_dropped) {
+        binlog_put(BINLOG_SYNC);
+        binlog_put(2);
+        binlog_put(0);
+        binlog_put(0);
+        binlog_put(binlog_dropped);
+        binlog_put(binlog_dropped >> 8);
+        binlog_dropped = 0;
+    }
+
+    binlog_put(BINLOG_SYNC);
+    binlog_put(nArgs | flags);
+    binlog_put(fmtAddr);
+    binlog_put(fmtAddr >> 8);
+    while (nArgs--) {
+        binlog_put(*pArgs++);
+    }
+    SEI();
+    return nRecord;
+}
+
+int binlog_printf_P(const char *fmt, ...) {
+    uint8_t args[BINLOG_MAX_ARGS];
+    va_list ap;
+
+    va_start(ap, fmt);
+    const uint8_t nArgs = binlog_args(args, fmt, ap);
+    va_end(ap);
+
+    if (nArgs == NULL_BYTE) {
+        // a record with missing arguments would be misread by the decoder, drop it
+        CLI();
+        if (binlog_dropped < NULL_WORD) binlog_dropped++;
+        SEI();
+        return 0;
+    }
+
+    return binlog_write(fmt, 0, args, nArgs);
+}
+
+int binlog_puts_P(const char *str) {
+    return binlog_write(str, BINLOG_FLAGS_PUTS, NULL, 0);
+}
+
+uint16_t binlog_count(void) {
+    CLI();
+    const uint16_t nTail = nLogTail;
+    SEI();
+    return nTail >= nLogHead ? nTail - nLogHead : nLogSize - nLogHead + nTail;
+}
+
+uint8_t binlog_get(void) {
+    const uint8_t data = pLogBuffer[nLogHead];
+    const uint16_t nHead = nLogHead + 1;
+
+    // binlog_write() reads the head from interrupts, both bytes must change at once
+    CLI();
+    nLogHead = nHead == nLogSize ? 0 : nHead;
+    SEI();
+    return data;
+}
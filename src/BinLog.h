@@ -0,0 +1,84 @@
+#ifndef SCHEDULER_BINLOG_H
+#define SCHEDULER_BINLOG_H
+
+/*
+ * Binary deferred format logging.
+ *
+ * binlog_printf_P() does not format, it stores a record with the PROGMEM address of the format string and the raw
+ * argument bytes in a ring buffer, BinLogWriter task streams the buffer to the serial port without blocking and
+ * tools/binlog_decode.py formats the records on the host, resolving format strings and %S arguments from the
+ * firmware ELF file.
+ *
+ * With SERIAL_DEBUG_BINLOG, common_defs.h routes printf_P() and puts_P() to binlog_printf_P() and binlog_puts_P(),
+ * so all serialDebug...Printf_P() macros log through it.
+ *
+ * Record: BINLOG_SYNC, length of arguments | BINLOG_FLAGS_PUTS, format address low, high, arguments
+ *
+ * Arguments are stored as avr-gcc passes them: int sized conversions 2 bytes, l modified 4 bytes, %S and %p 2 byte
+ * address, %s string content up to BINLOG_MAX_STRING characters and NUL since the RAM content is gone by the time
+ * it is decoded. Records which do not fit, or whose arguments take more than BINLOG_MAX_ARGS bytes, are dropped and
+ * counted, the count is logged as a record with format address 0 ahead of the next record that fits.
+ *
+ * Records are stored with interrupts disabled, logging from interrupts is safe.
+ */
+
+#include <stdint.h>
+
+#ifndef CONSOLE_DEBUG
+#include <avr/pgmspace.h>
+#endif
+
+#define BINLOG_SYNC             (0xB1)
+#define BINLOG_FLAGS_PUTS       (0x80)      // puts_P() record, decoder adds new line
+
+#ifndef BINLOG_MAX_ARGS
+#define BINLOG_MAX_ARGS         (32)        // max argument bytes in a record, up to 127, taken from the stack
+#endif
+
+#ifndef BINLOG_MAX_STRING
+#define BINLOG_MAX_STRING       (16)        // max characters stored for %s argument
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern uint16_t binlog_dropped;             // records dropped, not yet reported
+
+/**
+ * Set the ring buffer, must be called before logging
+ *
+ * @param pBuffer   ring buffer
+ * @param nSize     size of ring buffer
+ */
+extern void binlog_init(uint8_t *pBuffer, uint16_t nSize);
+
+/**
+ * Log a printf_P() call, same signature as avr-libc printf_P()
+ *
+ * @return  number of bytes stored, 0 if dropped
+ */
+extern int binlog_printf_P(const char *fmt, ...);
+
+/**
+ * Log a puts_P() call, same signature as avr-libc puts_P()
+ *
+ * @return  number of bytes stored, 0 if dropped
+ */
+extern int binlog_puts_P(const char *str);
+
+/**
+ * @return  number of bytes available to read
+ */
+extern uint16_t binlog_count(void);
+
+/**
+ * Read next byte, only call if binlog_count() is not 0
+ */
+extern uint8_t binlog_get(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //SCHEDULER_BINLOG_H
@@ -0,0 +1,23 @@
+#include "BinLogWriter.h"
+
+#ifndef CONSOLE_DEBUG
+
+void BinLogWriter::begin() {
+    setFlags(TASK_DBG_FLAGS_NO_SCHED);
+    resumeMicros(0);
+}
+
+void BinLogWriter::loop() {
+    uint16_t count = binlog_count();
+    int room = pSerial->availableForWrite();
+
+    while (count && room > 0) {
+        pSerial->write(binlog_get());
+        count--;
+        room--;
+    }
+
+    resumeMicros(BINLOG_WRITER_INTERVAL_MICROS);
+}
+
+#endif // CONSOLE_DEBUG
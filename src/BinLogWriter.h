@@ -0,0 +1,43 @@
+#ifndef SCHEDULER_BINLOGWRITER_H
+#define SCHEDULER_BINLOGWRITER_H
+
+#include "Arduino.h"
+#include "Scheduler.h"
+#include "BinLog.h"
+
+#ifndef CONSOLE_DEBUG
+
+#ifndef BINLOG_WRITER_INTERVAL_MICROS
+#define BINLOG_WRITER_INTERVAL_MICROS   (1000UL)    // 1ms is ~11 bytes at 115200 baud, HardwareSerial buffers the rest
+#endif
+
+/**
+ * Streams BinLog ring buffer to the serial port, only writes as many bytes as fit into the serial transmit buffer so
+ * it never blocks. Decode the output with tools/binlog_decode.py.
+ *
+ * Usage:
+ *
+ *     uint8_t binLogBuffer[256];
+ *     BinLogWriter binLogWriter(Serial);
+ *
+ *     // in setup(), before scheduler.begin()
+ *     binlog_init(binLogBuffer, sizeof(binLogBuffer));
+ */
+class BinLogWriter : public Task {
+    HardwareSerial *pSerial;
+
+public:
+    explicit BinLogWriter(HardwareSerial &serial) : Task() {
+        pSerial = &serial;
+    }
+
+    void begin() override;
+
+    void loop() override;
+
+    defineSchedulerTaskId("BinLogWriter");
+};
+
+#endif // CONSOLE_DEBUG
+
+#endif //SCHEDULER_BINLOGWRITER_H
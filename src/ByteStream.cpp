@@ -14,6 +14,7 @@ ByteStream::ByteStream(ByteQueue *pByteQueue, uint8_t streamFlags) : ByteQueue(*
 
     nRdSize = 0;
     pRdData = NULL;
+    error = 0;
 }
 
 void ByteStream::reset() {
@@ -29,6 +30,7 @@ void ByteStream::reset() {
 
     nRdSize = 0;
     pRdData = NULL;
+    error = 0;
 }
 
 uint8_t ByteStream::setFlags(uint8_t flags, uint8_t mask) {
@@ -183,6 +185,7 @@ void ByteStream::getStream(ByteStream *pOther, uint8_t rdWrFlags) {
     pOther->fCallback = fCallback;
     pOther->nRdSize = nRdSize;
     pOther->pRdData = pRdData;
+    pOther->error = 0;
 #ifdef SERIAL_DEBUG_TWI_REQ_TIMING
     pOther->startTime = startTime;
 #endif
@@ -191,6 +194,7 @@ void ByteStream::getStream(ByteStream *pOther, uint8_t rdWrFlags) {
     fCallback = NULL;
     nRdSize = 0;
     pRdData = NULL;
+    error = 0;
 #ifdef SERIAL_DEBUG_TWI_REQ_TIMING
     startTime = 0;
 #endif
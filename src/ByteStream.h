@@ -33,6 +33,7 @@ struct ByteStream : protected ByteQueue {
 
     uint8_t nRdSize;
     uint8_t *pRdData;
+    uint8_t error;                          // error code of the completed request, 0 if none, e.g. TWI_ERR_*
     // IMPORTANT: above fields must be the same as in CByteStream
 
 public:
@@ -91,6 +92,11 @@ public:
 
     NO_DISCARD inline uint8_t isUnprocessed() const { return getFlags(STREAM_FLAGS_UNPROCESSED); }
 
+    /**
+     * Error of the completed request, valid in the completion callback and until the controller recycles the stream
+     */
+    NO_DISCARD inline uint8_t getError() const { return error; }
+
     void getStream(ByteStream *pOther, uint8_t rdWrFlags);
 
     /**
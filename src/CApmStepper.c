@@ -61,28 +61,7 @@ void capm_step_ccw(CApmStepper_t *thizz) {
 }
 
 // micros per step for 28BYJ-48 motor, 32 steps/rev with 1:64 reduction, resulting in output of 2048 steps/rev
-const time_t rpmMicros[] PROGMEM = {
-        APM_STEPPER_MICROS_RPM(32, 1, 1),
-        APM_STEPPER_MICROS_RPM(32, 2, 1),
-        APM_STEPPER_MICROS_RPM(32, 3, 1),
-        APM_STEPPER_MICROS_RPM(32, 4, 1),
-        APM_STEPPER_MICROS_RPM(32, 5, 1),
-        APM_STEPPER_MICROS_RPM(32, 6, 1),
-        APM_STEPPER_MICROS_RPM(32, 7, 1),
-        APM_STEPPER_MICROS_RPM(32, 8, 1),
-        APM_STEPPER_MICROS_RPM(32, 9, 1),
-        APM_STEPPER_MICROS_RPM(32, 10, 1),
-        APM_STEPPER_MICROS_RPM(32, 11, 1),
-        APM_STEPPER_MICROS_RPM(32, 12, 1),
-        APM_STEPPER_MICROS_RPM(32, 13, 1),
-        APM_STEPPER_MICROS_RPM(32, 14, 1),
-        APM_STEPPER_MICROS_RPM(32, 15, 1),
-        APM_STEPPER_MICROS_RPM(32, 16, 1),
-        APM_STEPPER_MICROS_RPM(32, 17, 1),
-        APM_STEPPER_MICROS_RPM(32, 18, 1),
-        APM_STEPPER_MICROS_RPM(32, 19, 1),
-        APM_STEPPER_MICROS_RPM(32, 20, 1),
-};
+const time_t rpmMicros[] PROGMEM = APM_RPM_MICROS_TABLE(32);
 
 time_t raw_rpm_to_step_micros(uint8_t reduction, uint8_t rpm) {
     if (rpm > lengthof(rpmMicros)) {
@@ -99,9 +78,19 @@ time_t raw_rpm_to_step_micros(uint8_t reduction, uint8_t rpm) {
     return stepMicros;
 }
 
+time_t raw_table_rpm_to_step_micros(const time_t *pTable, uint8_t rpm) {
+    if (rpm > APM_RPM_TABLE_SIZE) {
+        rpm = APM_RPM_TABLE_SIZE;
+    } else if (!rpm) {
+        rpm = 1;
+    }
+    return pgm_read_dword(pTable + rpm - 1);
+}
+
 uint16_t raw_step_micros_to_rpmX10(uint8_t reduction, uint32_t stepMicros) {
-    uint16_t rpmX10 = APM_STEPPER_MICROS_RPM((uint16_t) reduction << 5, stepMicros, 10);
-    return rpmX10;
+    // one division, reduction * stepMicros fits for step micros up to 16 million
+    if (!reduction) reduction = 1;
+    return APM_STEPPER_RPMX10_MICROS(32) / (reduction * stepMicros);
 }
 
 time_t capm_rpm_to_step_micros(uint8_t reduction, uint8_t rpm) {
@@ -112,34 +101,39 @@ uint16_t capm_step_micros_to_rpmX10(uint8_t reduction, uint32_t stepMicros) {
     return raw_step_micros_to_rpmX10(reduction, stepMicros + 100);
 }
 
+time_t capm_plan_step_micros(CStepPlanner_t *pPlan) {
+    const time_t stepMicros = stp_next_interval(pPlan);
+    return stepMicros > 100 ? stepMicros - 100 : stepMicros;
+}
+
 #ifdef INCLUDE_DAC_MODULE
 // micros per step for 28BYJ-48 motor, 32 steps/rev with 1:64 reduction, resulting in output of 2048 steps/rev
 //minimal torque 4 rpm - 4.5v, 9 rpm - 5v, 13 rmp 5.5 v, 15 rmp 6 v, 16 rmp 6.5 v, 17 rmp 7 v, 18 rmp 7.3 v, 20 rmp 7.5 v
 
-// boost lookup voltage
+// boost lookup voltage, mV
 #define VM_ADD (0)
 const int16_t rpmVDac[] PROGMEM = {
         // minimalist
-        VM_TO_DAC_DATA(4.0 + VM_ADD), // 1
-        VM_TO_DAC_DATA(4.0 + VM_ADD), // 2
-        VM_TO_DAC_DATA(4.0 + VM_ADD), // 3
-        VM_TO_DAC_DATA(4.0 + VM_ADD), // 4
-        VM_TO_DAC_DATA(4.0 + VM_ADD), // 5
-        VM_TO_DAC_DATA(4.4 + VM_ADD), // 6
-        VM_TO_DAC_DATA(4.5 + VM_ADD), // 7
-        VM_TO_DAC_DATA(4.6 + VM_ADD), // 8
-        VM_TO_DAC_DATA(4.7 + VM_ADD), // 9
-        VM_TO_DAC_DATA(4.8 + VM_ADD), // 10
-        VM_TO_DAC_DATA(5.0 + VM_ADD), // 11
-        VM_TO_DAC_DATA(5.1 + VM_ADD), // 12
-        VM_TO_DAC_DATA(5.5 + VM_ADD), // 13
-        VM_TO_DAC_DATA(5.5 + VM_ADD), // 14
-        VM_TO_DAC_DATA(5.8 + VM_ADD), // 15
-        VM_TO_DAC_DATA(6.2 + VM_ADD), // 16
-        VM_TO_DAC_DATA(6.8 + VM_ADD), // 17
-        VM_TO_DAC_DATA(7.2 + VM_ADD), // 18
-        VM_TO_DAC_DATA(7.3 + VM_ADD), // 19
-        VM_TO_DAC_DATA(7.6 + VM_ADD), // 20
+        VM_MV_TO_DAC_DATA(4000 + VM_ADD), // 1
+        VM_MV_TO_DAC_DATA(4000 + VM_ADD), // 2
+        VM_MV_TO_DAC_DATA(4000 + VM_ADD), // 3
+        VM_MV_TO_DAC_DATA(4000 + VM_ADD), // 4
+        VM_MV_TO_DAC_DATA(4000 + VM_ADD), // 5
+        VM_MV_TO_DAC_DATA(4400 + VM_ADD), // 6
+        VM_MV_TO_DAC_DATA(4500 + VM_ADD), // 7
+        VM_MV_TO_DAC_DATA(4600 + VM_ADD), // 8
+        VM_MV_TO_DAC_DATA(4700 + VM_ADD), // 9
+        VM_MV_TO_DAC_DATA(4800 + VM_ADD), // 10
+        VM_MV_TO_DAC_DATA(5000 + VM_ADD), // 11
+        VM_MV_TO_DAC_DATA(5100 + VM_ADD), // 12
+        VM_MV_TO_DAC_DATA(5500 + VM_ADD), // 13
+        VM_MV_TO_DAC_DATA(5500 + VM_ADD), // 14
+        VM_MV_TO_DAC_DATA(5800 + VM_ADD), // 15
+        VM_MV_TO_DAC_DATA(6200 + VM_ADD), // 16
+        VM_MV_TO_DAC_DATA(6800 + VM_ADD), // 17
+        VM_MV_TO_DAC_DATA(7200 + VM_ADD), // 18
+        VM_MV_TO_DAC_DATA(7300 + VM_ADD), // 19
+        VM_MV_TO_DAC_DATA(7600 + VM_ADD), // 20
 };
 
 uint16_t capm_rpm_to_vdac(uint8_t rpm, int16_t vDacDelta) {
@@ -155,6 +149,23 @@ uint16_t capm_rpm_to_vdac(uint8_t rpm, int16_t vDacDelta) {
     return (uint16_t)vDac;
 }
 
+uint16_t capm_rpmX10_to_vdac(uint16_t rpmX10, int16_t vDacDelta) {
+    if (rpmX10 >= lengthof(rpmVDac) * 10) {
+        return capm_rpm_to_vdac(lengthof(rpmVDac), vDacDelta);
+    } else if (rpmX10 < 10) {
+        return capm_rpm_to_vdac(1, vDacDelta);
+    }
+
+    const uint8_t rpm = rpmX10 / 10;
+    const int16_t vDacLow = pgm_read_word(rpmVDac + rpm - 1);
+    const int16_t vDacHigh = pgm_read_word(rpmVDac + rpm);
+
+    int16_t vDac = vDacLow + (vDacHigh - vDacLow) * (int16_t) (rpmX10 - rpm * 10) / 10 - vDacDelta;
+    if (vDac < 0) vDac = 0;
+    if (vDac >= DAC_DATA_MAX) vDac = DAC_DATA_MAX-1;
+    return (uint16_t)vDac;
+}
+
 #endif //INCLUDE_DAC_MODULE
 
 #endif // INCLUDE_STP_MODULE
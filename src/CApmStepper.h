@@ -3,6 +3,7 @@
 #define ARDUINOPROJECTMODULE_CAPMSTEPPER_H
 
 #include "common_defs.h"
+#include "CStepPlanner.h"
 
 #define APM_FLAGS_STEPPER_PHASE         (0x03)
 
@@ -12,6 +13,23 @@
 #define APM_STEPPER_PHASE_MASK          (0x03)
 
 #define APM_STEPPER_MICROS_RPM(strev, rpm, scale)    ((60000000UL * (scale) / (strev) / (rpm)))
+#define APM_STEPPER_RPMX10_MICROS(strev)             (600000000UL / (strev))  // rpm x 10 * step micros
+
+#define APM_RPM_TABLE_SIZE      (20)
+
+// PROGMEM initializer of step micros for 1 to APM_RPM_TABLE_SIZE rpm of strev steps/rev, computed at compile time
+#define APM_RPM_MICROS_TABLE(strev) { \
+        APM_STEPPER_MICROS_RPM(strev, 1, 1), APM_STEPPER_MICROS_RPM(strev, 2, 1), \
+        APM_STEPPER_MICROS_RPM(strev, 3, 1), APM_STEPPER_MICROS_RPM(strev, 4, 1), \
+        APM_STEPPER_MICROS_RPM(strev, 5, 1), APM_STEPPER_MICROS_RPM(strev, 6, 1), \
+        APM_STEPPER_MICROS_RPM(strev, 7, 1), APM_STEPPER_MICROS_RPM(strev, 8, 1), \
+        APM_STEPPER_MICROS_RPM(strev, 9, 1), APM_STEPPER_MICROS_RPM(strev, 10, 1), \
+        APM_STEPPER_MICROS_RPM(strev, 11, 1), APM_STEPPER_MICROS_RPM(strev, 12, 1), \
+        APM_STEPPER_MICROS_RPM(strev, 13, 1), APM_STEPPER_MICROS_RPM(strev, 14, 1), \
+        APM_STEPPER_MICROS_RPM(strev, 15, 1), APM_STEPPER_MICROS_RPM(strev, 16, 1), \
+        APM_STEPPER_MICROS_RPM(strev, 17, 1), APM_STEPPER_MICROS_RPM(strev, 18, 1), \
+        APM_STEPPER_MICROS_RPM(strev, 19, 1), APM_STEPPER_MICROS_RPM(strev, 20, 1), \
+}
 
 #define APM_OUT_MOT_A1  (0x01)
 #define APM_OUT_MOT_B1  (0x02)
@@ -38,13 +56,16 @@ extern void capm_step_cw(CApmStepper_t *thizz);
 extern void capm_step_ccw(CApmStepper_t *thizz);
 
 extern time_t raw_rpm_to_step_micros(uint8_t reduction, uint8_t rpm);
+extern time_t raw_table_rpm_to_step_micros(const time_t *pTable, uint8_t rpm); // APM_RPM_MICROS_TABLE() lookup, no division
 extern uint16_t raw_step_micros_to_rpmX10(uint8_t reduction, uint32_t stepMicros);
 
 extern time_t capm_rpm_to_step_micros(uint8_t reduction, uint8_t rpm);
 extern uint16_t capm_step_micros_to_rpmX10(uint8_t reduction, uint32_t stepMicros);
+extern time_t capm_plan_step_micros(CStepPlanner_t *pPlan); // stp_next_interval() less capm_step() time
 
 #ifdef INCLUDE_DAC_MODULE
 extern uint16_t capm_rpm_to_vdac(uint8_t rpm, int16_t vDacDelta);
+extern uint16_t capm_rpmX10_to_vdac(uint16_t rpmX10, int16_t vDacDelta); // interpolated between rpm entries
 #endif
 
 #ifdef __cplusplus
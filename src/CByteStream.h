@@ -43,6 +43,7 @@ typedef struct CByteStream {
 
     uint8_t nRdSize;
     uint8_t *pRdData;
+    uint8_t error;                          // error code of the completed request, 0 if none, e.g. TWI_ERR_*
 } CByteStream_t;
 
 
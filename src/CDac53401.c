@@ -5,7 +5,7 @@
 #include "CTwiController.h"
 #include "twiint.h"
 
-CByteStream_t * dac_init(uint8_t addr) {
+CByteStream_t * dac_init(CController_t *pCtrl, uint8_t addr) {
     static const DacWriteEntry_t PROGMEM init1[] = {
             {REG_TRIGGER,        WR_TRIGGER_DEVICE_CONFIG_RESET(1)},
             // {REG_GENERAL_CONFIG, WR_DAC_POWER(DAC_POWER_UP) | WR_GENERAL_CONFIG_REF_EN(DAC_VREF_VDD) /*| WR_GENERAL_CONFIG_DAC_SPAN(DAC_VREF_GAIN_1_5X)*/ },
@@ -13,64 +13,76 @@ CByteStream_t * dac_init(uint8_t addr) {
             {REG_DATA,           WR_DATA_DAC(DATA_DAC_MAX)}, // output max so VM voltage is min
     };
 
-    CByteStream_t *pStream = dac_send_byte_list(addr, init1, sizeof(init1));
+    CByteStream_t *pStream = dac_send_byte_list(pCtrl, addr, init1, sizeof(init1));
     return pStream;
 }
 
-CByteStream_t *dac_power_up(uint8_t addr) {
-    return dac_write(addr, REG_GENERAL_CONFIG, WR_DAC_POWER(DAC_POWER_UP) | WR_GENERAL_CONFIG_REF_EN(DAC_VREF_EN) | WR_GENERAL_CONFIG_DAC_SPAN(DAC_SPAN_VREF_GAIN_4X));
+CByteStream_t *dac_power_up(CController_t *pCtrl, uint8_t addr) {
+    return dac_write(pCtrl, addr, REG_GENERAL_CONFIG, WR_DAC_POWER(DAC_POWER_UP) | WR_GENERAL_CONFIG_REF_EN(DAC_VREF_EN) | WR_GENERAL_CONFIG_DAC_SPAN(DAC_SPAN_VREF_GAIN_4X));
 
 }
 
-CByteStream_t *dac_power_down(uint8_t addr) {
-    return dac_write(addr, REG_GENERAL_CONFIG, WR_DAC_POWER(DAC_POWER_DN_HI_Z) | WR_GENERAL_CONFIG_REF_EN(DAC_VREF_EN) | WR_GENERAL_CONFIG_DAC_SPAN(DAC_SPAN_VREF_GAIN_4X));
+CByteStream_t *dac_power_down(CController_t *pCtrl, uint8_t addr) {
+    return dac_write(pCtrl, addr, REG_GENERAL_CONFIG, WR_DAC_POWER(DAC_POWER_DN_HI_Z) | WR_GENERAL_CONFIG_REF_EN(DAC_VREF_EN) | WR_GENERAL_CONFIG_DAC_SPAN(DAC_SPAN_VREF_GAIN_4X));
 }
 
-CByteStream_t *dac_send_byte_list(uint8_t addr, const uint8_t *bytes, uint16_t count) {
+CByteStream_t *dac_send_byte_list(CController_t *pCtrl, uint8_t addr, const uint8_t *bytes, uint16_t count) {
     CByteStream_t *pStream = NULL;
 
     while (count >= 3) {
         uint8_t reg = pgm_read_byte(bytes++);
         uint16_t val = pgm_read_word(bytes++);
-        pStream = dac_write(addr, reg, val);
+        pStream = dac_write(pCtrl, addr, reg, val);
         bytes++;
         count -= 3;
     }
     return pStream;
 }
 
-CByteStream_t *dac_write(uint8_t addr, uint8_t reg, uint16_t value) {
-    twiStream = twi_get_write_buffer(TWI_ADDRESS_W(addr));
-    stream_put(twiStream, reg);
-    stream_put(twiStream, (value & 0xff00) >> 8);
-    stream_put(twiStream, (value & 0x00ff));
-    return twi_process_stream();
+CByteStream_t *dac_write(CController_t *pCtrl, uint8_t addr, uint8_t reg, uint16_t value) {
+    CByteStream_t *pStream = twi_get_write_buffer(pCtrl, TWI_ADDRESS_W(addr));
+    stream_put(pStream, reg);
+    stream_put(pStream, (value & 0xff00) >> 8);
+    stream_put(pStream, (value & 0x00ff));
+    return twi_process_stream(pCtrl);
 }
 
-CByteStream_t *dac_write_read(uint8_t addr, uint8_t reg, uint16_t value, uint16_t *pValue) {
-    twiStream = twi_get_write_buffer(TWI_ADDRESS_W(addr));
-    stream_put(twiStream, reg);
-    stream_put(twiStream, (value & 0xff00) >> 8);
-    stream_put(twiStream, (value & 0x00ff));
+CByteStream_t *dac_write_read(CController_t *pCtrl, uint8_t addr, uint8_t reg, uint16_t value, uint16_t *pValue) {
+    CByteStream_t *pStream = twi_get_write_buffer(pCtrl, TWI_ADDRESS_W(addr));
+    stream_put(pStream, reg);
+    stream_put(pStream, (value & 0xff00) >> 8);
+    stream_put(pStream, (value & 0x00ff));
 
     // CAVEAT: reverse flag is needed if the CPU is little endian, while the dac is bigendian
-    twi_set_rd_buffer(1, pValue, sizeof(*pValue));
+    twi_set_rd_buffer(pCtrl, 1, pValue, sizeof(*pValue));
 
-    return twi_process_stream();
+    return twi_process_stream(pCtrl);
 }
 
-CByteStream_t *dac_read(uint8_t addr, uint8_t reg, uint16_t *pValue) {
-    twiStream = twi_get_write_buffer(TWI_ADDRESS_W(addr));
-    stream_put(twiStream, reg);
+CByteStream_t *dac_read(CController_t *pCtrl, uint8_t addr, uint8_t reg, uint16_t *pValue) {
+    CByteStream_t *pStream = twi_get_write_buffer(pCtrl, TWI_ADDRESS_W(addr));
+    stream_put(pStream, reg);
 
     // CAVEAT: reverse flag is needed if the CPU is little endian, while the dac is bigendian
-    twi_set_rd_buffer(1, pValue, sizeof(*pValue));
+    twi_set_rd_buffer(pCtrl, 1, pValue, sizeof(*pValue));
 
-    return twi_process_stream();
+    return twi_process_stream(pCtrl);
 }
 
-CByteStream_t *dac_output(uint8_t addr, uint16_t value) {
-    return dac_write(addr, REG_DATA, WR_DATA_DAC(value));
+CByteStream_t *dac_output(CController_t *pCtrl, uint8_t addr, uint16_t value) {
+    return dac_write(pCtrl, addr, REG_DATA, WR_DATA_DAC(value));
+}
+
+static const uint8_t dac_shadow_regs[DAC_SHADOW_REGS] PROGMEM = {
+        REG_GENERAL_CONFIG, REG_MED_ALARM_CONFIG, REG_DATA, REG_MARGIN_HIGH, REG_MARGIN_LOW,
+};
+
+void dac_shadow_init(CRegShadow_t *pShadow, CController_t *pCtrl, uint8_t addr, uint8_t *pValues) {
+    rsh_init(pShadow, pCtrl, addr, dac_shadow_regs, DAC_SHADOW_REGS, 2, RSH_BURST_NONE, RSH_FLAGS_BIG_ENDIAN, pValues);
+}
+
+CByteStream_t *dac_shadow_output(CRegShadow_t *pShadow, uint16_t value) {
+    return rsh_write(pShadow, REG_DATA, WR_DATA_DAC(value));
 }
 
 #endif
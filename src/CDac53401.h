@@ -4,26 +4,44 @@
 #include <stddef.h>     //size_t type, NULL pointer
 #include <stdint.h>     //uint8_t type
 #include "CByteStream.h"
+#include "CTwiController.h"
 #include "CDac53401_cmd.h"
+#include "CRegShadow.h"
 
-// DAC computed values
+// DAC computed values, data = VOUT_A * vm + VOUT_B
 #define VOUT_A      (-134.912959381045)
 #define VOUT_B      (1616.85686653772)
 #define DAC_DATA_MAX            (1024)
-#define VM_TO_DAC_DATA_RAW(v)   ((int32_t)(VOUT_A * (double)(v) + VOUT_B + 0.5))
-#define VM_TO_DAC_DATA(v)       (VM_TO_DAC_DATA_RAW(v) >= DAC_DATA_MAX ? DAC_DATA_MAX-1 : VM_TO_DAC_DATA_RAW(v) < 0 ? 0: (uint16_t)VM_TO_DAC_DATA_RAW(v))
+
+#define DAC_SHADOW_REGS         (5)     // general and alarm config, data and margin registers, not trigger
+
+// integer fixed point of the above, mV in and out, no floating point at run time
+#define VOUT_A_MV_Q20           (-141466L)          // VOUT_A / 1000 * 2^20
+#define VOUT_B_Q20              (1695397306L)       // VOUT_B * 2^20
+#define DAC_VM0_MV_Q16          (785412551L)        // vm at data 0, -VOUT_B / VOUT_A * 1000 * 2^16
+#define DAC_MV_PER_DATA_Q16     (485765L)           // -1000 / VOUT_A * 2^16
+#define DAC_VM_MAX_MV           (11984)             // vm at data 0
+
+#define DAC_CONSTRAIN_DATA(d)   ((d) < 0 ? 0 : (d) >= DAC_DATA_MAX ? DAC_DATA_MAX-1 : (d))
+
+#define VM_MV_TO_DAC_DATA_RAW(mv)   ((VOUT_B_Q20 + VOUT_A_MV_Q20 * (int32_t) (mv) + (1L << 19)) >> 20)
+#define VM_MV_TO_DAC_DATA(mv)       ((uint16_t) ((mv) >= DAC_VM_MAX_MV ? 0 : DAC_CONSTRAIN_DATA(VM_MV_TO_DAC_DATA_RAW(mv))))
+#define DAC_DATA_TO_VM_MV(d)        ((uint16_t) ((DAC_VM0_MV_Q16 - DAC_MV_PER_DATA_Q16 * (int32_t) (d) + (1L << 15)) >> 16))
+
+// volts argument, only use with constants, which are folded at compile time
+#define VM_TO_DAC_DATA(v)       VM_MV_TO_DAC_DATA((int32_t) ((v) * 1000 + 0.5))
 #define DAC_DATA_TO_VM(d)       (((double)(d)-VOUT_B)/VOUT_A)
-#define DAC_DATA_TO_VM_MV(d)    ((uint16_t)(DAC_DATA_TO_VM(d)*1000+.5))
 
-#define DAC_DATA_TO_VM_MV_ONLY(d)   ((uint16_t)(DAC_DATA_TO_VM(d)*1000 +.5) % 1000)
-#define DAC_DATA_TO_VM_V_ONLY(d)    ((uint16_t)(DAC_DATA_TO_VM(d)*1000 +.5) / 1000)
+#define DAC_DATA_TO_VM_MV_ONLY(d)   (DAC_DATA_TO_VM_MV(d) % 1000)
+#define DAC_DATA_TO_VM_V_ONLY(d)    (DAC_DATA_TO_VM_MV(d) / 1000)
 
 #define VM_MIN                  (DAC_DATA_TO_VM_MV(1023))
 #define VM_MAZ                  (DAC_DATA_TO_VM_MV(0))
 #define DAC_VREF                (1.21f)
+#define DAC_VREF_MV             (1210)
 
 #define DAC_DATA_TO_VDAC_MV(d,vr)      ((uint16_t)((vr)*(d)*1000/DAC_DATA_MAX))
-#define DAC_DATA_TO_VDAC_VREFX4_MV(d)  (DAC_DATA_TO_VDAC_MV(d, DAC_VREF*4))
+#define DAC_DATA_TO_VDAC_VREFX4_MV(d)  ((uint16_t) (((uint32_t) (d) * (DAC_VREF_MV * 4)) >> 10))
 
 #define WR_DAC_POWER(v)          WR_GENERAL_CONFIG_DAC_PDN(v)
 #define RD_DAC_POWER(v)          RD_GENERAL_CONFIG_DAC_PDN(v)
@@ -34,8 +52,7 @@
 #define DAC_POWER_DN_10K2       (WR_DAC_POWER(DAC_PDN_10K_2))
 #define DAC_POWER(f)            (RD_DAC_POWER(f))
 
-#define DAC_DATA_1V_DELTA       ((VM_TO_DAC_DATA(5) - VM_TO_DAC_DATA(10)) / 5)
-#define DAC_CONSTRAIN_DATA(d)   ((d) < 0 ? 0 : (d) >= DAC_DATA_MAX ? DAC_DATA_MAX-1 : (d))
+#define DAC_DATA_1V_DELTA       ((VM_MV_TO_DAC_DATA(5000) - VM_MV_TO_DAC_DATA(10000)) / 5)
 
 // define 3 bytes for entry: register, MSB value, LSZB value
 // this one is if the bytes are sent as defined
@@ -52,15 +69,15 @@ extern "C" {
 #endif
 
 // count must be multiple of 3, only full 3 bytes are sent, if last entry is short it is ignored
-extern CByteStream_t *dac_send_byte_list(uint8_t addr, const uint8_t *bytes, uint16_t count);
+extern CByteStream_t *dac_send_byte_list(CController_t *pCtrl, uint8_t addr, const uint8_t *bytes, uint16_t count);
 
-extern CByteStream_t * dac_init(uint8_t addr);
-extern CByteStream_t *dac_power_up(uint8_t addr);
-extern CByteStream_t *dac_power_down(uint8_t addr);
-extern CByteStream_t *dac_output(uint8_t addr, uint16_t value);
-extern CByteStream_t *dac_write(uint8_t addr, uint8_t reg, uint16_t value);
+extern CByteStream_t * dac_init(CController_t *pCtrl, uint8_t addr);
+extern CByteStream_t *dac_power_up(CController_t *pCtrl, uint8_t addr);
+extern CByteStream_t *dac_power_down(CController_t *pCtrl, uint8_t addr);
+extern CByteStream_t *dac_output(CController_t *pCtrl, uint8_t addr, uint16_t value);
+extern CByteStream_t *dac_write(CController_t *pCtrl, uint8_t addr, uint8_t reg, uint16_t value);
 
-extern CByteStream_t *dac_write_read(uint8_t addr, uint8_t reg, uint16_t value, uint16_t *pValue);
+extern CByteStream_t *dac_write_read(CController_t *pCtrl, uint8_t addr, uint8_t reg, uint16_t value, uint16_t *pValue);
 /**
  * Write a value to a register then read in the value from the register.
  *
@@ -70,7 +87,11 @@ extern CByteStream_t *dac_write_read(uint8_t addr, uint8_t reg, uint16_t value,
  * @param pValue
  * @return 1 if value read, 0 if timed out (50ms) waiting for twi stream to process
  */
-extern CByteStream_t *dac_read(uint8_t addr, uint8_t reg, uint16_t *pValue);
+extern CByteStream_t *dac_read(CController_t *pCtrl, uint8_t addr, uint8_t reg, uint16_t *pValue);
+
+// register shadow of a DAC, pValues has sizeOfRegShadowValues(DAC_SHADOW_REGS, 2) bytes, invalidate after dac_init()
+extern void dac_shadow_init(CRegShadow_t *pShadow, CController_t *pCtrl, uint8_t addr, uint8_t *pValues);
+extern CByteStream_t *dac_shadow_output(CRegShadow_t *pShadow, uint16_t value); // dac_output() if changed
 
 #ifdef __cplusplus
 };
@@ -5,60 +5,85 @@
 #include "twiint.h"
 #include "CApmStepper.h"
 
-void iox_prep_write(uint8_t addr, uint8_t reg) {
-    twi_get_write_buffer(TWI_ADDRESS_W(addr));
-    stream_put(twiStream, reg);
+CByteStream_t *iox_prep_write(CController_t *pCtrl, uint8_t addr, uint8_t reg) {
+    CByteStream_t *pStream = twi_get_write_buffer(pCtrl, TWI_ADDRESS_W(addr));
+    stream_put(pStream, reg);
+    return pStream;
 }
 
-CByteStream_t *iox_send_word(uint8_t addr, uint8_t reg, uint16_t data) {
-    iox_prep_write(addr, reg);
-    stream_put(twiStream, (data & 0x00ff));
-    stream_put(twiStream, (data >> 8) & 0x00ff);
-    return twi_process(twiStream);
+CByteStream_t *iox_send_word(CController_t *pCtrl, uint8_t addr, uint8_t reg, uint16_t data) {
+    CByteStream_t *pStream = iox_prep_write(pCtrl, addr, reg);
+    stream_put(pStream, (data & 0x00ff));
+    stream_put(pStream, (data >> 8) & 0x00ff);
+    return twi_process(pCtrl, pStream);
 }
 
-CByteStream_t *iox_send_byte(uint8_t addr, uint8_t reg, uint8_t data) {
-    iox_prep_write(addr, reg);
-    stream_put(twiStream, data);
-    return twi_process(twiStream);
+CByteStream_t *iox_send_byte(CController_t *pCtrl, uint8_t addr, uint8_t reg, uint8_t data) {
+    CByteStream_t *pStream = iox_prep_write(pCtrl, addr, reg);
+    stream_put(pStream, data);
+    return twi_process(pCtrl, pStream);
 }
 
-CByteStream_t *iox_rcv_data(uint8_t addr, uint8_t reg, void *pData, uint8_t len) {
-    iox_prep_write(addr, reg);
-    twi_set_rd_buffer(0, pData, len);
-    return twi_process(twiStream);
+CByteStream_t *iox_rcv_data(CController_t *pCtrl, uint8_t addr, uint8_t reg, void *pData, uint8_t len) {
+    CByteStream_t *pStream = iox_prep_write(pCtrl, addr, reg);
+    twi_set_rd_buffer(pCtrl, 0, pData, len);
+    return twi_process(pCtrl, pStream);
 }
 
-uint8_t iox_rcv_data_wait(uint8_t addr, uint8_t reg, void *pData, uint8_t len) {
-    CByteStream_t *pStream = iox_rcv_data(addr, reg, pData, len);
-    return twi_wait_sent(pStream);
+uint8_t iox_rcv_data_wait(CController_t *pCtrl, uint8_t addr, uint8_t reg, void *pData, uint8_t len) {
+    CByteStream_t *pStream = iox_rcv_data(pCtrl, addr, reg, pData, len);
+    return twi_wait_sent(pCtrl, pStream);
 }
 
-CByteStream_t *iox_rcv_byte(uint8_t addr, uint8_t reg, uint8_t *pData) {
-    return iox_rcv_data(addr, reg, pData, 1);
+CByteStream_t *iox_rcv_byte(CController_t *pCtrl, uint8_t addr, uint8_t reg, uint8_t *pData) {
+    return iox_rcv_data(pCtrl, addr, reg, pData, 1);
 }
 
-uint8_t iox_rcv_byte_wait(uint8_t addr, uint8_t reg, uint8_t *pData) {
-    return iox_rcv_data_wait(addr, reg, pData, 1);
+uint8_t iox_rcv_byte_wait(CController_t *pCtrl, uint8_t addr, uint8_t reg, uint8_t *pData) {
+    return iox_rcv_data_wait(pCtrl, addr, reg, pData, 1);
 }
 
-CByteStream_t *iox_rcv_word(uint8_t addr, uint8_t reg, uint16_t *pData) {
-    return iox_rcv_data(addr, reg, pData, 2);
+CByteStream_t *iox_rcv_word(CController_t *pCtrl, uint8_t addr, uint8_t reg, uint16_t *pData) {
+    return iox_rcv_data(pCtrl, addr, reg, pData, 2);
 }
 
-uint8_t iox_rcv_word_wait(uint8_t addr, uint8_t reg, uint16_t *pData) {
-    return iox_rcv_data_wait(addr, reg, pData, 2);
+uint8_t iox_rcv_word_wait(CController_t *pCtrl, uint8_t addr, uint8_t reg, uint16_t *pData) {
+    return iox_rcv_data_wait(pCtrl, addr, reg, pData, 2);
 }
 
 // IOX Tilt Tower Module
-CByteStream_t *ciox_init(CIOExpander_t *thizz, uint8_t addressVar, uint8_t extraOutputs) {
+CByteStream_t *ciox_init(CIOExpander_t *thizz, CController_t *pCtrl, uint8_t addressVar, uint8_t extraOutputs) {
+    thizz->pCtrl = pCtrl;
     thizz->flags = (addressVar & IOX_FLAGS_ADDRESS) | IOX_FLAGS_STEPPER_PHASE;
     thizz->outputs = 0x00;
     thizz->inputs = 0xff;
     thizz->lastInputs = 0x00;
     thizz->stepStartTick = 0;
+    thizz->stepEndTick = 0;
+    thizz->stepPeriod = 0;
+    thizz->stepLatency = 0;
+    thizz->stepInterval = 0;
+    thizz->stepError = 0;
+    thizz->stepCorrection = 0;
     thizz->fStepCallback = NULL;
-    return iox_init(IOX_I2C_ADDRESS(thizz->flags & IOX_FLAGS_ADDRESS), TILT_CONFIGURATION, extraOutputs | TILT_INVERT_OUT);
+    thizz->fInCallback = NULL;
+    return iox_init(thizz->pCtrl, IOX_I2C_ADDRESS(thizz->flags & IOX_FLAGS_ADDRESS), TILT_CONFIGURATION, extraOutputs | TILT_INVERT_OUT);
+}
+
+// output write failed, make lastOutputs differ so the next ciox_update() writes them again
+static void ciox_invalidate_outputs(const CByteStream_t *pStream, CIOExpander_t *pIox) {
+    if (pStream->error) {
+        pIox->lastOutputs = ~pIox->outputs;
+    }
+}
+
+// callback to IOX when output update request is complete
+static void ciox_update_callback(const CByteStream_t *pStream) {
+    CIOExpander_t *pIox = (CIOExpander_t *) pStream->pCallbackParam;
+
+    if (pIox) {
+        ciox_invalidate_outputs(pStream, pIox);
+    }
 }
 
 void ciox_update(CIOExpander_t *thizz) {
@@ -70,7 +95,11 @@ void ciox_update(CIOExpander_t *thizz) {
         // update it right away since there may not be any stepping for a while.
         thizz->lastOutputs = thizz->outputs;
 
-        iox_send_byte(IOX_I2C_ADDRESS(thizz->flags & IOX_FLAGS_ADDRESS), IOX_REG_OUTPUT_PORT0, thizz->outputs);
+        CByteStream_t *pStream = iox_prep_write(thizz->pCtrl, IOX_I2C_ADDRESS(thizz->flags & IOX_FLAGS_ADDRESS), IOX_REG_OUTPUT_PORT0);
+        stream_put(pStream, thizz->outputs);
+        pStream->fCallback = ciox_update_callback;
+        pStream->pCallbackParam = thizz;
+        twi_process(thizz->pCtrl, pStream);
     }
     SEI();
 }
@@ -96,12 +125,46 @@ void ciox_stepper_power(CIOExpander_t *thizz, uint8_t enable) {
     }
 }
 
+// measure step request latency and step to step interval error at step completion
+static void ciox_step_measure(CIOExpander_t *thizz) {
+    const time_t now = sched_micros();
+    const time_t latency = now - thizz->stepStartTick;
+
+    if (thizz->stepLatency) {
+        thizz->stepLatency += ((int32_t) latency - thizz->stepLatency) >> IOX_STEP_AVERAGE_SHIFT;
+    } else {
+        thizz->stepLatency = latency;
+    }
+
+    if (thizz->stepEndTick && thizz->stepPeriod) {
+        const time_t interval = now - thizz->stepEndTick;
+
+        // longer gaps are stops, not step timing
+        if (interval < thizz->stepPeriod * 2) {
+            if (thizz->stepInterval) {
+                thizz->stepInterval += ((int32_t) (interval - thizz->stepInterval)) >> IOX_STEP_AVERAGE_SHIFT;
+            } else {
+                thizz->stepInterval = interval;
+            }
+
+            thizz->stepError = interval - thizz->stepPeriod;
+
+            const int32_t correction = (int32_t) thizz->stepCorrection + (thizz->stepError >> IOX_STEP_GAIN_SHIFT);
+            thizz->stepCorrection = correction > INT16_MAX ? INT16_MAX : correction < INT16_MIN ? INT16_MIN : correction;
+        }
+    }
+
+    thizz->stepEndTick = now;
+}
+
 // callback to IOX when step request is complete
 void ciox_step_callback(const CByteStream_t *pStream) {
     CIOExpander_t *pIox = (CIOExpander_t *) pStream->pCallbackParam;
 
     if (pIox) {
         pIox->flags &= ~IOX_FLAGS_STEPPING;
+        ciox_invalidate_outputs(pStream, pIox);
+        ciox_step_measure(pIox);
 
         if (pIox->fStepCallback) {
             pIox->fStepCallback(pStream, pIox);
@@ -127,7 +190,7 @@ const uint8_t ciox_stepper_phases[] PROGMEM = {
         IOX_OUT_MOT_A1 | IOX_OUT_MOT_B2, // 1  0  0  1
 };
 
-CByteStream_t *ciox_step(CIOExpander_t *thizz, uint8_t ccwDir) {
+uint8_t ciox_next_phase(CIOExpander_t *thizz, uint8_t ccwDir) {
     uint8_t phase = IOX_FLAGS_TO_STEPPER_PHASE(thizz->flags);
     if (ccwDir) {
         phase--;
@@ -135,24 +198,34 @@ CByteStream_t *ciox_step(CIOExpander_t *thizz, uint8_t ccwDir) {
         phase++;
     }
     phase &= IOX_STEPPER_PHASE_MASK;
-    uint8_t motOut = pgm_read_byte(ciox_stepper_phases + phase);
 
-    // enable motor output by default
     thizz->flags &= ~IOX_FLAGS_STEPPER_PHASE;
+    thizz->flags |= IOX_STEPPER_PHASE_TO_FLAGS(phase);
+    return pgm_read_byte(ciox_stepper_phases + phase) & IOX_OUT_MOT_PHASES;
+}
 
-    thizz->flags |= IOX_STEPPER_PHASE_TO_FLAGS(phase) | IOX_FLAGS_STEPPING;
-    thizz->outputs &= ~IOX_OUT_MOT_PHASES;
-    thizz->outputs |= (motOut & IOX_OUT_MOT_PHASES) | IOX_OUT_MOT_EN;
+CByteStream_t *ciox_step(CIOExpander_t *thizz, uint8_t ccwDir) {
+    uint8_t motOut = ciox_next_phase(thizz, ccwDir);
 
-    iox_prep_write(IOX_I2C_ADDRESS(thizz->flags & IOX_FLAGS_ADDRESS), IOX_REG_OUTPUT_PORT0);
-    stream_put(twiStream, thizz->outputs);
+    // enable motor output by default
+    return ciox_step_outputs(thizz, IOX_OUT_MOT_PHASES, motOut | IOX_OUT_MOT_EN);
+}
 
-    twiStream->fCallback = ciox_step_callback;
-    twiStream->pCallbackParam = thizz;
+CByteStream_t *ciox_step_outputs(CIOExpander_t *thizz, uint8_t phaseMask, uint8_t phaseOutputs) {
+    thizz->flags |= IOX_FLAGS_STEPPING;
+    thizz->stepStartTick = sched_micros();
+    thizz->outputs &= ~phaseMask;
+    thizz->outputs |= phaseOutputs;
+
+    CByteStream_t *pStream = iox_prep_write(thizz->pCtrl, IOX_I2C_ADDRESS(thizz->flags & IOX_FLAGS_ADDRESS), IOX_REG_OUTPUT_PORT0);
+    stream_put(pStream, thizz->outputs);
+
+    pStream->fCallback = ciox_step_callback;
+    pStream->pCallbackParam = thizz;
 
     // these diffs have been sent
     thizz->lastOutputs = thizz->outputs;
-    return twi_process(twiStream);
+    return twi_process(thizz->pCtrl, pStream);
 }
 
 CByteStream_t *ciox_step_cw(CIOExpander_t *thizz) {
@@ -164,11 +237,43 @@ CByteStream_t *ciox_step_ccw(CIOExpander_t *thizz) {
 }
 
 time_t ciox_rpm_to_step_micros(uint8_t reduction, uint8_t rpm) {
-    return raw_rpm_to_step_micros(reduction, rpm) - 300;
+    return raw_rpm_to_step_micros(reduction, rpm) - IOX_STEP_LATENCY_MICROS;
 }
 
 uint16_t ciox_step_micros_to_rpmX10(uint8_t reduction, uint32_t stepMicros) {
-    return raw_step_micros_to_rpmX10(reduction, stepMicros + 300);
+    return raw_step_micros_to_rpmX10(reduction, stepMicros + IOX_STEP_LATENCY_MICROS);
+}
+
+time_t ciox_plan_step_micros(CIOExpander_t *thizz, CStepPlanner_t *pPlan) {
+    const time_t stepMicros = stp_next_interval(pPlan);
+    return stepMicros ? ciox_step_delay_micros(thizz, stepMicros) : 0;
+}
+
+time_t ciox_step_delay_micros(CIOExpander_t *thizz, time_t stepMicros) {
+    CLI();
+    thizz->stepPeriod = stepMicros;
+    // signed, time_t is unsigned and latency can exceed the step period
+    const int32_t delay = (int32_t) stepMicros - (int32_t) ciox_step_latency(thizz) - thizz->stepCorrection;
+    SEI();
+    return delay > 0 ? (time_t) delay : 0;
+}
+
+uint16_t ciox_step_latency(const CIOExpander_t *thizz) {
+    return thizz->stepLatency ? thizz->stepLatency : IOX_STEP_LATENCY_MICROS;
+}
+
+uint16_t ciox_step_rpmX10(const CIOExpander_t *thizz, uint8_t reduction) {
+    return thizz->stepInterval ? raw_step_micros_to_rpmX10(reduction, thizz->stepInterval) : 0;
+}
+
+void ciox_step_reset(CIOExpander_t *thizz) {
+    CLI();
+    thizz->stepEndTick = 0;
+    thizz->stepPeriod = 0;
+    thizz->stepInterval = 0;
+    thizz->stepError = 0;
+    thizz->stepCorrection = 0;
+    SEI();
 }
 
 #endif // INCLUDE_STP_MODULE
@@ -178,43 +283,72 @@ void ciox_in_callback(const CByteStream_t *pStream) {
     CIOExpander_t *pIox = (CIOExpander_t *) pStream->pCallbackParam;
 
     if (pIox) {
-        pIox->flags |= IOX_FLAGS_VALID_INPUTS | IOX_FLAGS_LATEST_INPUTS;
+        // failed read, inputs are not valid, fInCallback checks the error
+        if (!pStream->error) {
+            pIox->flags |= IOX_FLAGS_VALID_INPUTS | IOX_FLAGS_LATEST_INPUTS;
+        }
+
+        if (pIox->fInCallback) {
+            pIox->fInCallback(pStream, pIox);
+        }
     }
 }
 
 CByteStream_t *ciox_in(CIOExpander_t *thizz) {
-    twi_fresh_stream();
-    twiStream->fCallback = ciox_in_callback;
-    twiStream->pCallbackParam = thizz;
+    CByteStream_t *pWriteStream = twi_fresh_stream(thizz->pCtrl);
+    pWriteStream->fCallback = ciox_in_callback;
+    pWriteStream->pCallbackParam = thizz;
 
     // clear flag to signal pending input request
     thizz->flags &= ~IOX_FLAGS_LATEST_INPUTS;
 
-    CByteStream_t *pStream = iox_rcv_byte(IOX_I2C_ADDRESS(thizz->flags & IOX_FLAGS_ADDRESS), IOX_REG_INPUT_PORT1, &thizz->inputs);
+    CByteStream_t *pStream = iox_rcv_byte(thizz->pCtrl, IOX_I2C_ADDRESS(thizz->flags & IOX_FLAGS_ADDRESS), IOX_REG_INPUT_PORT1, &thizz->inputs);
     return pStream;
 }
 
-CByteStream_t *iox_init(uint8_t addr, uint16_t rw_config, uint16_t data) {
+CByteStream_t *iox_init(CController_t *pCtrl, uint8_t addr, uint16_t rw_config, uint16_t data) {
     // set the output value
-    iox_send_word(addr, IOX_REG_CONFIGURATION_PORT0, rw_config);
-    return iox_send_word(addr, IOX_REG_OUTPUT_PORT0, data);
+    iox_send_word(pCtrl, addr, IOX_REG_CONFIGURATION_PORT0, rw_config);
+    return iox_send_word(pCtrl, addr, IOX_REG_OUTPUT_PORT0, data);
+}
+
+CByteStream_t *iox_out(CController_t *pCtrl, uint8_t addr, uint16_t data) {
+    return iox_send_word(pCtrl, addr, IOX_REG_OUTPUT_PORT0, data);
 }
 
-CByteStream_t *iox_out(uint8_t addr, uint16_t data) {
-    return iox_send_word(addr, IOX_REG_OUTPUT_PORT0, data);
+uint8_t iox_out_wait(CController_t *pCtrl, uint8_t addr, uint16_t data) {
+    CByteStream_t *pStream = iox_send_word(pCtrl, addr, IOX_REG_OUTPUT_PORT0, data);
+    return twi_wait_sent(pCtrl, pStream);
 }
 
-uint8_t iox_out_wait(uint8_t addr, uint16_t data) {
-    CByteStream_t *pStream = iox_send_word(addr, IOX_REG_OUTPUT_PORT0, data);
-    return twi_wait_sent(pStream);
+CByteStream_t *iox_in(CController_t *pCtrl, uint8_t addr, uint16_t *pData) {
+    return iox_rcv_word(pCtrl, addr, IOX_REG_INPUT_PORT0, pData);
+}
+
+uint8_t iox_in_wait(CController_t *pCtrl, uint8_t addr, uint16_t *pData) {
+    return iox_rcv_word_wait(pCtrl, addr, IOX_REG_INPUT_PORT0, pData);
+}
+
+static const uint8_t iox_shadow_regs[IOX_SHADOW_REGS] PROGMEM = {
+        IOX_REG_OUTPUT_PORT0, IOX_REG_OUTPUT_PORT1,
+        IOX_REG_POLARITY_INVERSION_PORT0, IOX_REG_POLARITY_INVERSION_PORT1,
+        IOX_REG_CONFIGURATION_PORT0, IOX_REG_CONFIGURATION_PORT1,
+};
+
+void iox_shadow_init(CRegShadow_t *pShadow, CController_t *pCtrl, uint8_t addr, uint8_t *pValues) {
+    rsh_init(pShadow, pCtrl, addr, iox_shadow_regs, IOX_SHADOW_REGS, 1, RSH_BURST_PAIR, 0, pValues);
 }
 
-CByteStream_t *iox_in(uint8_t addr, uint16_t *pData) {
-    return iox_rcv_word(addr, IOX_REG_INPUT_PORT0, pData);
+CByteStream_t *iox_shadow_setup(CRegShadow_t *pShadow, uint16_t rw_config, uint16_t data) {
+    rsh_set(pShadow, IOX_REG_CONFIGURATION_PORT0, rw_config);
+    rsh_set(pShadow, IOX_REG_CONFIGURATION_PORT1, rw_config >> 8);
+    return iox_shadow_out(pShadow, data);
 }
 
-uint8_t iox_in_wait(uint8_t addr, uint16_t *pData) {
-    return iox_rcv_word_wait(addr, IOX_REG_INPUT_PORT0, pData);
+CByteStream_t *iox_shadow_out(CRegShadow_t *pShadow, uint16_t data) {
+    rsh_set(pShadow, IOX_REG_OUTPUT_PORT0, data);
+    rsh_set(pShadow, IOX_REG_OUTPUT_PORT1, data >> 8);
+    return rsh_flush(pShadow);
 }
 
 #endif
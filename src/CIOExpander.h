@@ -5,8 +5,11 @@
 #include <stddef.h>     //size_t type, NULL pointer
 #include <stdint.h>     //uint8_t type
 #include "CByteStream.h"
+#include "CTwiController.h"
 #include "CIOExpander_cmd.h"
 #include "tilt_tower_config.h"
+#include "CStepPlanner.h"
+#include "CRegShadow.h"
 
 #define IOX_OUT_MOT_B1          TILT_MOT_B1
 #define IOX_OUT_MOT_A1          TILT_MOT_A1
@@ -27,6 +30,8 @@
 
 #define IOX_I2C_ADDRESS(v)      (XL9535_BASE_ADDRESS | ((v) & 0x07))
 
+#define IOX_SHADOW_REGS         (6)      // output, polarity inversion and configuration port pairs
+
 #define IOX_FLAGS_ADDRESS       (0x07)
 #define IOX_FLAGS_VALID_INPUTS  (0x08)   // got input complete
 #define IOX_FLAGS_STEPPER_PHASE (0x30)
@@ -38,10 +43,18 @@
 
 #define IOX_STEPPER_PHASE_MASK (0x03)
 
+#ifndef IOX_STEP_LATENCY_MICROS
+#define IOX_STEP_LATENCY_MICROS (300)    // step request time used until one is measured
+#endif
+
+#define IOX_STEP_AVERAGE_SHIFT  (3)      // running averages of latency and interval over 8 steps
+#define IOX_STEP_GAIN_SHIFT     (2)      // 1/4 of interval error integrated per step
+
 struct CIOExpander;
 typedef void (*CIoxCallback_t)(const struct CByteStream *pStream, struct CIOExpander *pIox);
 
 typedef struct CIOExpander {
+    CController_t *pCtrl;           // controller of the bus the expander is on
     uint8_t flags;
     uint8_t outputs;
     uint8_t inputs;
@@ -49,7 +62,14 @@ typedef struct CIOExpander {
     uint8_t lastOutputs;
 
     time_t stepStartTick;           // micros of start of step
+    time_t stepEndTick;             // micros of completion of last step, 0 if none
+    time_t stepPeriod;              // target step period from ciox_step_delay_micros()
+    uint16_t stepLatency;           // running average of step request queue and bus time, 0 if none
+    time_t stepInterval;            // running average of step to step interval, 0 if none
+    int32_t stepError;              // last step to step interval less stepPeriod
+    int16_t stepCorrection;         // integrated stepError taken off step delays
     CIoxCallback_t fStepCallback;
+    CIoxCallback_t fInCallback;     // called from interrupt when ciox_in() read is done, NULL if none
 } CIOExpander_t;
 
 
@@ -57,34 +77,47 @@ typedef struct CIOExpander {
 extern "C" {
 #endif
 
-extern CByteStream_t *ciox_init(CIOExpander_t *thizz, uint8_t addressVar, uint8_t extraOutputs);
+extern CByteStream_t *ciox_init(CIOExpander_t *thizz, CController_t *pCtrl, uint8_t addressVar, uint8_t extraOutputs);
 extern void ciox_led_color(CIOExpander_t *thizz, uint8_t ledColor);
 
 #ifdef INCLUDE_STP_MODULE
 extern void ciox_stepper_power(CIOExpander_t *thizz, uint8_t enable);
 extern CByteStream_t *ciox_step(CIOExpander_t *thizz, uint8_t ccwDir);
+extern CByteStream_t *ciox_step_outputs(CIOExpander_t *thizz, uint8_t phaseMask, uint8_t phaseOutputs); // one write of phase outputs of all motors
+extern uint8_t ciox_next_phase(CIOExpander_t *thizz, uint8_t ccwDir); // advance phase, return its IOX_OUT_MOT_PHASES outputs
+extern void ciox_step_callback(const CByteStream_t *pStream); // step request completion, pCallbackParam is the CIOExpander_t
 extern CByteStream_t *ciox_step_cw(CIOExpander_t *thizz);
 extern CByteStream_t *ciox_step_ccw(CIOExpander_t *thizz);
 extern CByteStream_t *ciox_in(CIOExpander_t *thizz);
 extern time_t ciox_rpm_to_step_micros(uint8_t reduction, uint8_t rpm);
 extern uint16_t ciox_step_micros_to_rpmX10(uint8_t reduction, uint32_t stepMicros);
+extern time_t ciox_plan_step_micros(CIOExpander_t *thizz, CStepPlanner_t *pPlan); // ciox_step_delay_micros() of stp_next_interval()
+extern time_t ciox_step_delay_micros(CIOExpander_t *thizz, time_t stepMicros); // delay after step completion for step period
+extern uint16_t ciox_step_latency(const CIOExpander_t *thizz); // measured step request time
+extern uint16_t ciox_step_rpmX10(const CIOExpander_t *thizz, uint8_t reduction); // rpm of measured step interval
+extern void ciox_step_reset(CIOExpander_t *thizz); // reset step measurements, motor was stopped
 #endif // INCLUDE_STP_MODULE
 
-extern CByteStream_t *iox_init(uint8_t addr, uint16_t rw_config, uint16_t data);
-extern CByteStream_t *iox_send_word(uint8_t addr, uint8_t reg, uint16_t data);
-extern CByteStream_t *iox_send_byte(uint8_t addr, uint8_t reg, uint8_t data);
-
-extern CByteStream_t *iox_rcv_data(uint8_t addr, uint8_t reg, void *pData, uint8_t len);
-extern uint8_t iox_rcv_data_wait(uint8_t addr, uint8_t reg, void *pData, uint8_t len);
-extern CByteStream_t *iox_rcv_byte(uint8_t addr, uint8_t reg, uint8_t *pData);
-extern uint8_t iox_rcv_byte_wait(uint8_t addr, uint8_t reg, uint8_t *pData);
-extern CByteStream_t *iox_rcv_word(uint8_t addr, uint8_t reg, uint16_t *pData);
-extern uint8_t iox_rcv_word_wait(uint8_t addr, uint8_t reg, uint16_t *pData);
-
-extern CByteStream_t *iox_out(uint8_t addr, uint16_t data);
-extern uint8_t iox_out_wait(uint8_t addr, uint16_t data);
-extern CByteStream_t *iox_in(uint8_t addr, uint16_t *pData);
-extern uint8_t iox_in_wait(uint8_t addr, uint16_t *pData);
+extern CByteStream_t *iox_init(CController_t *pCtrl, uint8_t addr, uint16_t rw_config, uint16_t data);
+extern CByteStream_t *iox_send_word(CController_t *pCtrl, uint8_t addr, uint8_t reg, uint16_t data);
+extern CByteStream_t *iox_send_byte(CController_t *pCtrl, uint8_t addr, uint8_t reg, uint8_t data);
+
+extern CByteStream_t *iox_rcv_data(CController_t *pCtrl, uint8_t addr, uint8_t reg, void *pData, uint8_t len);
+extern uint8_t iox_rcv_data_wait(CController_t *pCtrl, uint8_t addr, uint8_t reg, void *pData, uint8_t len);
+extern CByteStream_t *iox_rcv_byte(CController_t *pCtrl, uint8_t addr, uint8_t reg, uint8_t *pData);
+extern uint8_t iox_rcv_byte_wait(CController_t *pCtrl, uint8_t addr, uint8_t reg, uint8_t *pData);
+extern CByteStream_t *iox_rcv_word(CController_t *pCtrl, uint8_t addr, uint8_t reg, uint16_t *pData);
+extern uint8_t iox_rcv_word_wait(CController_t *pCtrl, uint8_t addr, uint8_t reg, uint16_t *pData);
+
+extern CByteStream_t *iox_out(CController_t *pCtrl, uint8_t addr, uint16_t data);
+extern uint8_t iox_out_wait(CController_t *pCtrl, uint8_t addr, uint16_t data);
+extern CByteStream_t *iox_in(CController_t *pCtrl, uint8_t addr, uint16_t *pData);
+extern uint8_t iox_in_wait(CController_t *pCtrl, uint8_t addr, uint16_t *pData);
+
+// register shadow of an expander, pValues has IOX_SHADOW_REGS bytes, port pairs are written in one request
+extern void iox_shadow_init(CRegShadow_t *pShadow, CController_t *pCtrl, uint8_t addr, uint8_t *pValues);
+extern CByteStream_t *iox_shadow_setup(CRegShadow_t *pShadow, uint16_t rw_config, uint16_t data); // iox_init() of changed registers
+extern CByteStream_t *iox_shadow_out(CRegShadow_t *pShadow, uint16_t data); // iox_out() if changed
 
 
 #ifdef __cplusplus
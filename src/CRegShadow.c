@@ -0,0 +1,146 @@
+#include <Arduino.h>
+#include "CRegShadow.h"
+#include "twiint.h"
+
+void rsh_init(CRegShadow_t *thizz, CController_t *pCtrl, uint8_t addr, const uint8_t *pRegs, uint8_t nRegs, uint8_t width, uint8_t burstShift, uint8_t flags, uint8_t *pValues) {
+    thizz->pCtrl = pCtrl;
+    thizz->pRegs = pRegs;
+    thizz->pValues = pValues;
+    thizz->addr = addr;
+    thizz->nRegs = nRegs > RSH_MAX_REGS ? RSH_MAX_REGS : nRegs;
+    thizz->width = width;
+    thizz->burstShift = burstShift;
+    thizz->flags = flags;
+    thizz->setMask = 0;
+    thizz->validMask = 0;
+    thizz->dirtyMask = 0;
+    thizz->skipped = 0;
+}
+
+static uint8_t rsh_index(const CRegShadow_t *thizz, uint8_t reg) {
+    for (uint8_t i = 0; i < thizz->nRegs; i++) {
+        if (pgm_read_byte(thizz->pRegs + i) == reg) return i;
+    }
+    return NULL_BYTE;
+}
+
+static uint16_t rsh_value(const CRegShadow_t *thizz, uint8_t i) {
+    const uint8_t *pValue = thizz->pValues + i * thizz->width;
+    return thizz->width == 2 ? pValue[0] | (pValue[1] << 8) : pValue[0];
+}
+
+uint8_t rsh_set(CRegShadow_t *thizz, uint8_t reg, uint16_t value) {
+    const uint8_t i = rsh_index(thizz, reg);
+    if (i == NULL_BYTE) return 0;
+
+    const uint16_t mask = 1 << i;
+    if (thizz->width == 1) value &= 0xff;
+
+    CLI();
+    if ((thizz->validMask & mask) && !(thizz->dirtyMask & mask) && rsh_value(thizz, i) == value) {
+        thizz->skipped++;
+        SEI();
+        return 0;
+    }
+
+    uint8_t *pValue = thizz->pValues + i * thizz->width;
+    pValue[0] = value;
+    if (thizz->width == 2) pValue[1] = value >> 8;
+
+    thizz->setMask |= mask;
+    thizz->dirtyMask |= mask;
+    SEI();
+    return 1;
+}
+
+uint16_t rsh_get(const CRegShadow_t *thizz, uint8_t reg) {
+    const uint8_t i = rsh_index(thizz, reg);
+    if (i == NULL_BYTE || !(thizz->setMask & (1 << i))) return 0;
+    return rsh_value(thizz, i);
+}
+
+CByteStream_t *rsh_flush(CRegShadow_t *thizz) {
+    CByteStream_t *pLast = NULL;
+    uint8_t i = 0;
+
+    while (i < thizz->nRegs) {
+        CLI();
+        const uint16_t dirtyMask = thizz->dirtyMask;
+        SEI();
+
+        if (!(dirtyMask >> i)) break;
+        if (!(dirtyMask & (1 << i))) {
+            i++;
+            continue;
+        }
+
+        // extend to last dirty register reachable through consecutive registers with values in the burst group
+        const uint8_t reg = pgm_read_byte(thizz->pRegs + i);
+        uint8_t end = i + 1;
+        for (uint8_t j = i + 1; j < thizz->nRegs; j++) {
+            const uint8_t nextReg = pgm_read_byte(thizz->pRegs + j);
+            if (nextReg != reg + (j - i) || (nextReg >> thizz->burstShift) != (reg >> thizz->burstShift) || !(thizz->setMask & (1 << j))) break;
+            if (dirtyMask & (1 << j)) end = j + 1;
+        }
+
+        const uint16_t mask = (uint16_t) ((1UL << end) - (1UL << i));
+
+        CByteStream_t *pStream = twi_get_write_buffer(thizz->pCtrl, TWI_ADDRESS_W(thizz->addr));
+        pStream->fCallback = rsh_write_callback;
+        pStream->pCallbackParam = thizz;
+        stream_put(pStream, reg);
+
+        for (uint8_t j = i; j < end; j++) {
+            const uint16_t value = rsh_value(thizz, j);
+            if (thizz->width == 1) {
+                stream_put(pStream, value);
+            } else if (thizz->flags & RSH_FLAGS_BIG_ENDIAN) {
+                stream_put(pStream, value >> 8);
+                stream_put(pStream, value);
+            } else {
+                stream_put(pStream, value);
+                stream_put(pStream, value >> 8);
+            }
+        }
+
+        // clean before the request, an error completion marks them dirty again
+        CLI_ONLY();
+        thizz->dirtyMask &= ~mask;
+        thizz->validMask |= mask;
+        SEI();
+
+        CByteStream_t *pSent = twi_process(thizz->pCtrl, pStream);
+        if (!pSent) {
+            CLI_ONLY();
+            thizz->dirtyMask |= mask;
+            thizz->validMask &= ~mask;
+            SEI();
+            break;
+        }
+
+        pLast = pSent;
+        i = end;
+    }
+    return pLast;
+}
+
+CByteStream_t *rsh_write(CRegShadow_t *thizz, uint8_t reg, uint16_t value) {
+    rsh_set(thizz, reg, value);
+    return rsh_flush(thizz);
+}
+
+void rsh_invalidate(CRegShadow_t *thizz) {
+    CLI();
+    thizz->validMask = 0;
+    thizz->dirtyMask = thizz->setMask;
+    SEI();
+}
+
+void rsh_write_callback(const CByteStream_t *pStream) {
+    CRegShadow_t *pShadow = (CRegShadow_t *) pStream->pCallbackParam;
+
+    if (pShadow && pStream->error) {
+        pShadow->validMask = 0;
+        pShadow->dirtyMask = pShadow->setMask;
+    }
+}
@@ -0,0 +1,122 @@
+#ifndef ARDUINOPROJECTMODULE_CREGSHADOW_H
+#define ARDUINOPROJECTMODULE_CREGSHADOW_H
+
+/*
+ * Shadow of a device's writable registers, skips writes of unchanged values.
+ *
+ * rsh_set() stores a register value and marks it dirty only if it differs from what the device is known to hold,
+ * rsh_flush() writes the dirty registers. Consecutive register numbers in the same burst group go out in one
+ * request, registers between dirty ones are written with their shadow value when they have one. The burst shift
+ * gives the device's auto increment: RSH_BURST_NONE for a request per register, RSH_BURST_PAIR for the XL9535 which
+ * toggles between the registers of a pair, RSH_BURST_ALL for auto increment over the whole register range.
+ *
+ * A request completed with an error, or rsh_invalidate() after a device reset, marks all registers which have a
+ * value dirty, so the next flush writes them all again.
+ *
+ * Registers are given by a PROGMEM table of register numbers, at most RSH_MAX_REGS, in increasing order for bursts
+ * to be found. Values are 1 or 2 bytes wide, 2 byte values are sent low byte first unless RSH_FLAGS_BIG_ENDIAN.
+ *
+ * Requests are made with the controller's write stream, reserve resources for them the same as for any other
+ * request. The completion callback of the write stream is used by the shadow.
+ *
+ * Usage:
+ *
+ *     CRegShadow_t dacShadow;
+ *     uint8_t dacShadowValues[sizeOfRegShadowValues(DAC_SHADOW_REGS, 2)];
+ *
+ *     dac_shadow_init(&dacShadow, twiController.getHandle(), DAC_I2C_ADDRESS, dacShadowValues);
+ *
+ *     // only sent if different from last value written
+ *     dac_shadow_output(&dacShadow, data);
+ */
+
+#include "common_defs.h"
+#include "CByteStream.h"
+#include "CTwiController.h"
+
+#define RSH_MAX_REGS            (16)        // bits in register masks
+
+#define RSH_BURST_NONE          (0)         // one register per request
+#define RSH_BURST_PAIR          (1)         // pairs of registers, n and n+1 for even n
+#define RSH_BURST_ALL           (8)         // any consecutive registers
+
+#define RSH_FLAGS_BIG_ENDIAN    (0x01)      // 2 byte values sent high byte first
+
+#define sizeOfRegShadowValues(regs, width)  ((regs) * (width))
+
+typedef struct CRegShadow {
+    CController_t *pCtrl;           // controller of the bus the device is on
+    const uint8_t *pRegs;           // PROGMEM register numbers
+    uint8_t *pValues;               // register values, width bytes each, low byte first
+    uint8_t addr;                   // device 7 bit address
+    uint8_t nRegs;
+    uint8_t width;                  // 1 or 2 bytes per register
+    uint8_t burstShift;             // registers with same reg >> burstShift can be written in one request
+    uint8_t flags;
+    uint16_t setMask;               // registers which have a value
+    uint16_t validMask;             // registers the device holds the value of
+    uint16_t dirtyMask;             // registers to write on next flush
+    uint16_t skipped;               // writes skipped because the value was unchanged
+} CRegShadow_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Set up a shadow with no register values
+ *
+ * @param pRegs         PROGMEM register numbers
+ * @param nRegs         number of registers, at most RSH_MAX_REGS
+ * @param width         bytes per register value, 1 or 2
+ * @param burstShift    RSH_BURST_NONE, RSH_BURST_PAIR or RSH_BURST_ALL
+ * @param flags         RSH_FLAGS_BIG_ENDIAN
+ * @param pValues       storage of sizeOfRegShadowValues(nRegs, width)
+ */
+extern void rsh_init(CRegShadow_t *thizz, CController_t *pCtrl, uint8_t addr, const uint8_t *pRegs, uint8_t nRegs, uint8_t width, uint8_t burstShift, uint8_t flags, uint8_t *pValues);
+
+/**
+ * Set register value, not written until rsh_flush()
+ *
+ * @return  1 if the register is dirty, 0 if the value is not different or the register is not shadowed
+ */
+extern uint8_t rsh_set(CRegShadow_t *thizz, uint8_t reg, uint16_t value);
+
+/**
+ * @return  last value set, 0 if none or the register is not shadowed
+ */
+extern uint16_t rsh_get(const CRegShadow_t *thizz, uint8_t reg);
+
+/**
+ * Write dirty registers
+ *
+ * @return  last request, NULL if nothing was written or no request was free, the rest stays dirty
+ */
+extern CByteStream_t *rsh_flush(CRegShadow_t *thizz);
+
+/**
+ * Set register value and write dirty registers
+ *
+ * @return  last request, NULL if nothing was written
+ */
+extern CByteStream_t *rsh_write(CRegShadow_t *thizz, uint8_t reg, uint16_t value);
+
+/**
+ * Device was reset or lost its values, all registers which have a value are written on the next flush
+ */
+extern void rsh_invalidate(CRegShadow_t *thizz);
+
+/**
+ * Completion callback of shadow writes, invalidates on error. IMPORTANT: called from interrupt
+ */
+extern void rsh_write_callback(const CByteStream_t *pStream);
+
+static inline uint8_t rsh_is_dirty(const CRegShadow_t *thizz) {
+    return thizz->dirtyMask != 0;
+}
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif //ARDUINOPROJECTMODULE_CREGSHADOW_H
@@ -0,0 +1,152 @@
+#ifdef INCLUDE_STP_MODULE
+
+#include <Arduino.h>
+#include "CStepGroup.h"
+
+void stg_init(CStepGroup_t *thizz) {
+    thizz->nAxes = 0;
+    thizz->ticks = 0;
+    thizz->tick = 0;
+}
+
+static uint8_t stg_add_axis(CStepGroup_t *thizz, void *pMotor, const uint8_t *pPhases, uint8_t type) {
+    if (thizz->nAxes >= STG_MAX_AXES) return STG_NO_AXIS;
+
+    CStepAxis_t *pAxis = thizz->axes + thizz->nAxes;
+    pAxis->pMotor = pMotor;
+    pAxis->pPhases = pPhases;
+    pAxis->steps = 0;
+    pAxis->error = 0;
+    pAxis->flags = type;
+    return thizz->nAxes++;
+}
+
+uint8_t stg_add_apm(CStepGroup_t *thizz, CApmStepper_t *pStepper) {
+    return stg_add_axis(thizz, pStepper, NULL, STG_AXIS_APM);
+}
+
+#ifdef INCLUDE_IOX_MODULE
+
+uint8_t stg_add_iox(CStepGroup_t *thizz, CIOExpander_t *pIox, const uint8_t *pPhases) {
+    return stg_add_axis(thizz, pIox, pPhases, STG_AXIS_IOX);
+}
+
+// combined outputs of all own phase tables
+static uint8_t stg_phase_mask(const uint8_t *pPhases) {
+    return pgm_read_byte(pPhases) | pgm_read_byte(pPhases + 1) | pgm_read_byte(pPhases + 2) | pgm_read_byte(pPhases + 3);
+}
+
+#endif
+
+uint16_t stg_move(CStepGroup_t *thizz, const int16_t *pDeltas) {
+    uint16_t ticks = 0;
+
+    for (uint8_t i = 0; i < thizz->nAxes; i++) {
+        CStepAxis_t *pAxis = thizz->axes + i;
+        int16_t delta = pDeltas[i];
+
+        // -INT16_MIN does not fit
+        if (delta < -INT16_MAX) delta = -INT16_MAX;
+
+        pAxis->flags &= ~(STG_AXIS_FLAGS_CCW | STG_AXIS_FLAGS_DUE);
+        if (delta < 0) {
+            pAxis->flags |= STG_AXIS_FLAGS_CCW;
+            pAxis->steps = -delta;
+        } else {
+            pAxis->steps = delta;
+        }
+
+        if (ticks < pAxis->steps) ticks = pAxis->steps;
+    }
+
+    // start half way so minor axis steps are centered in their spans
+    for (uint8_t i = 0; i < thizz->nAxes; i++) {
+        thizz->axes[i].error = ticks >> 1;
+    }
+
+    thizz->ticks = ticks;
+    thizz->tick = 0;
+    return ticks;
+}
+
+uint16_t stg_step(CStepGroup_t *thizz) {
+    if (thizz->tick >= thizz->ticks) return 0;
+
+    const uint16_t ticks = thizz->ticks;
+#ifdef INCLUDE_IOX_MODULE
+    uint8_t iox = 0;
+#endif
+
+    for (uint8_t i = 0; i < thizz->nAxes; i++) {
+        CStepAxis_t *pAxis = thizz->axes + i;
+
+        // error + steps can exceed 16 bits
+        const uint32_t error = (uint32_t) pAxis->error + pAxis->steps;
+        if (error < ticks) {
+            pAxis->error = error;
+            continue;
+        }
+        pAxis->error = error - ticks;
+
+        const uint8_t ccwDir = pAxis->flags & STG_AXIS_FLAGS_CCW;
+
+        if ((pAxis->flags & STG_AXIS_FLAGS_TYPE) == STG_AXIS_APM) {
+            capm_step((CApmStepper_t *) pAxis->pMotor, ccwDir);
+            continue;
+        }
+
+#ifdef INCLUDE_IOX_MODULE
+        if (pAxis->pPhases) {
+            uint8_t phase = STG_FLAGS_TO_PHASE(pAxis->flags);
+            if (ccwDir) {
+                phase--;
+            } else {
+                phase++;
+            }
+            pAxis->flags &= ~STG_AXIS_FLAGS_PHASE;
+            pAxis->flags |= STG_PHASE_TO_FLAGS(phase);
+        }
+        pAxis->flags |= STG_AXIS_FLAGS_DUE;
+        iox = 1;
+#endif
+    }
+
+#ifdef INCLUDE_IOX_MODULE
+    // one write per expander with phase changes of all its due axes
+    while (iox) {
+        CIOExpander_t *pIox = NULL;
+        uint8_t phaseMask = 0;
+        uint8_t phaseOutputs = 0;
+        iox = 0;
+
+        for (uint8_t i = 0; i < thizz->nAxes; i++) {
+            CStepAxis_t *pAxis = thizz->axes + i;
+            if (!(pAxis->flags & STG_AXIS_FLAGS_DUE)) continue;
+
+            if (!pIox) {
+                pIox = (CIOExpander_t *) pAxis->pMotor;
+            } else if (pIox != pAxis->pMotor) {
+                // another expander, next pass
+                iox = 1;
+                continue;
+            }
+
+            pAxis->flags &= ~STG_AXIS_FLAGS_DUE;
+
+            if (pAxis->pPhases) {
+                phaseMask |= stg_phase_mask(pAxis->pPhases);
+                phaseOutputs |= pgm_read_byte(pAxis->pPhases + STG_FLAGS_TO_PHASE(pAxis->flags));
+            } else {
+                phaseMask |= IOX_OUT_MOT_PHASES;
+                phaseOutputs |= ciox_next_phase(pIox, pAxis->flags & STG_AXIS_FLAGS_CCW) | IOX_OUT_MOT_EN;
+            }
+        }
+
+        ciox_step_outputs(pIox, phaseMask, phaseOutputs);
+    }
+#endif
+
+    return thizz->ticks - ++thizz->tick;
+}
+
+#endif // INCLUDE_STP_MODULE
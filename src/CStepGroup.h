@@ -0,0 +1,121 @@
+#ifndef ARDUINOPROJECTMODULE_CSTEPGROUP_H
+#define ARDUINOPROJECTMODULE_CSTEPGROUP_H
+
+/*
+ * Coordinated multi axis stepping of CApmStepper and CIOExpander motors.
+ *
+ * stg_move() sets each axis' steps for a move, the axis with the most steps steps on every tick and the others are
+ * interpolated with Bresenham's line algorithm, so all axes start and end together. Ticks come from one timing
+ * source, a task using a CStepPlanner for the number of ticks returned by stg_move().
+ *
+ * CApmStepper axes are stepped during stg_step(). CIOExpander axes on the same expander are combined, all phase
+ * changes of a tick are sent in one output port write with ciox_step_outputs(). The expander's own motor, added
+ * with a NULL phase table, keeps its phase in the expander flags the same as ciox_step(). Other motors on the
+ * expander's port 0 outputs give their own PROGMEM table of 4 phase outputs, which can include an enable output.
+ *
+ * Usage:
+ *
+ *     CStepGroup_t group;
+ *     CStepPlanner_t plan;
+ *     int16_t deltas[2] = { 400, -200 };
+ *
+ *     stg_init(&group);
+ *     stg_add_iox(&group, pIox, NULL);
+ *     stg_add_iox(&group, pIox, secondMotorPhases);
+ *
+ *     stp_plan(&plan, STP_PROFILE_TRAPEZOID, stg_move(&group, deltas), 2000, 1200);
+ *
+ *     // in the stepping task
+ *     while (stg_step(&group)) {
+ *         resumeMicros(ciox_plan_step_micros(pIox, &plan));
+ *     }
+ */
+
+#include "common_defs.h"
+#include "CApmStepper.h"
+
+#ifdef INCLUDE_IOX_MODULE
+#include "CIOExpander.h"
+#endif
+
+#ifndef STG_MAX_AXES
+#define STG_MAX_AXES            (4)
+#endif
+
+#define STG_NO_AXIS             (0xff)
+
+#define STG_AXIS_APM            (0)         // CApmStepper_t motor
+#define STG_AXIS_IOX            (1)         // CIOExpander_t motor
+
+#define STG_AXIS_FLAGS_TYPE     (0x01)
+#define STG_AXIS_FLAGS_CCW      (0x02)      // move is ccw
+#define STG_AXIS_FLAGS_PHASE    (0x0C)      // phase of motor with own phase table
+#define STG_AXIS_FLAGS_DUE      (0x10)      // phase changed in current tick, IOX write pending
+
+#define STG_PHASE_TO_FLAGS(p)   (((p) << 2) & STG_AXIS_FLAGS_PHASE)
+#define STG_FLAGS_TO_PHASE(f)   (((f) & STG_AXIS_FLAGS_PHASE) >> 2)
+
+typedef struct CStepAxis {
+    void *pMotor;                   // CApmStepper_t or CIOExpander_t
+    const uint8_t *pPhases;         // PROGMEM phase outputs, NULL for expander's motor
+    uint16_t steps;                 // steps in move
+    uint16_t error;                 // Bresenham error accumulator
+    uint8_t flags;
+} CStepAxis_t;
+
+typedef struct CStepGroup {
+    CStepAxis_t axes[STG_MAX_AXES];
+    uint8_t nAxes;
+    uint16_t ticks;                 // ticks in move, most steps of an axis
+    uint16_t tick;                  // ticks done
+} CStepGroup_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern void stg_init(CStepGroup_t *thizz);
+
+/**
+ * Add a direct pin stepper
+ *
+ * @return  axis index, STG_NO_AXIS if group is full
+ */
+extern uint8_t stg_add_apm(CStepGroup_t *thizz, CApmStepper_t *pStepper);
+
+#ifdef INCLUDE_IOX_MODULE
+/**
+ * Add an expander stepper
+ *
+ * @param pIox      expander
+ * @param pPhases   PROGMEM table of 4 port 0 phase outputs, NULL for expander's IOX_OUT_MOT_* motor
+ * @return          axis index, STG_NO_AXIS if group is full
+ */
+extern uint8_t stg_add_iox(CStepGroup_t *thizz, CIOExpander_t *pIox, const uint8_t *pPhases);
+#endif
+
+/**
+ * Set up a move, previous move is dropped
+ *
+ * @param pDeltas   signed steps for each axis in order added, negative is ccw, -32767 to 32767, INT16_MIN is taken
+ *                  as -32767
+ * @return          ticks in move
+ */
+extern uint16_t stg_move(CStepGroup_t *thizz, const int16_t *pDeltas);
+
+/**
+ * Step axes due on the next tick
+ *
+ * @return  ticks left after this one, 0 if move is complete
+ */
+extern uint16_t stg_step(CStepGroup_t *thizz);
+
+static inline uint8_t stg_is_done(const CStepGroup_t *thizz) {
+    return thizz->tick >= thizz->ticks;
+}
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif //ARDUINOPROJECTMODULE_CSTEPGROUP_H
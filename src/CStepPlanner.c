@@ -0,0 +1,124 @@
+#ifdef INCLUDE_STP_MODULE
+
+#include "CStepPlanner.h"
+
+#define STP_MIN_STEP_MICROS     (100)
+#define STP_SCURVE_ONE          (1024)      // S-curve ramp position and smoothstep fixed point 1.0
+
+static uint16_t stp_isqrt(uint32_t value) {
+    uint32_t root = 0;
+    uint32_t bit = 1UL << 30;
+
+    while (bit > value) bit >>= 2;
+
+    while (bit) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+void stp_plan(CStepPlanner_t *thizz, uint8_t profile, uint16_t steps, uint16_t accel, time_t minStepMicros) {
+    if (!accel) accel = 1;
+    if (minStepMicros < STP_MIN_STEP_MICROS) minStepMicros = STP_MIN_STEP_MICROS;
+
+    // 0.676 * sqrt(2 / accel) s = 0.676 * sqrt(1000) * sqrt(2000000000 / accel) us
+    uint32_t firstDelay = (uint32_t) stp_isqrt(2000000000UL / accel) * 21377UL / 1000;
+    if (firstDelay < (uint32_t) minStepMicros) firstDelay = minStepMicros;
+
+    const uint32_t topSpeed = 1000000UL / minStepMicros;
+    const uint32_t startSpeed = 1000000UL / firstDelay;
+    uint32_t rampSteps = topSpeed * topSpeed / (2UL * accel);
+
+    if (profile == STP_PROFILE_SCURVE) {
+        // peak acceleration of smoothstep is 1.5 times the average
+        rampSteps += rampSteps >> 1;
+    }
+
+    // intervals are one less than steps, ramps take at most half each
+    const uint16_t maxRamp = steps > 1 ? (steps - 1) >> 1 : 0;
+
+    thizz->topSpeedSq = topSpeed * topSpeed;
+    if (rampSteps > maxRamp) {
+        rampSteps = maxRamp;
+
+        if (profile == STP_PROFILE_SCURVE) {
+            // speed reachable in the shorter ramp, peak acceleration 1.5 * v^2 / (2 * rampSteps)
+            thizz->topSpeedSq = 4UL * accel * rampSteps / 3;
+        }
+    }
+
+    thizz->profile = profile;
+    thizz->steps = steps;
+    thizz->step = 0;
+    thizz->rampSteps = rampSteps;
+    thizz->startSpeedSq = startSpeed * startSpeed;
+    if (thizz->topSpeedSq < thizz->startSpeedSq) thizz->topSpeedSq = thizz->startSpeedSq;
+    thizz->firstDelay = firstDelay << STP_DELAY_SHIFT;
+    thizz->minDelay = (uint32_t) minStepMicros << STP_DELAY_SHIFT;
+    thizz->rampDelay = thizz->minDelay;
+    if (profile == STP_PROFILE_SCURVE) {
+        thizz->rampDelay = (1000000UL / stp_isqrt(thizz->topSpeedSq)) << STP_DELAY_SHIFT;
+    }
+    thizz->delay = thizz->firstDelay;
+}
+
+// interval at ramp position pos, 0 to rampSteps - 1
+static time_t stp_scurve_interval(CStepPlanner_t *thizz, uint16_t pos) {
+    const uint32_t x = (uint32_t) pos * STP_SCURVE_ONE / thizz->rampSteps;
+    const uint32_t s = (x * x * (3 * STP_SCURVE_ONE - 2 * x)) >> 20;
+    const uint32_t delta = thizz->topSpeedSq - thizz->startSpeedSq;
+
+    // delta * s / STP_SCURVE_ONE without overflow
+    const uint32_t speedSq = thizz->startSpeedSq + (delta >> 10) * s + (((delta & 1023) * s) >> 10);
+    return 1000000UL / stp_isqrt(speedSq);
+}
+
+time_t stp_next_interval(CStepPlanner_t *thizz) {
+    if (thizz->step >= thizz->steps) return 0;
+
+    // interval i is between step i - 1 and step i, ramp down mirrors ramp up by intervals remaining after it
+    const uint16_t i = ++thizz->step;
+    if (i >= thizz->steps) return 0;
+
+    const uint16_t remaining = thizz->steps - i;
+
+    if (thizz->profile == STP_PROFILE_SCURVE) {
+        if (i <= thizz->rampSteps) {
+            return stp_scurve_interval(thizz, i - 1);
+        } else if (remaining <= thizz->rampSteps) {
+            return stp_scurve_interval(thizz, remaining - 1);
+        }
+        return thizz->rampDelay >> STP_DELAY_SHIFT;
+    }
+
+    uint32_t delay = thizz->delay;
+
+    if (i == 1) {
+        delay = thizz->firstDelay;
+    } else if (i <= thizz->rampSteps) {
+        // c[i] = c[i - 1] - 2 * c[i - 1] / (4 * (i - 1) + 1)
+        delay -= (delay << 1) / (((uint32_t) (i - 1) << 2) + 1);
+        if (delay < thizz->minDelay) delay = thizz->minDelay;
+    } else if (remaining == thizz->rampSteps) {
+        delay = thizz->rampDelay;
+    } else if (remaining < thizz->rampSteps) {
+        // c[r] = c[r + 1] + 2 * c[r + 1] / (4 * r - 1)
+        delay += (delay << 1) / (((uint32_t) remaining << 2) - 1);
+    } else {
+        // cruise at ramp up speed, which is the middle interval of short moves
+        delay = thizz->rampDelay;
+    }
+
+    if (i == thizz->rampSteps) thizz->rampDelay = delay;
+
+    thizz->delay = delay;
+    return delay >> STP_DELAY_SHIFT;
+}
+
+#endif // INCLUDE_STP_MODULE
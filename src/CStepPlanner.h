@@ -0,0 +1,96 @@
+#ifndef ARDUINOPROJECTMODULE_CSTEPPLANNER_H
+#define ARDUINOPROJECTMODULE_CSTEPPLANNER_H
+
+/*
+ * Step interval planner for accelerate, cruise, decelerate moves of CApmStepper and CIOExpander steppers.
+ *
+ * stp_plan() sets up a move, stp_next_interval() is called after each step and returns the micros to the next step,
+ * 0 after the last step. Per step math is integer only:
+ *
+ *   STP_PROFILE_TRAPEZOID  constant acceleration, D. Austin's recurrence c[n] = c[n-1] - 2 * c[n-1] / (4n + 1) for
+ *                          the ramp up and its mirror for the ramp down, one division per step. The first interval
+ *                          is 0.676 * sqrt(2 / accel) to correct the recurrence's error at low step counts.
+ *
+ *   STP_PROFILE_SCURVE     speed squared follows a smoothstep curve, 3x^2 - 2x^3 of the ramp position, so
+ *                          acceleration starts and ends at 0. The ramp is 1.5 times longer than the trapezoid ramp
+ *                          to keep peak acceleration at accel. Two divisions and a square root per ramp step.
+ *
+ * Moves too short to reach cruise speed ramp up for half the move and down for the other half.
+ *
+ * Direct pin steppers use capm_plan_step_micros(), which takes the step call time off the interval the same as
+ * capm_rpm_to_step_micros(). TWI steppers use ciox_plan_step_micros(), which takes off the expander's measured step
+ * request time, see ciox_step_delay_micros(). Intervals can also be used as StepQueue step times.
+ *
+ * Usage:
+ *
+ *     CStepPlanner_t plan;
+ *
+ *     // 400 steps, 2000 steps/s^2, cruise at 25 RPM of a 2048 steps/rev 28BYJ-48
+ *     stp_plan(&plan, STP_PROFILE_TRAPEZOID, 400, 2000, APM_STEPPER_MICROS_RPM(2048, 25, 1));
+ *
+ *     // in the stepping task
+ *     capm_step(&stepper, ccw);
+ *     time_t delay = capm_plan_step_micros(&plan);
+ *     if (delay) resumeMicros(delay);
+ */
+
+#ifdef CONSOLE_DEBUG
+#include <time.h>
+#endif
+
+#include "Arduino.h"
+#include "common_defs.h"
+
+#define STP_PROFILE_TRAPEZOID   (0)
+#define STP_PROFILE_SCURVE      (1)
+
+#define STP_DELAY_SHIFT         (8)         // fraction bits of trapezoid step delay
+
+typedef struct CStepPlanner {
+    uint32_t delay;             // last interval, trapezoid 24.8 fixed point micros
+    uint32_t firstDelay;        // first interval, 24.8 fixed point micros
+    uint32_t minDelay;          // cruise interval, 24.8 fixed point micros
+    uint32_t rampDelay;         // last ramp up and cruise interval, 24.8 fixed point micros
+    uint32_t startSpeedSq;      // S-curve speed squared of first interval, steps^2/s^2
+    uint32_t topSpeedSq;        // S-curve speed squared at end of ramp, steps^2/s^2
+    uint16_t steps;             // steps in move
+    uint16_t step;              // steps taken
+    uint16_t rampSteps;         // intervals in each ramp
+    uint8_t profile;
+} CStepPlanner_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Plan a move, the first step can be taken right away
+ *
+ * @param thizz         planner
+ * @param profile       STP_PROFILE_TRAPEZOID or STP_PROFILE_SCURVE
+ * @param steps         steps in move
+ * @param accel         acceleration and deceleration, steps/s^2
+ * @param minStepMicros cruise step interval, at least 100
+ */
+extern void stp_plan(CStepPlanner_t *thizz, uint8_t profile, uint16_t steps, uint16_t accel, time_t minStepMicros);
+
+/**
+ * Count a step taken and get the interval to the next one
+ *
+ * @return  micros to next step, 0 if the move is complete
+ */
+extern time_t stp_next_interval(CStepPlanner_t *thizz);
+
+static inline uint8_t stp_is_done(const CStepPlanner_t *thizz) {
+    return thizz->step >= thizz->steps;
+}
+
+static inline uint16_t stp_steps_left(const CStepPlanner_t *thizz) {
+    return thizz->steps - thizz->step;
+}
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif //ARDUINOPROJECTMODULE_CSTEPPLANNER_H
@@ -4,43 +4,51 @@
 
 #include <stdint.h>     //uint8_t type
 #include "CByteStream.h"
+#include "SchedClock.h"
 
 typedef uint8_t (*TwiWaitCallback)(void *pParam);
 
+/**
+ * Handle of the Controller processing a bus's requests, C code passes it to the helper functions instead of using a
+ * global controller so several buses can be used at the same time. Get it with Controller::getHandle().
+ */
+typedef struct CController CController_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-extern CByteStream_t *twiStream;
-extern void twi_fresh_stream();
-extern CByteStream_t *twi_get_write_buffer(uint8_t addr);
+// get the controller's write stream, set to given address, new stream if the last one was processed
+extern CByteStream_t *twi_get_write_buffer(CController_t *pCtrl, uint8_t addr);
+extern CByteStream_t *twi_fresh_stream(CController_t *pCtrl);
 
-extern void twi_set_own_buffer(uint8_t *pData, uint8_t nSize);
-extern void twi_set_rd_buffer(uint8_t rdReverse, uint8_t *pRdData, uint8_t nRdSize);
+extern void twi_set_own_buffer(CController_t *pCtrl, uint8_t *pData, uint8_t nSize);
+extern void twi_set_rd_buffer(CController_t *pCtrl, uint8_t rdReverse, void *pRdData, uint8_t nRdSize);
 
-// process accumulated twiStream, with debug stats and prep twiStream for next accumulation.
-extern CByteStream_t *twi_process_stream();            // processes the twiStream and requests a new twiStream without the need to call gfx_start_twi_cmd_frame() after the call
-extern CByteStream_t *twi_process(CByteStream_t *pStream);
+// process accumulated write stream, with debug stats and prep write stream for next accumulation.
+extern CByteStream_t *twi_process_stream(CController_t *pCtrl);
+extern CByteStream_t *twi_process(CController_t *pCtrl, CByteStream_t *pStream);
 
 // sending operations
-extern void twi_add_byte(uint8_t byte);
-extern void twi_add_pgm_byte_list(const uint8_t *bytes, uint16_t count);
+extern void twi_add_byte(CController_t *pCtrl, uint8_t byte);
+extern void twi_add_pgm_byte_list(CController_t *pCtrl, const uint8_t *bytes, uint16_t count);
 
-// wait for stream to be sent, if timeout !=0 then wait that many ms before giving up
-// return 0 if timeed out, 1 if sent (maybe with twiint_errors)
-extern uint8_t twi_wait_sent(CByteStream_t *pStream);
+// wait for stream to be sent, waits at most TWI_WAIT_TIMEOUT_MS
+// return 0 if timed out or request failed after retries, error is in pStream->error, 1 if sent
+extern uint8_t twi_wait_sent(CController_t *pCtrl, CByteStream_t *pStream);
 
 // use arbitrary function to determine completion, with TWI_WAIT_TIMEOUT in ms.
 extern uint8_t twi_wait(TwiWaitCallback callback, void *pParam);
 /**
  * Send given buffered data as self-buffered twi request
  *
+ * @param pCtrl  controller of the bus
  * @param addr   twi address, including read flag
  * @param pData  pointer to byte buffer
  * @param len    length of data to send
  * @return       pointer to last request, can be used to wait for completion of the send
  */
-extern CByteStream_t *twi_unbuffered_request(uint8_t addr, uint8_t *pData, uint8_t nSize);
+extern CByteStream_t *twi_unbuffered_request(CController_t *pCtrl, uint8_t addr, uint8_t *pData, uint8_t nSize);
 
 #ifdef __cplusplus
 }
@@ -57,13 +65,13 @@ extern uint8_t twi_send_errors;
     twi_send_errors = 0
 
 #define START_SERIAL_DEBUG_TWI_STATS() \
-        uint32_t start = micros()
+        uint32_t start = sched_micros()
 
 #define RESTART_SERIAL_DEBUG_TWI_STATS() \
-        start = micros()
+        start = sched_micros()
 
 #define END_SERIAL_DEBUG_TWI_STATS(bytes_sent) \
-        twi_send_time += micros() - start; \
+        twi_send_time += sched_micros() - start; \
         twi_send_bytes += (bytes_sent)
 
 #define PRINTF_SERIAL_DEBUG_TWI_STATS(...) printf_P(__VA_ARGS__)
@@ -141,7 +141,7 @@ void Controller::dumpReservationLockData() {
 void Controller::begin() {
 }
 
-void Controller::loop() {
+void Controller::service() {
     handleCompletedRequests();
 
 #ifdef SERIAL_DEBUG_TWI_TRACER
@@ -149,7 +149,10 @@ void Controller::loop() {
 #endif
 
     startNextRequest();
+}
 
+void Controller::loop() {
+    service();
     resume(1);
 }
 
@@ -167,7 +170,29 @@ void Controller::endProcessingRequest(ByteStream *pStream) {
 
     // make sure it is a shared request stream
     uint8_t id = getReadStreamId(pStream);
-    if (id < maxStreams) {
+    if (pStream == pPriorityStream) {
+        pPriorityStream = NULL;
+
+        if (isRequestAutoStart()) {
+            startNextRequest();
+        }
+    } else if (pRepeatRequest && pStream == (ByteStream *) &pRepeatRequest->stream) {
+        // run ended past the next run's time, waiting for the bus or held, skip the missed periods and keep the run
+        // times, otherwise the next run would start right after this one
+        const int32_t behind = (int32_t) (sched_micros() - pRepeatRequest->nextMicros);
+        if (behind >= 0) {
+            const uint16_t missed = behind / pRepeatRequest->periodMicros + 1;
+            pRepeatRequest->skipped += missed;
+            pRepeatRequest->nextMicros += missed * pRepeatRequest->periodMicros;
+        }
+
+        // stays registered, service() starts it again when due
+        pRepeatRequest = NULL;
+
+        if (isRequestAutoStart()) {
+            startNextRequest();
+        }
+    } else if (id < maxStreams) {
         uint8_t availBytes = 0;
 
         if (pStream->pData == writeBuffer.pData) {
@@ -187,8 +212,112 @@ void Controller::endProcessingRequest(ByteStream *pStream) {
             startNextRequest();
         }
 
-        // CAVEAT: this delay will cause tasks waiting for twi resources to be delayed by at least this delay
-        resume(20);
+        if (!isRequestAutoStart()) {
+            // next request is started by service()
+            resumeService(0);
+        } else if (pServiceTask == this) {
+            // CAVEAT: this delay will cause tasks waiting for twi resources to be delayed by at least this delay,
+            //  repeat requests due while the bus is idle are started by service(), keep its 1ms interval for them
+            resume(pRepeatList ? 1 : 20);
+        } else {
+            // shared service task, a delay here would hold back the other controllers' completed requests
+            pServiceTask->resumeMicros(0);
+        }
+    }
+}
+
+uint8_t Controller::startPriorityRequest(ByteStream *pStream) {
+    flags &= ~CTR_FLAGS_REQ_HOLD;
+    if (pPriorityStream) return 0;
+
+    pPriorityStream = pStream;
+    if (isProcessingRequest()) return 0;
+
+    startProcessingRequest(pStream);
+    return 1;
+}
+
+void Controller::addRepeatRequest(RepeatRequest *pRequest, uint8_t addr, uint8_t *pWrData, uint8_t nWrSize
+                                  , uint8_t *pRdData, uint8_t nRdSize, time_t periodMicros
+                                  , CTwiCallback_t fCallback, void *pCallbackParam) {
+    CByteStream_t *pStream = &pRequest->stream;
+
+    // own buffer, all of it sent, the spare byte of the queue is never read
+    pStream->byteQueue.nSize = nWrSize + 1;
+    pStream->byteQueue.nHead = 0;
+    pStream->byteQueue.nTail = nWrSize;
+    pStream->byteQueue.pData = pWrData;
+    pStream->flags = STREAM_FLAGS_RD | STREAM_FLAGS_UNBUFFERED;
+    pStream->addr = addr;
+    pStream->fCallback = fCallback;
+    pStream->pCallbackParam = pCallbackParam;
+#ifdef SERIAL_DEBUG_TWI_REQ_TIMING
+    pStream->startTime = 0;
+#endif
+    pStream->nRdSize = nRdSize;
+    pStream->pRdData = pRdData;
+    pStream->error = 0;
+
+    pRequest->periodMicros = periodMicros ? periodMicros : 1;
+    pRequest->nextMicros = sched_micros();
+    pRequest->runs = 0;
+    pRequest->skipped = 0;
+
+    CLI();
+    pRequest->pNext = NULL;
+
+    RepeatRequest **ppLast = &pRepeatList;
+    while (*ppLast) {
+        ppLast = &(*ppLast)->pNext;
+    }
+    *ppLast = pRequest;
+    SEI();
+
+    resumeService(0);
+}
+
+uint8_t Controller::removeRepeatRequest(RepeatRequest *pRequest) {
+    uint8_t removed = 0;
+
+    CLI();
+    for (RepeatRequest **ppRequest = &pRepeatList; *ppRequest; ppRequest = &(*ppRequest)->pNext) {
+        if (*ppRequest == pRequest) {
+            *ppRequest = pRequest->pNext;
+            removed = 1;
+            break;
+        }
+    }
+
+    if (pRepeatRequest == pRequest && !(pRequest->stream.flags & STREAM_FLAGS_PROCESSING)) {
+        // due but not started yet
+        pRequest->stream.flags &= ~STREAM_FLAGS_PENDING;
+        pRepeatRequest = NULL;
+    }
+    SEI();
+    return removed;
+}
+
+// IMPORTANT: called with interrupts disabled, also from interrupt
+void Controller::selectRepeatRequest() {
+    const time_t now = sched_micros();
+
+    for (RepeatRequest *pRequest = pRepeatList; pRequest; pRequest = pRequest->pNext) {
+        if ((int32_t) (now - pRequest->nextMicros) < 0) continue;
+
+        // rewind the request, the data is still in place
+        CByteStream_t *pStream = &pRequest->stream;
+        pStream->byteQueue.nHead = 0;
+        pStream->flags = (pStream->flags & STREAM_FLAGS_BUFF_REVERSE) | STREAM_FLAGS_RD | STREAM_FLAGS_UNBUFFERED | STREAM_FLAGS_PENDING;
+        pStream->error = 0;
+#ifdef SERIAL_DEBUG_TWI_REQ_TIMING
+        pStream->startTime = 0;
+#endif
+        pRequest->runs++;
+        pRequest->nextMicros += pRequest->periodMicros;
+
+        // periods missed by the time the run ends are skipped by endProcessingRequest()
+        pRepeatRequest = pRequest;
+        return;
     }
 }
 
@@ -209,6 +338,7 @@ void Controller::handleCompletedRequests() {
         completedStream->flags = 0;
         completedStream->nRdSize = 0;
         completedStream->pRdData = NULL;
+        completedStream->error = 0;
         completedStream->fCallback = NULL;
         completedStream->pCallbackParam = NULL;
 #ifdef SERIAL_DEBUG_TWI_REQ_TIMING
@@ -291,8 +421,8 @@ ByteStream *Controller::processStream(ByteStream *pWriteStream) {
     SEI();
 
     if (isRequestAutoStart() && count == 1) {
-        // first one, then no-one to start it up but here
-        startProcessingRequest(pStream);
+        // first one, then no-one to start it up but here, unless held or a priority request is in progress
+        startNextRequest();
         serialDebugTwiDataPrintf_P(PSTR("AutoStart req %d\n"), head);
     } else {
         // otherwise checking will be done in endProcessingRequest or in loop() for completed previous requests
@@ -301,7 +431,7 @@ ByteStream *Controller::processStream(ByteStream *pWriteStream) {
 
 
     // make sure loop task is enabled start our loop task to monitor its completion
-    this->resume(1);
+    resumeService(1000);
     return pStream;
 }
 
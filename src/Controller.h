@@ -7,6 +7,7 @@
 #include "Res2Lock.h"
 
 #include "twiint.h"
+#include "CTwiController.h"
 #include "ResourceUse.h"
 
 #ifdef SERIAL_DEBUG_TWI_TRACER
@@ -38,7 +39,77 @@ extern TraceBuffer twiTraceBuffer;
 // Use this macro to allocate space for all the queues and buffers in the controller.
 #define sizeOfControllerBuffer(maxStreams, maxTasks, writeBufferSize) (CTRL_NEXT_MEMBER_OFFS(maxStreams, maxTasks, writeBufferSize))
 
+/**
+ * Compile time layout of controller storage, alternative to sizeOfControllerBuffer() and CTRL_*_OFFS macros.
+ *
+ * The read stream table is placed first and aligned for ByteStream, the byte queues follow it so no padding is
+ * needed between members. Limits of the uint8_t controller fields are checked at compile time.
+ *
+ * Usage:
+ *
+ *     ControllerStorage<TWI_MAX_STREAMS, TWI_MAX_TASKS, TWI_MAX_BUFFER> twiStorage;
+ *     TwiController twiController(twiStorage);
+ *
+ * @tparam maxStreams       maximum number of request streams, see Controller()
+ * @tparam maxTasks         maximum number of tasks making resource reservations
+ * @tparam writeBufferSize  maximum bytes in the shared write buffer
+ */
+template<uint16_t maxStreams, uint16_t maxTasks, uint16_t writeBufferSize>
+struct ControllerStorage {
+    static_assert(maxStreams > 0, "ControllerStorage: maxStreams must be > 0");
+    static_assert(maxStreams < NULL_BYTE, "ControllerStorage: maxStreams must be < 255, stream ids are uint8_t with NULL_BYTE reserved");
+    static_assert(maxTasks > 0, "ControllerStorage: maxTasks must be > 0");
+    static_assert(RLOCK_RES_QUEUE_SIZE(maxTasks) <= QUEUE_MAX_SIZE + 1, "ControllerStorage: maxTasks must be <= 127, Res2Lock queue size is uint8_t");
+    static_assert(writeBufferSize > 0, "ControllerStorage: writeBufferSize must be > 0");
+    static_assert(writeBufferSize <= QUEUE_MAX_SIZE, "ControllerStorage: writeBufferSize must be <= QUEUE_MAX_SIZE, write buffer queue size is uint8_t");
+
+    // @formatter:off
+    alignas(ByteStream) uint8_t readStreamTable[CTRL_READ_STREAM_TABLE_SIZE(maxStreams, maxTasks, writeBufferSize)];
+    uint8_t pendingReadStreams[CTRL_PENDING_READ_STREAMS_SIZE(maxStreams, maxTasks, writeBufferSize)];
+    uint8_t completedStreams[CTRL_COMPLETED_STREAMS_SIZE(maxStreams, maxTasks, writeBufferSize)];
+    uint8_t freeReadStreams[CTRL_FREE_READ_STREAMS_SIZE(maxStreams, maxTasks, writeBufferSize)];
+    uint8_t resourceLock[CTRL_RESOURCE_LOCK_SIZE(maxStreams, maxTasks, writeBufferSize)];
+    uint8_t writeBuffer[CTRL_WRITE_BUFFER_SIZE(maxStreams, maxTasks, writeBufferSize)];
+    // @formatter:on
+
+    inline ByteStream *getReadStreamTable() {
+        return reinterpret_cast<ByteStream *>(readStreamTable);
+    }
+
+    /**
+     * Exact RAM used by the storage, including any tail padding needed for ByteStream alignment.
+     */
+    static constexpr uint16_t size() {
+        return sizeof(ControllerStorage);
+    }
+
+    /**
+     * Bytes used by members without any alignment padding, same as sizeOfControllerBuffer().
+     */
+    static constexpr uint16_t dataSize() {
+        return sizeOfControllerBuffer(maxStreams, maxTasks, writeBufferSize);
+    }
+};
+
+/**
+ * Periodic request started by the controller every period, see Controller::addRepeatRequest(). The write data and
+ * read buffer stay in place between runs, each run only rewinds the stream, so there is no task wake, resource
+ * reservation or write buffer copy per run. Completion calls the stream callback with the read data in the read
+ * buffer and the stream's error set, the same as for other requests.
+ *
+ * Fields are set by addRepeatRequest(), the request must stay in memory until removed.
+ */
+struct RepeatRequest {
+    CByteStream_t stream;           // own buffer request
+    RepeatRequest *pNext;           // next registered request, registration order is start order when several are due
+    time_t periodMicros;
+    time_t nextMicros;              // time of next run
+    uint16_t runs;                  // runs started
+    uint16_t skipped;               // periods skipped because the bus was busy past the next run's time
+};
+
 #define CTR_FLAGS_REQ_AUTO_START      (0x01)          // auto start requests when process request is called, default
+#define CTR_FLAGS_REQ_HOLD            (0x02)          // pending requests are not started, bus is reserved for a priority request
 
 class Controller : public Task {
 protected:
@@ -49,6 +120,10 @@ protected:
     ByteStream writeStream;         // write stream, must be requested and released in the same task invocation or pending data will not be handleProcessedRequest
     ByteStream *readStreamTable;    // pointer to first element in array of ByteSteam entries FIFO basis
     ByteQueue writeBuffer;          // shared write byte buffer
+    Task *pServiceTask;             // task running service(), this or ControllerGroup sharing one task between controllers
+    ByteStream *pPriorityStream;    // request started ahead of pending requests, see startPriorityRequest()
+    RepeatRequest *pRepeatList;     // registered periodic requests, see addRepeatRequest()
+    RepeatRequest *pRepeatRequest;  // repeat request due and waiting for the bus or being processed
 
     uint8_t maxStreams;
     uint8_t maxTasks;
@@ -74,27 +149,49 @@ public:
      */
     /* @formatter:off */
     Controller(uint8_t *pData, uint8_t maxStreams, uint8_t maxTasks, uint8_t writeBufferSize, uint8_t flags = CTR_FLAGS_REQ_AUTO_START)
-            : pendingReadStreams(pData + CTRL_PENDING_READ_STREAMS_OFFS(maxStreams, maxTasks, writeBufferSize), CTRL_PENDING_READ_STREAMS_SIZE(maxStreams, maxTasks, writeBufferSize))
-            , completedStreams(pData + CTRL_COMPLETED_STREAMS_OFFS(maxStreams, maxTasks, writeBufferSize), CTRL_COMPLETED_STREAMS_SIZE(maxStreams, maxTasks, writeBufferSize))
-            , freeReadStreams(pData + CTRL_FREE_READ_STREAMS_OFFS(maxStreams, maxTasks, writeBufferSize), CTRL_FREE_READ_STREAMS_SIZE(maxStreams, maxTasks, writeBufferSize))
-            , resourceLock(pData + CTRL_RESOURCE_LOCK_OFFS(maxStreams, maxTasks, writeBufferSize), maxTasks, maxStreams, writeBufferSize)
+            : Controller(pData + CTRL_PENDING_READ_STREAMS_OFFS(maxStreams, maxTasks, writeBufferSize)
+                         , pData + CTRL_COMPLETED_STREAMS_OFFS(maxStreams, maxTasks, writeBufferSize)
+                         , pData + CTRL_FREE_READ_STREAMS_OFFS(maxStreams, maxTasks, writeBufferSize)
+                         , pData + CTRL_RESOURCE_LOCK_OFFS(maxStreams, maxTasks, writeBufferSize)
+                         , reinterpret_cast<ByteStream *>(pData + CTRL_READ_STREAM_TABLE_OFFS(maxStreams, maxTasks, writeBufferSize))
+                         , pData + CTRL_WRITE_BUFFER_OFFS(maxStreams, maxTasks, writeBufferSize)
+                         , maxStreams, maxTasks, writeBufferSize, flags) {
+    /* @formatter:on */
+    }
+
+    /**
+     * Construct a controller using a compile time laid out storage block, see ControllerStorage
+     *
+     * @param storage           storage for all the controller queues, stream table and write buffer
+     */
+    template<uint16_t nStreams, uint16_t nTasks, uint16_t nBufferSize>
+    explicit Controller(ControllerStorage<nStreams, nTasks, nBufferSize> &storage, uint8_t flags = CTR_FLAGS_REQ_AUTO_START)
+            : Controller(storage.pendingReadStreams, storage.completedStreams, storage.freeReadStreams, storage.resourceLock
+                         , storage.getReadStreamTable(), storage.writeBuffer, nStreams, nTasks, nBufferSize, flags) {
+    }
+
+protected:
+    /* @formatter:off */
+    Controller(uint8_t *pPendingReadStreams, uint8_t *pCompletedStreams, uint8_t *pFreeReadStreams, uint8_t *pResourceLock
+               , ByteStream *pReadStreamTable, uint8_t *pWriteBuffer
+               , uint8_t maxStreams, uint8_t maxTasks, uint8_t writeBufferSize, uint8_t flags)
+            : pendingReadStreams(pPendingReadStreams, CTRL_PENDING_READ_STREAMS_SIZE(maxStreams, maxTasks, writeBufferSize))
+            , completedStreams(pCompletedStreams, CTRL_COMPLETED_STREAMS_SIZE(maxStreams, maxTasks, writeBufferSize))
+            , freeReadStreams(pFreeReadStreams, CTRL_FREE_READ_STREAMS_SIZE(maxStreams, maxTasks, writeBufferSize))
+            , resourceLock(pResourceLock, maxTasks, maxStreams, writeBufferSize)
             , writeStream(&writeBuffer, 0)
-            , readStreamTable(reinterpret_cast<ByteStream *>(pData + CTRL_READ_STREAM_TABLE_OFFS(maxStreams, maxTasks, writeBufferSize)))
-            , writeBuffer(pData + CTRL_WRITE_BUFFER_OFFS(maxStreams, maxTasks, writeBufferSize), CTRL_WRITE_BUFFER_SIZE(maxStreams, maxTasks, writeBufferSize))
+            , readStreamTable(pReadStreamTable)
+            , writeBuffer(pWriteBuffer, CTRL_WRITE_BUFFER_SIZE(maxStreams, maxTasks, writeBufferSize))
+            , pServiceTask(this)
+            , pPriorityStream(NULL)
+            , pRepeatList(NULL)
+            , pRepeatRequest(NULL)
             , maxStreams(maxStreams)
             , maxTasks(maxTasks)
             , writeBufferSize(writeBufferSize)
             , flags(flags) {
     /* @formatter:on */
         // now initialize all the read Streams
-
-        //printf("pendingReadStreams %p 0x%4.4lx %p\n", pendingReadStreams.pData, PENDING_READ_STREAMS_SIZE(maxStreams, maxTasks, writeBufferSize), pendingReadStreams.pData + PENDING_READ_STREAMS_SIZE(maxStreams, maxTasks, writeBufferSize));
-        //printf("freeReadStreams %p 0x%4.4lx %p\n", freeReadStreams.pData, FREE_READ_STREAMS_SIZE(maxStreams, maxTasks, writeBufferSize), freeReadStreams.pData + FREE_READ_STREAMS_SIZE(maxStreams, maxTasks, writeBufferSize));
-        //printf("writeBuffer %p 0x%4.4lx %p\n", writeBuffer.pData, WRITE_BUFFER_SIZE(maxStreams, maxTasks, writeBufferSize), writeBuffer.pData + WRITE_BUFFER_SIZE(maxStreams, maxTasks, writeBufferSize));
-        //printf("reservationLock %p 0x%4.4lx %p\n", reservationLock.queue.pData, RESOURCE_LOCK_SIZE(maxStreams, maxTasks, writeBufferSize), reservationLock.queue.pData + RESOURCE_LOCK_SIZE(maxStreams, maxTasks, writeBufferSize));
-        //printf("requirementList %p 0x%4.4lx %p\n", requirementList.pData, REQUIREMENT_LIST_SIZE(maxStreams, maxTasks, writeBufferSize), requirementList.pData + REQUIREMENT_LIST_SIZE(maxStreams, maxTasks, writeBufferSize));
-        //printf("readStreamTable %p 0x%4.4lx %p\n", readStreamTable, READ_STREAM_TABLE_SIZE(maxStreams, maxTasks, writeBufferSize), (uint8_t *)(readStreamTable) + READ_STREAM_TABLE_SIZE(maxStreams, maxTasks, writeBufferSize));
-
         for (int i = 0; i < maxStreams; i++) {
             ByteStream *pStream = readStreamTable + i;
             ByteStream::construct(pStream, &writeBuffer, 0);
@@ -110,6 +207,7 @@ public:
 #endif
     }
 
+public:
     void reset() {
         CLI();
 
@@ -119,6 +217,9 @@ public:
         freeReadStreams.reset();
         writeBuffer.reset();
         writeStream.reset();
+        pPriorityStream = NULL;
+        pRepeatRequest = NULL;
+        flags &= ~CTR_FLAGS_REQ_HOLD;
 
         for (int i = 0; i < maxStreams; i++) {
             ByteStream *pStream = readStreamTable + i;
@@ -154,6 +255,32 @@ public:
 
 #endif
 
+    /**
+     * Handle for C helper functions, see CTwiController.h
+     */
+    inline CController_t *getHandle() {
+        return (CController_t *) this;
+    }
+
+    static inline Controller *fromHandle(CController_t *pCtrl) {
+        return (Controller *) pCtrl;
+    }
+
+    /**
+     * Set task which calls service() for this controller, when not set the controller's own loop() does it and the
+     * controller must be in the scheduler's task table. Set by ControllerGroup::begin().
+     */
+    inline void setServiceTask(Task *pTask) {
+        pServiceTask = pTask;
+    }
+
+    /**
+     * Resume the task servicing this controller
+     */
+    inline void resumeService(time_t microseconds) {
+        pServiceTask->resumeMicros(microseconds);
+    }
+
     uint8_t getReadStreamId(ByteStream *pStream) {
         return pStream - readStreamTable;
     }
@@ -250,16 +377,120 @@ public:
     // IMPORTANT: called from interrupt so no cli/sei needed
     void startNextRequest() {
         CLI();
-        if (!pendingReadStreams.isEmpty() && !isTracePending()) {
-            uint8_t nextHead = pendingReadStreams.peekHead();
-            ByteStream *pNextStream = getReadStream(nextHead);
-            if (!(pNextStream->isProcessing())) {
-                startProcessingRequest(pNextStream);
+        if (!isTracePending() && !isProcessingRequest()) {
+            if (pRepeatList && !pRepeatRequest) {
+                selectRepeatRequest();
+            }
+
+            if (pPriorityStream) {
+                startProcessingRequest(pPriorityStream);
+            } else if (pRepeatRequest && !(flags & CTR_FLAGS_REQ_HOLD)) {
+                startProcessingRequest((ByteStream *) &pRepeatRequest->stream);
+            } else if (!pendingReadStreams.isEmpty() && !(flags & CTR_FLAGS_REQ_HOLD)) {
+                startProcessingRequest(getReadStream(pendingReadStreams.peekHead()));
             }
         }
         SEI();
     }
 
+    /**
+     * @return request being processed by the interrupt, NULL if none
+     */
+    NO_DISCARD ByteStream *getProcessingRequest() {
+        if (pPriorityStream && pPriorityStream->isProcessing()) return pPriorityStream;
+        if (pRepeatRequest && ((ByteStream *) &pRepeatRequest->stream)->isProcessing()) return (ByteStream *) &pRepeatRequest->stream;
+        if (!pendingReadStreams.isEmpty() && getReadStream(pendingReadStreams.peekHead())->isProcessing()) return getReadStream(pendingReadStreams.peekHead());
+        return NULL;
+    }
+
+    /**
+     * @return true if a request is being processed by the interrupt
+     */
+    NO_DISCARD uint8_t isProcessingRequest() {
+        return getProcessingRequest() != NULL;
+    }
+
+    /**
+     * Stop starting pending requests so the bus is free for a priority request at a known time. A request already
+     * being processed runs to completion.
+     *
+     * IMPORTANT: must be called with interrupts disabled
+     */
+    inline void holdRequests() {
+        flags |= CTR_FLAGS_REQ_HOLD;
+    }
+
+    /**
+     * Resume starting pending requests after holdRequests()
+     *
+     * IMPORTANT: must be called with interrupts disabled
+     */
+    inline void releaseRequests() {
+        flags &= ~CTR_FLAGS_REQ_HOLD;
+        startNextRequest();
+    }
+
+    /**
+     * Start a request which is not from the read stream table ahead of pending requests, and release held
+     * requests. If the bus is busy, it is started as soon as the current request completes. Completion triggers
+     * the stream callback only, the stream is not recycled. Only one priority request can be outstanding.
+     *
+     * IMPORTANT: must be called with interrupts disabled, e.g. from a timer interrupt
+     *
+     * @param pStream   request stream, with own buffer
+     * @return          true if started right away, false if it waits for the current request or another priority
+     *                  request is outstanding
+     */
+    uint8_t startPriorityRequest(ByteStream *pStream);
+
+    /**
+     * @return true if a priority request is waiting or being processed, another one cannot be started
+     */
+    NO_DISCARD inline uint8_t hasPriorityRequest() const {
+        return pPriorityStream != NULL;
+    }
+
+    /**
+     * Register a request the controller starts every periodMicros, first run is due right away. Due requests are
+     * started ahead of pending requests, one at a time, when the request in progress completes or from service()
+     * when the bus is idle, so a run can be late by up to the longest request on the bus or the service interval.
+     * A run which ends so late that the next run's time has passed skips the missed periods, counted in
+     * RepeatRequest::skipped, so a late run is not followed right away by another one.
+     *
+     * Runs do not use the request streams or write buffer of the controller and need no reserveResources().
+     *
+     * IMPORTANT: the write data and read buffer are used in place, they must not change while the request is pending,
+     *     i.e. change them in the callback or while ((ByteStream *) &pRequest->stream)->isPending() is false.
+     *
+     * @param pRequest          request to register, must not be registered already
+     * @param addr              address of the request, e.g. TWI_ADDRESS_W(addr) for a register read
+     * @param pWrData           bytes to send, NULL if none
+     * @param nWrSize           number of bytes to send, up to 254
+     * @param pRdData           buffer for bytes read, NULL if none
+     * @param nRdSize           number of bytes to read
+     * @param periodMicros      period between runs
+     * @param fCallback         called from the interrupt on completion of each run, NULL if none
+     * @param pCallbackParam    callback parameter
+     */
+    void addRepeatRequest(RepeatRequest *pRequest, uint8_t addr, uint8_t *pWrData, uint8_t nWrSize
+                          , uint8_t *pRdData, uint8_t nRdSize, time_t periodMicros
+                          , CTwiCallback_t fCallback = NULL, void *pCallbackParam = NULL);
+
+    /**
+     * Unregister a repeat request. A run already being processed completes and calls the callback.
+     *
+     * @param pRequest          request to remove
+     * @return                  true if it was registered
+     */
+    uint8_t removeRepeatRequest(RepeatRequest *pRequest);
+
+    /**
+     * Select the first due repeat request to run next, called from startNextRequest()
+     *
+     * IMPORTANT: must be called with interrupts disabled
+     */
+    void selectRepeatRequest();
+
     /**
      * mark end of request processing by the interrupt, this should be the
      * first request in the pending streams.
@@ -272,6 +503,11 @@ public:
 
     void handleCompletedRequests();
 
+    /**
+     * Recycle completed requests and start the next pending request, called from loop() or ControllerGroup
+     */
+    virtual void service();
+
     void begin() override;
 
     void loop() override;
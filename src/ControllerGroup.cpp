@@ -0,0 +1,18 @@
+#include "ControllerGroup.h"
+
+void ControllerGroup::begin() {
+    // controllers are not in the task table, their begin() is not called by the scheduler
+    for (uint8_t i = 0; i < count; i++) {
+        Controller *pController = pControllers[i];
+        pController->setServiceTask(this);
+        pController->begin();
+    }
+}
+
+void ControllerGroup::loop() {
+    for (uint8_t i = 0; i < count; i++) {
+        pControllers[i]->service();
+    }
+
+    resume(1);
+}
@@ -0,0 +1,48 @@
+#ifndef SCHEDULER_CONTROLLERGROUP_H
+#define SCHEDULER_CONTROLLERGROUP_H
+
+#include "Controller.h"
+
+/**
+ * One scheduler task servicing several controllers, e.g. hardware TWI for the display, SoftTwiController for
+ * stepper I/O on its own bus and SpiController. The controllers are not in the scheduler's task table, their
+ * resume requests go to the group and each pass services all of them.
+ *
+ * A completed request resumes the group on the next pass, instead of the 20ms delay a standalone controller uses,
+ * so a busy bus does not hold back recycling of requests on the other buses.
+ *
+ * Usage:
+ *
+ *     Controller *const busControllers[] = { &twiController, &softTwiController, &spiController };
+ *     ControllerGroup busGroup(busControllers, lengthof(busControllers));
+ *
+ *     Task *const taskTable[] PROGMEM = { &busGroup, ... };
+ *
+ * Each controller has its own request queues and resource reservations, C helpers take the controller's handle:
+ *
+ *     iox_out(softTwiController.getHandle(), IOX_I2C_ADDRESS(0), outputs);
+ */
+class ControllerGroup : public Task {
+    Controller *const *pControllers;
+    uint8_t count;
+
+public:
+    ControllerGroup(Controller *const *pControllers, uint8_t count) : pControllers(pControllers), count(count) {
+    }
+
+    defineSchedulerTaskId("ControllerGroup");
+
+    NO_DISCARD inline uint8_t getCount() const {
+        return count;
+    }
+
+    inline Controller *getController(uint8_t index) const {
+        return pControllers[index];
+    }
+
+    void begin() override;
+
+    void loop() override;
+};
+
+#endif //SCHEDULER_CONTROLLERGROUP_H
@@ -0,0 +1,159 @@
+#ifdef INCLUDE_DACW_MODULE
+
+#include "DacWavePlayer.h"
+#include "twiint.h"
+
+#ifdef CONSOLE_DEBUG
+#include "SimRuntime.h"
+#endif
+
+void dacw_timer_event(void) {
+    dacWavePlayer.timerEvent();
+}
+
+DacWavePlayer::DacWavePlayer() {
+    pController = NULL;
+    addr = 0;
+    flags = 0;
+    nextStream = 0;
+    pSamples = NULL;
+    nSamples = 0;
+    nIndex = 0;
+    sampleMicros = 0;
+    nextTime = 0;
+    streams[0].flags = 0;
+    streams[1].flags = 0;
+    samples = 0;
+    lateSamples = 0;
+}
+
+void DacWavePlayer::begin(Controller *pController, uint8_t addr) {
+    stop();
+    this->pController = pController;
+    this->addr = addr;
+}
+
+#ifdef CONSOLE_DEBUG
+
+void DacWavePlayer::simTimerEvent(void *pParam) {
+    ((DacWavePlayer *) pParam)->timerEvent();
+}
+
+#endif
+
+uint8_t DacWavePlayer::arm(time_t time) {
+#ifndef CONSOLE_DEBUG
+    return dacwint_arm(time);
+#else
+    const int32_t remaining = (int32_t) (time - sched_micros());
+    if (remaining < DACWINT_MIN_MICROS) return 0;
+
+    simRuntime.scheduleEvent(remaining, simTimerEvent, this);
+    return 1;
+#endif
+}
+
+void DacWavePlayer::disarm() {
+#ifndef CONSOLE_DEBUG
+    dacwint_disarm();
+#else
+    simRuntime.cancelEvents(simTimerEvent, this);
+#endif
+}
+
+void DacWavePlayer::play(const uint16_t *pSamples, uint16_t count, time_t sampleMicros, uint8_t flags) {
+    CLI();
+    disarm();
+
+    this->pSamples = pSamples;
+    nSamples = count;
+    nIndex = 0;
+    this->sampleMicros = sampleMicros < DAC_WAVE_MIN_SAMPLE_MICROS ? DAC_WAVE_MIN_SAMPLE_MICROS : sampleMicros;
+    this->flags = (flags & (DAC_WAVE_PROGMEM | DAC_WAVE_LOOP)) | (count ? DAC_WAVE_PLAYING : 0);
+    nextTime = sched_micros();
+
+    if (count) {
+        timerEvent();
+    }
+    SEI();
+}
+
+void DacWavePlayer::stop() {
+    CLI();
+    disarm();
+    flags &= ~DAC_WAVE_PLAYING;
+    SEI();
+}
+
+// IMPORTANT: called with interrupts disabled
+uint8_t DacWavePlayer::startSample(uint16_t value) {
+    CByteStream_t *pStream = streams + nextStream;
+
+    // stream still in use or a priority request is outstanding, previous sample or another user's
+    if ((pStream->flags & (STREAM_FLAGS_PENDING | STREAM_FLAGS_PROCESSING)) || pController->hasPriorityRequest()) {
+        return 0;
+    }
+
+    value = WR_DATA_DAC(value);
+
+    queue_init(&pStream->byteQueue, streamData[nextStream], sizeof(streamData[0]));
+    queue_put(&pStream->byteQueue, REG_DATA);
+    queue_put(&pStream->byteQueue, value >> 8);
+    queue_put(&pStream->byteQueue, value & 0xff);
+
+    pStream->flags = STREAM_FLAGS_RD | STREAM_FLAGS_UNBUFFERED | STREAM_FLAGS_PENDING;
+    pStream->addr = TWI_ADDRESS_W(addr);
+    pStream->fCallback = NULL;
+    pStream->pCallbackParam = NULL;
+#ifdef SERIAL_DEBUG_TWI_REQ_TIMING
+    pStream->startTime = 0;
+#endif
+    pStream->nRdSize = 0;
+    pStream->pRdData = NULL;
+    pStream->error = 0;
+
+    nextStream ^= 1;
+    pController->startPriorityRequest((ByteStream *) pStream);
+    return 1;
+}
+
+// IMPORTANT: called with interrupts disabled
+void DacWavePlayer::timerEvent() {
+    while (flags & DAC_WAVE_PLAYING) {
+        if (arm(nextTime)) return;
+
+        if (nIndex >= nSamples) {
+            if (!(flags & DAC_WAVE_LOOP)) {
+                flags &= ~DAC_WAVE_PLAYING;
+                return;
+            }
+            nIndex = 0;
+        }
+
+        const uint16_t value = flags & DAC_WAVE_PROGMEM ? pgm_read_word(pSamples + nIndex) : pSamples[nIndex];
+        nIndex++;
+
+        if (startSample(value)) {
+            samples++;
+        } else {
+            lateSamples++;
+        }
+
+        nextTime += sampleMicros;
+
+        // fell behind by more than a sample, drop the missed ones and keep the sample rate, signed as next sample
+        // time is usually ahead
+        const int32_t behind = (int32_t) (sched_micros() - nextTime);
+        if (behind >= (int32_t) sampleMicros) {
+            const uint16_t missed = (time_t) behind / sampleMicros;
+            lateSamples += missed;
+            nextTime += missed * sampleMicros;
+            nIndex += missed;
+            if (nIndex > nSamples) {
+                nIndex = flags & DAC_WAVE_LOOP ? nIndex % nSamples : nSamples;
+            }
+        }
+    }
+}
+
+#endif // INCLUDE_DACW_MODULE
@@ -0,0 +1,128 @@
+#ifndef SCHEDULER_DACWAVEPLAYER_H
+#define SCHEDULER_DACWAVEPLAYER_H
+
+#include "Controller.h"
+#include "CDac53401.h"
+#include "dacwint.h"
+
+/**
+ * Waveform player for a DAC53401, streams DAC data samples from a PROGMEM or RAM table at a fixed sample rate for
+ * voltage ramps or sound. Each sample's data write request is started from the Timer1 compare A interrupt at its
+ * time, see dacwint, so the sample rate does not depend on task scheduling and there is no task wake, resource
+ * reservation or shared write buffer use per sample.
+ *
+ * Requests are double buffered in the player. A sample is started with startPriorityRequest(), ahead of pending
+ * requests, so it goes out when the request in progress completes. Sample jitter is at most the longest request on
+ * the bus. A sample whose request cannot start because the previous sample or another priority request, such as a
+ * StepQueue step, is still outstanding is dropped and counted in getLateSamples(), the following samples keep their
+ * times. Used together with a StepQueue, samples due while a step is outstanding are dropped and a sample in
+ * progress at a step time delays the step.
+ *
+ * Usage:
+ *
+ *     const uint16_t ramp[] PROGMEM = { VM_MV_TO_DAC_DATA(4000), VM_MV_TO_DAC_DATA(4500), ... };
+ *
+ *     DacWavePlayer dacWavePlayer;
+ *
+ *     // in setup(), after sched_clock_begin()
+ *     dacwint_init();
+ *     dacWavePlayer.begin(&twiController, DAC_I2C_ADDRESS);
+ *
+ *     // in a task, 1ms per sample, play once from flash
+ *     dacWavePlayer.play(ramp, lengthof(ramp), 1000, DAC_WAVE_PROGMEM);
+ *
+ * Compiled with INCLUDE_DACW_MODULE, which needs INCLUDE_DAC_MODULE. CONSOLE_DEBUG builds use SimRuntime events for
+ * the timer.
+ */
+
+#ifndef DAC_WAVE_MIN_SAMPLE_MICROS
+#define DAC_WAVE_MIN_SAMPLE_MICROS  (100L)      // 3 byte write at 400kHz takes about 100us
+#endif
+
+#define DAC_WAVE_PROGMEM            (0x01)      // samples are in flash
+#define DAC_WAVE_LOOP               (0x02)      // restart at first sample after the last one
+#define DAC_WAVE_PLAYING            (0x80)      // samples are being played
+
+class DacWavePlayer {
+    Controller *pController;
+    uint8_t addr;
+    uint8_t flags;
+    uint8_t nextStream;
+
+    const uint16_t *pSamples;
+    uint16_t nSamples;
+    uint16_t nIndex;                            // next sample to play
+    time_t sampleMicros;
+    time_t nextTime;                            // sched_micros() time of next sample
+
+    // sample requests, two so a sample can be started while the previous one completes
+    CByteStream_t streams[2];
+    uint8_t streamData[2][4];                   // register and data, one extra byte for the queue
+
+    uint16_t samples;
+    uint16_t lateSamples;
+
+    uint8_t arm(time_t time);
+    void disarm();
+    uint8_t startSample(uint16_t value);
+
+#ifdef CONSOLE_DEBUG
+    static void simTimerEvent(void *pParam);
+#endif
+
+public:
+    DacWavePlayer();
+
+    /**
+     * Set the controller of the DAC's bus and its address
+     */
+    void begin(Controller *pController, uint8_t addr);
+
+    /**
+     * Start playing samples, a waveform already playing is replaced
+     *
+     * @param pSamples      DAC data samples, 0 to DAC_DATA_MAX - 1
+     * @param count         number of samples
+     * @param sampleMicros  sample period, at least DAC_WAVE_MIN_SAMPLE_MICROS
+     * @param flags         DAC_WAVE_PROGMEM, DAC_WAVE_LOOP
+     */
+    void play(const uint16_t *pSamples, uint16_t count, time_t sampleMicros, uint8_t flags);
+
+    /**
+     * Stop playing, a sample request already started completes and the DAC keeps its value
+     */
+    void stop();
+
+    NO_DISCARD inline uint8_t isPlaying() const {
+        return flags & DAC_WAVE_PLAYING;
+    }
+
+    /**
+     * Index of next sample to play
+     */
+    NO_DISCARD inline uint16_t getPosition() const {
+        return nIndex;
+    }
+
+    NO_DISCARD inline uint16_t getSamples() const {
+        return samples;
+    }
+
+    /**
+     * Samples dropped because a previous sample or other priority request was still outstanding, wraps around
+     */
+    NO_DISCARD inline uint16_t getLateSamples() const {
+        return lateSamples;
+    }
+
+    /**
+     * Start sample which is due and arm timer for the next one
+     *
+     * IMPORTANT: called from interrupt or with interrupts disabled
+     */
+    void timerEvent();
+};
+
+extern DacWavePlayer dacWavePlayer;
+
+#endif //SCHEDULER_DACWAVEPLAYER_H
@@ -6,6 +6,7 @@
 #include <Arduino.h>
 #include "CIOExpander.h"
 #include "ByteStream.h"
+#include "Controller.h"
 
 class IOExpander : protected CIOExpander {
 
@@ -13,10 +14,22 @@ public:
     explicit IOExpander() {
         // set config + unused config
         fStepCallback = iox_step_done;
+        fInCallback = NULL;
     }
 
-    void init(uint8_t addrOption, uint8_t configOption = 0xff, uint8_t dataOption = 0x00) {
-        iox_init(XL9535_BASE_ADDRESS + (addrOption & XL9535_OPTIONAL_ADDRESS_MASK), TILT_CONFIGURATION | ((uint16_t) configOption << 8) & TILT_UNUSED_IO, TILT_INVERT_OUT | ((uint16_t) dataOption << 8) & TILT_UNUSED_IO);
+    /**
+     * Initialize expander on the bus of given controller
+     */
+    void init(Controller *pController, uint8_t addrOption, uint8_t configOption = 0xff, uint8_t dataOption = 0x00) {
+        pCtrl = pController->getHandle();
+        iox_init(pCtrl, XL9535_BASE_ADDRESS + (addrOption & XL9535_OPTIONAL_ADDRESS_MASK), TILT_CONFIGURATION | ((uint16_t) configOption << 8) & TILT_UNUSED_IO, TILT_INVERT_OUT | ((uint16_t) dataOption << 8) & TILT_UNUSED_IO);
+    }
+
+    /**
+     * Handle for C helper functions and StepQueue
+     */
+    inline CIOExpander_t *getHandle() {
+        return this;
     }
 
     inline void setLED(uint8_t ledColor) {
@@ -59,11 +72,49 @@ public:
         return flags & IOX_FLAGS_STEPPING;
     }
 
+    /**
+     * Delay from step completion to next step request for a step period, compensated by measured step request time
+     * and integrated step to step interval error. Call in stepDone() to schedule the next step.
+     *
+     * @param stepMicros    step period
+     */
+    inline time_t stepDelayMicros(time_t stepMicros) {
+        return ciox_step_delay_micros(this, stepMicros);
+    }
+
+    /**
+     * Running average of step request queue and bus time
+     */
+    NO_DISCARD inline uint16_t getStepLatency() const {
+        return ciox_step_latency(this);
+    }
+
+    /**
+     * Last step to step interval less step period, to verify RPM accuracy under load
+     */
+    NO_DISCARD inline int32_t getStepError() const {
+        return stepError;
+    }
+
+    /**
+     * RPM x 10 of running average step interval, 0 if not measured
+     */
+    NO_DISCARD inline uint16_t getStepRpmX10(uint8_t reduction) const {
+        return ciox_step_rpmX10(this, reduction);
+    }
+
+    /**
+     * Reset step interval measurement and correction, after the motor is stopped or the period changes by a lot
+     */
+    inline void resetStepTiming() {
+        ciox_step_reset(this);
+    }
+
     /**
      * Callback to schedule next step after completion of current step, if still have pending steps
      * or just handle last step sent, possibly turn off motor en after a delay
      *
-     * NOTE: request start time can be obtained from twiint_request_start_time, end time is micros().
+     * NOTE: request start time can be obtained from twiint_request_start_time, end time is sched_micros().
      */
     virtual void stepDone(ByteStream *pStream) = 0;
 
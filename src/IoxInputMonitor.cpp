@@ -0,0 +1,139 @@
+#ifdef INCLUDE_IOX_MODULE
+
+#include "IoxInputMonitor.h"
+
+#ifdef INCLUDE_IOX_INT
+
+void iox_int_event(void) {
+    ioxInputMonitor.intEvent();
+}
+
+#endif
+
+IoxInputMonitor::IoxInputMonitor() : Task() {
+    pController = NULL;
+    pIox = NULL;
+    pSignal = NULL;
+    keepAliveMicros = IOX_INPUT_KEEP_ALIVE_MICROS;
+    lastRead = 0;
+    flags = 0;
+    readInputs = 0;
+    reads = 0;
+    changes = 0;
+    intEvents = 0;
+    readErrors = 0;
+}
+
+void IoxInputMonitor::init(Controller *pController, CIOExpander_t *pIox, Signal *pSignal, time_t keepAliveMicros) {
+    this->pController = pController;
+    this->pIox = pIox;
+    this->pSignal = pSignal;
+    this->keepAliveMicros = keepAliveMicros;
+
+    CLI();
+    pIox->fInCallback = inputsRead;
+    readInputs = pIox->inputs;
+    lastRead = sched_micros();
+    flags = IOX_MON_FLAGS_INT_PENDING;
+    SEI();
+
+    resumeMicros(0);
+}
+
+void IoxInputMonitor::begin() {
+    // suspended until init() if not initialized yet
+    if (pIox) {
+        resumeMicros(0);
+    }
+}
+
+void IoxInputMonitor::inputsRead(const CByteStream_t *pStream, CIOExpander_t *pIox) {
+    ioxInputMonitor.readDone(pStream->error);
+}
+
+void IoxInputMonitor::intEvent() {
+    intEvents++;
+    flags |= IOX_MON_FLAGS_INT_PENDING;
+
+    // task waiting for resources is resumed by the controller's lock
+    if (!(flags & IOX_MON_FLAGS_RESERVING)) {
+        resumeMicros(0);
+    }
+}
+
+void IoxInputMonitor::readDone(uint8_t error) {
+    flags &= ~IOX_MON_FLAGS_READING;
+
+    if (error) {
+        // inputs not read, retry as if INT was asserted
+        readErrors++;
+        flags |= IOX_MON_FLAGS_INT_PENDING;
+
+        if (!(flags & IOX_MON_FLAGS_RESERVING)) {
+            resumeMicros(IOX_INPUT_RETRY_MICROS);
+        }
+        return;
+    }
+
+    const uint8_t inputs = pIox->inputs;
+    if (inputs != readInputs) {
+        readInputs = inputs;
+        changes++;
+        flags |= IOX_MON_FLAGS_CHANGED;
+    }
+
+    if ((flags & (IOX_MON_FLAGS_CHANGED | IOX_MON_FLAGS_INT_PENDING)) && !(flags & IOX_MON_FLAGS_RESERVING)) {
+        resumeMicros(0);
+    }
+}
+
+void IoxInputMonitor::loop() {
+    CLI();
+    const uint8_t monFlags = flags;
+    flags &= ~(IOX_MON_FLAGS_CHANGED | IOX_MON_FLAGS_RESERVING);
+    SEI();
+
+    if ((monFlags & IOX_MON_FLAGS_CHANGED) && pSignal) {
+        // triggered from the task, Signal is not interrupt safe
+        pSignal->trigger();
+    }
+
+    const time_t elapsed = sched_micros() - lastRead;
+
+    if (elapsed < keepAliveMicros && !(monFlags & IOX_MON_FLAGS_RESERVING)) {
+        // read outstanding, readDone() resumes, or nothing to read until keep alive
+        if ((monFlags & IOX_MON_FLAGS_READING) || !(monFlags & IOX_MON_FLAGS_INT_PENDING)) {
+            resumeMicros(keepAliveMicros - elapsed);
+            return;
+        }
+    }
+
+    // resumed when resources are available
+    CLI_ONLY();
+    flags |= IOX_MON_FLAGS_RESERVING;
+    SEI();
+
+    if (pController->reserveResources(1, 2)) return;
+
+    CLI_ONLY();
+    flags = (flags & ~(IOX_MON_FLAGS_RESERVING | IOX_MON_FLAGS_INT_PENDING)) | IOX_MON_FLAGS_READING;
+    SEI();
+
+    if (!ciox_in(pIox)) {
+        pController->releaseResources();
+
+        CLI_ONLY();
+        flags = (flags & ~IOX_MON_FLAGS_READING) | IOX_MON_FLAGS_INT_PENDING;
+        SEI();
+
+        resumeMicros(IOX_INPUT_RETRY_MICROS);
+        return;
+    }
+
+    pController->releaseResources();
+    lastRead = sched_micros();
+    reads++;
+    resumeMicros(keepAliveMicros);
+}
+
+#endif // INCLUDE_IOX_MODULE
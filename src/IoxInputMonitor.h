@@ -0,0 +1,115 @@
+#ifndef SCHEDULER_IOXINPUTMONITOR_H
+#define SCHEDULER_IOXINPUTMONITOR_H
+
+#include "Scheduler.h"
+#include "Controller.h"
+#include "CIOExpander.h"
+#include "Signals.h"
+#include "ioxint.h"
+
+/**
+ * Reads IO expander inputs when its INT output signals a change instead of polling ciox_in().
+ *
+ * The pin change interrupt, see ioxint, only sets a pending flag and resumes the task, the task makes the ciox_in()
+ * request. When the read completes, inputs is updated and if it differs from the previous read the task triggers
+ * the signal, resuming the tasks waiting on it, which use haveChangedInputs() and clearChangedInputs() as before.
+ *
+ * Inputs are also read every keepAliveMicros, so a missed edge or an expander reset is recovered from. Without
+ * INCLUDE_IOX_INT there is no interrupt and the keep alive read is a plain poll at that period.
+ *
+ * Usage:
+ *
+ *     uint8_t inputSignalQueue[4];
+ *     Signal inputSignal(inputSignalQueue, sizeof(inputSignalQueue));
+ *     IoxInputMonitor ioxInputMonitor;
+ *
+ *     // in setup(), after the expander is initialized
+ *     ioxInputMonitor.init(&twiController, ioExpander.getHandle(), &inputSignal);
+ *     ioxint_init();
+ *
+ *     // in a task waiting for input changes
+ *     inputSignal.wait(this);
+ *
+ * The name of the instance is fixed, the interrupt and read callbacks use it.
+ */
+
+#ifndef IOX_INPUT_KEEP_ALIVE_MICROS
+#define IOX_INPUT_KEEP_ALIVE_MICROS     (500000L)   // fallback read period
+#endif
+
+#ifndef IOX_INPUT_RETRY_MICROS
+#define IOX_INPUT_RETRY_MICROS          (1000L)     // read retry delay when no request is free or the read failed
+#endif
+
+#define IOX_MON_FLAGS_INT_PENDING       (0x01)      // INT asserted, inputs need to be read
+#define IOX_MON_FLAGS_READING           (0x02)      // ciox_in() request outstanding
+#define IOX_MON_FLAGS_CHANGED           (0x04)      // read inputs differ from previous read, signal not triggered
+#define IOX_MON_FLAGS_RESERVING         (0x08)      // suspended waiting for controller resources, resumed by the lock
+
+class IoxInputMonitor : public Task {
+    Controller *pController;
+    CIOExpander_t *pIox;
+    Signal *pSignal;
+    time_t keepAliveMicros;
+    time_t lastRead;                            // sched_micros() of last read request
+    volatile uint8_t flags;
+    uint8_t readInputs;                         // inputs of previous read
+
+    uint16_t reads;
+    uint16_t changes;
+    uint16_t intEvents;
+    uint16_t readErrors;
+
+    static void inputsRead(const CByteStream_t *pStream, CIOExpander_t *pIox);
+
+public:
+    IoxInputMonitor();
+
+    /**
+     * Set the expander to monitor, starts with a read of the inputs
+     *
+     * @param pController       controller of the expander's bus
+     * @param pIox              expander
+     * @param pSignal           signal triggered when inputs change, NULL if none
+     * @param keepAliveMicros   read period without interrupts
+     */
+    void init(Controller *pController, CIOExpander_t *pIox, Signal *pSignal = NULL, time_t keepAliveMicros = IOX_INPUT_KEEP_ALIVE_MICROS);
+
+    void begin() override;
+
+    void loop() override;
+
+    /**
+     * INT asserted, IMPORTANT: called from interrupt
+     */
+    void intEvent();
+
+    /**
+     * Read of inputs completed, IMPORTANT: called from interrupt
+     *
+     * @param error     error of the read request, 0 if none, inputs are read again after IOX_INPUT_RETRY_MICROS
+     */
+    void readDone(uint8_t error);
+
+    NO_DISCARD inline uint16_t getReads() const {
+        return reads;
+    }
+
+    NO_DISCARD inline uint16_t getChanges() const {
+        return changes;
+    }
+
+    NO_DISCARD inline uint16_t getIntEvents() const {
+        return intEvents;
+    }
+
+    NO_DISCARD inline uint16_t getReadErrors() const {
+        return readErrors;
+    }
+
+    defineSchedulerTaskId("IoxInputMonitor");
+};
+
+extern IoxInputMonitor ioxInputMonitor;
+
+#endif //SCHEDULER_IOXINPUTMONITOR_H
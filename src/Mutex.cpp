@@ -18,8 +18,8 @@ uint8_t Mutex::reserve(uint8_t taskId) {
             Task *pTask = scheduler.getTask(taskId);
 
             if (pTask && pTask->isAsync()) {
-                reinterpret_cast<AsyncTask *>(pTask)->yieldSuspend();
-                return 0;
+                // fails when ASYNC_STACK_POOL is exhausted, then it waits in the queue suspended like a Task
+                return reinterpret_cast<AsyncTask *>(pTask)->yieldSuspend();
             } else {
                 scheduler.suspend(taskId);
                 return 1;
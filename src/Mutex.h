@@ -40,7 +40,7 @@ public:
      * If the resource is not available, suspend the task and if possible yield.
      *
      * @return 0 if successfully yielded and resource reserved. 1 if not available and could not yield to wait
-     *           for it, in case of non-async tasks.
+     *           for it, in case of non-async tasks or an async task when ASYNC_STACK_POOL is exhausted.
      */
     uint8_t reserve()
     {
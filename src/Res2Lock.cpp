@@ -5,6 +5,11 @@
 #include "debug_config.h"
 
 uint8_t Res2Lock::reserve(uint8_t taskId, uint8_t available1, uint8_t available2) {
+    if (owner == taskId) {
+        // resumed by makeAvailable() as the owner, a suspended Task calls reserve() again when its loop() is resumed
+        return 0;
+    }
+
     if (isMaxAvailable(available1, available2)) {
         Task *pTask = scheduler.getTask(taskId);
         if (pTask) {
@@ -48,8 +53,9 @@ uint8_t Res2Lock::reserve(uint8_t taskId, uint8_t available1, uint8_t available2
             SEI();
 
             if (pTask->isAsync()) {
-                reinterpret_cast<AsyncTask *>(pTask)->yieldSuspend();
-                return 0;
+                // fails when ASYNC_STACK_POOL is exhausted, the task waits suspended like a Task and its loop() calls
+                // reserve() again when resumed as the owner
+                return reinterpret_cast<AsyncTask *>(pTask)->yieldSuspend();
             } else {
                 scheduler.suspend(taskId);
                 return 1;
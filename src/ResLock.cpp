@@ -34,8 +34,7 @@ uint8_t ResLock::reserve(uint8_t taskId, uint8_t available1) {
             resQueue.addTail(available1);
 
             if (pTask->isAsync()) {
-                reinterpret_cast<AsyncTask *>(pTask)->yieldSuspend();
-                return 0;
+                return reinterpret_cast<AsyncTask *>(pTask)->yieldSuspend();
             } else {
                 scheduler.suspend(taskId);
                 return 1;
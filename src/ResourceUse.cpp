@@ -8,7 +8,7 @@ ResourceUse::ResourceUse(const char *name) {
 uint8_t ResourceUse::canDump(uint32_t *pLastDump, uint16_t delayMs) {
     if (!pLastDump || !delayMs) return 1;
 
-    uint32_t mic = micros();
+    uint32_t mic = sched_micros();
     if (*pLastDump + delayMs * 1000L <= mic) {
         *pLastDump = mic;
         return 1;
@@ -4,6 +4,7 @@
 
 #include <Arduino.h>
 #include <stdint.h>
+#include "SchedClock.h"
 
 #ifndef RESOURCE_TRACE_INTERVAL_MS
 #define RESOURCE_TRACE_INTERVAL_MS  (2000)
@@ -0,0 +1,66 @@
+#include "SchedClock.h"
+
+#ifdef SCHED_CLOCK_TIMER1
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+volatile uint32_t sched_clock_overflows;
+
+void sched_clock_begin(void) {
+    CLI();
+    TCCR1A = 0;
+    TCCR1B = (1 << CS11);       // normal mode, F_CPU/8
+    TCNT1 = 0;
+    TIFR1 = (1 << TOV1);
+    TIMSK1 |= (1 << TOIE1);
+    sched_clock_overflows = 0;
+    SEI();
+}
+
+ISR(TIMER1_OVF_vect) {
+    sched_clock_overflows++;
+}
+
+// IMPORTANT: must be called with interrupts disabled
+static inline time_t sched_clock_to_micros(uint16_t ticks) {
+    uint32_t overflows = sched_clock_overflows;
+
+    // overflow pending and ticks were read after it, count it
+    if ((TIFR1 & (1 << TOV1)) && ticks < 0x8000) {
+        overflows++;
+    }
+
+    return (overflows << (16 - SCHED_CLOCK_TICK_SHIFT)) + (ticks >> SCHED_CLOCK_TICK_SHIFT);
+}
+
+time_t sched_micros(void) {
+    CLI();
+    time_t now = sched_clock_to_micros(TCNT1);
+    SEI();
+    return now;
+}
+
+time_t sched_clock_capture_micros(uint16_t icr) {
+    CLI();
+    uint32_t overflows = sched_clock_overflows;
+    uint16_t ticks = TCNT1;
+
+    if ((TIFR1 & (1 << TOV1)) && ticks < 0x8000) {
+        overflows++;
+    }
+
+    // capture is before now, if timer wrapped since then it was in the previous overflow period
+    if (icr > ticks) {
+        overflows--;
+    }
+    SEI();
+
+    return (overflows << (16 - SCHED_CLOCK_TICK_SHIFT)) + (icr >> SCHED_CLOCK_TICK_SHIFT);
+}
+
+#elif defined(SCHED_CLOCK_VIRTUAL)
+
+volatile time_t sched_clock_virtual_micros;
+
+#endif
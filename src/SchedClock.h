@@ -0,0 +1,91 @@
+#ifndef SCHEDULER_SCHEDCLOCK_H
+#define SCHEDULER_SCHEDCLOCK_H
+
+/*
+ * Microsecond clock source used by Scheduler, StaticScheduler, twiint, twi_wait() and ResourceUse.
+ *
+ * Select one with a compile definition, default is Arduino micros():
+ *
+ *   SCHED_CLOCK_TIMER1     Timer1 free running at F_CPU/8, overflows counted in TIMER1_OVF_vect. Resolution is
+ *                          0.5us at 16MHz vs 4us for micros(), and sched_clock_capture_micros() converts an ICR1
+ *                          input capture value to the same time base. Timer1 is not available for PWM or Servo.
+ *                          Call sched_clock_begin() before scheduler.begin().
+ *
+ *   SCHED_CLOCK_VIRTUAL    host virtual clock, only moves when advanced by sched_clock_advance_micros() or set by
+ *                          sched_clock_set_micros(). Opt-in for CONSOLE_DEBUG builds driven by SimRuntime, makes
+ *                          scheduling deterministic. Busy waits, e.g. twi_wait(), advance it with
+ *                          SimRuntime::waitMicros(). CONSOLE_DEBUG builds which call scheduler.loop() themselves
+ *                          keep the default micros() clock.
+ */
+
+#ifdef CONSOLE_DEBUG
+#include <time.h>
+#endif
+
+#include "Arduino.h"
+#include "common_defs.h"
+
+#if defined(SCHED_CLOCK_TIMER1) && defined(SCHED_CLOCK_VIRTUAL)
+#error "SchedClock: only one of SCHED_CLOCK_TIMER1 or SCHED_CLOCK_VIRTUAL can be defined"
+#endif
+
+#ifdef SCHED_CLOCK_TIMER1
+#if F_CPU == 16000000UL
+#define SCHED_CLOCK_TICK_SHIFT  (1)     // 2 ticks per microsecond
+#elif F_CPU == 8000000UL
+#define SCHED_CLOCK_TICK_SHIFT  (0)     // 1 tick per microsecond
+#else
+#error "SchedClock: SCHED_CLOCK_TIMER1 needs F_CPU of 8MHz or 16MHz"
+#endif
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef SCHED_CLOCK_TIMER1
+
+extern volatile uint32_t sched_clock_overflows;
+
+/**
+ * Start Timer1 as clock source, normal mode, F_CPU/8 prescaler and overflow interrupt enabled
+ */
+extern void sched_clock_begin(void);
+
+/**
+ * Get clock microseconds, safe to call from interrupts
+ *
+ * @return  microseconds since sched_clock_begin(), wraps around at 0xffffffff
+ */
+extern time_t sched_micros(void);
+
+/**
+ * Convert input capture value to clock microseconds. Must be called in TIMER1_CAPT_vect or before the
+ * timer overflows twice after the capture.
+ *
+ * @param icr   captured ICR1 value
+ * @return      clock microseconds of the capture
+ */
+extern time_t sched_clock_capture_micros(uint16_t icr);
+
+#elif defined(SCHED_CLOCK_VIRTUAL)
+
+extern volatile time_t sched_clock_virtual_micros;
+
+#define sched_clock_begin()                 ((void)0)
+#define sched_micros()                      (sched_clock_virtual_micros)
+#define sched_clock_set_micros(us)          (sched_clock_virtual_micros = (time_t)(us))
+#define sched_clock_advance_micros(us)      (sched_clock_virtual_micros += (time_t)(us))
+
+#else
+
+#define sched_clock_begin()                 ((void)0)
+#define sched_micros()                      ((time_t) micros())
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //SCHEDULER_SCHEDCLOCK_H
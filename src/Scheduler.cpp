@@ -1,7 +1,11 @@
 #include "Arduino.h"
 #include "Scheduler.h"
 
-Scheduler::Scheduler(uint8_t count, const char *taskTable, time_t *delayTable) {
+#ifdef SCHED_READY_BITMAP
+Scheduler::Scheduler(uint8_t count, const char *taskTable, sched_time_t *delayTable, uint8_t *bitmapTable) {
+#else
+Scheduler::Scheduler(uint8_t count, const char *taskTable, sched_time_t *delayTable) {
+#endif
     taskCount = count;
     tasks = taskTable;
     taskTimes = delayTable;
@@ -12,6 +16,16 @@ Scheduler::Scheduler(uint8_t count, const char *taskTable, time_t *delayTable) {
 #ifdef SERIAL_DEBUG_SCHEDULER
     iteration = 0;
 #endif
+#ifdef SCHED_READY_BITMAP
+    readyBits = bitmapTable;
+    suspendedBits = bitmapTable + sizeOfSchedulerBitmaps(count) / 2;
+    haveWakeMicros = 0;
+    nextWakeMicros = 0;
+#endif
+#ifdef SCHED_TIME64
+    microsHigh = 0;
+    lastMicros = 0;
+#endif
 }
 
 Task *Scheduler::getTask(uint8_t taskId) {
@@ -24,6 +38,11 @@ Task *Scheduler::getTask(uint8_t taskId) {
 void Scheduler::begin() {
     // start off with all suspended
     memset(taskTimes, 0, sizeof(*taskTimes) * taskCount);
+#ifdef SCHED_READY_BITMAP
+    memset(readyBits, 0, sizeOfSchedulerBitmaps(taskCount) / 2);
+    memset(suspendedBits, 0xff, sizeOfSchedulerBitmaps(taskCount) / 2);
+    haveWakeMicros = 0;
+#endif
 
 #if defined(DEBUG_MODE_SCHEDULER_VALIDATE) && defined(SERIAL_DEBUG_SCHEDULER_ERRORS)
     for (uint8_t i = 0; i < taskCount; i++) {
@@ -36,7 +55,11 @@ void Scheduler::begin() {
     }
 #endif
 
-    startLoopMicros = micros();
+#ifdef SERIAL_DEBUG_SCHEDULER_MAX_STACKS
+    stack_paint();
+#endif
+
+    startLoopMicros = sched_micros();
     for (uint8_t i = 0; i < taskCount; i++) {
         pTask = getTask(i);
         pTask->taskId = i;
@@ -50,19 +73,155 @@ void Scheduler::begin() {
 #ifdef SERIAL_DEBUG_SCHEDULER_DELAYS
 
 void Scheduler::dumpDelays(PGM_P msg) {
-    uint32_t now = micros();
+    uint32_t now = sched_micros();
     serialDebugPrintf_P(PSTR("%S %ld\n"), msg, now);
 
     for (uint8_t i = 0; i < taskCount; i++) {
         Task *pTask = getTask(i);
-        serialDebugPrintf_P(PSTR("%S [%d] @ %ld in %ld\n"), pTask->id(), pTask->taskId, taskTimes[i], elapsed_micros(now, taskTimes[i]));
+        serialDebugPrintf_P(PSTR("%S [%d] @ %ld in %ld\n"), pTask->id(), pTask->taskId, (time_t) taskTimes[i], elapsed_micros(now, (time_t) taskTimes[i]));
     }
 }
 
 #endif
 
+#ifdef SCHED_READY_BITMAP
+
+// IMPORTANT: must be called with interrupts disabled
+void Scheduler::setWakeMicros(sched_time_t endTime) {
+    if (!haveWakeMicros || !isTimeElapsed(endTime, nextWakeMicros)) {
+        nextWakeMicros = endTime;
+        haveWakeMicros = 1;
+    }
+}
+
+/**
+ * Move sleeping tasks whose delay has elapsed to the ready bitmap and compute next wake time from the rest.
+ *
+ * @param now   micros()
+ */
+void Scheduler::wakeSleepingTasks(sched_time_t now) {
+    haveWakeMicros = 0;
+
+    const uint8_t nBytes = sizeOfSchedulerBitmaps(taskCount) / 2;
+    for (uint8_t i = 0; i < nBytes; i++) {
+        CLI();
+        uint8_t sleeping = ~(readyBits[i] | suspendedBits[i]);
+        if (i == nBytes - 1 && (taskCount & 0x07)) {
+            sleeping &= (1 << (taskCount & 0x07)) - 1;
+        }
+
+        while (sleeping) {
+            const uint8_t bit = __builtin_ctz(sleeping);
+            const uint8_t mask = 1 << bit;
+            sleeping &= ~mask;
+
+            const sched_time_t endTime = taskTimes[(i << 3) + bit];
+            if (isTimeElapsed(now, endTime)) {
+                readyBits[i] |= mask;
+            } else {
+                setWakeMicros(endTime);
+            }
+        }
+        SEI();
+    }
+}
+
+/**
+ * Find first ready task with id in [id, end)
+ *
+ * @param id    first task id to test
+ * @param end   id past last task to test
+ * @return      ready task id or NULL_TASK if none
+ */
+uint8_t Scheduler::findReadyTask(uint8_t id, uint8_t end) {
+    while (id < end) {
+        uint8_t bits = readyBits[id >> 3] >> (id & 0x07);
+        if (bits) {
+            id += __builtin_ctz(bits);
+            return id < end ? id : NULL_TASK;
+        }
+        id = (id & ~0x07) + 8;
+    }
+    return NULL_TASK;
+}
+
+#endif // SCHED_READY_BITMAP
+
+/**
+ * Run ready task and check time slice
+ *
+ * @param id            ready task id
+ * @param tick          micros() at start of loop
+ * @param timeSlice     loop time slice, 0 if none
+ * @param hadTask       set if task is traced
+ * @param now           set to clock time after the task ran, used as the cached time for the rest of the pass
+ * @return              1 if time slice ended, next loop will continue with the task after this one
+ */
+inline uint8_t Scheduler::runReadyTask(uint8_t id, time_t tick, time_t timeSlice, uint8_t &hadTask, sched_time_t &now) {
+#ifdef SERIAL_DEBUG_SCHEDULER
+    const time_t start = startTaskMicros;
+#endif
+
+    // the task is ready
+    Task *const pRunTask = getTask(id);
+    pTask = pRunTask;
+
+    if (!(pRunTask->getFlags() & TASK_DBG_FLAGS_NO_SCHED)) {
+        hadTask |= 1;
+    }
+
+#ifdef SERIAL_DEBUG_SCHEDULER_CLI
+    uint8_t oldSREG = SREG;
+#endif
+    executeTask();
+#ifdef SERIAL_DEBUG_SCHEDULER_CLI
+    uint8_t newSREG = SREG;
+#endif
+
+    pTask = NULL;
+
+    now = getMicros();
+    const time_t end = (time_t) now;
+
+#ifdef SCHED_TASK_ACTIVE
+    pRunTask->activeTaskMicros += end - startTaskMicros;
+    startTaskMicros = 0;
+#endif
+
+    if (timeSlice && isElapsed(end, timeSlice + tick)) {
+#ifdef SERIAL_DEBUG_SCHEDULER
+        if (!(pRunTask->getFlags() & TASK_DBG_FLAGS_NO_SCHED)) {
+            debugSchedulerPrintf_P(PSTR("Scheduler[%u] time slice ended %lu limit %u last getTask %S[%d] took %lu\n"), iteration, (uint32_t) (end - tick), timeSlice, pRunTask->id(), pRunTask->taskId, (uint32_t) (end - start));
+        }
+#endif
+
+        // next time continue checking after the current getTask
+        nextTask = id + 1;
+        if (nextTask >= taskCount) nextTask = 0;
+        return 1;
+    }
+
+    if (hadTask) {
+        debugSchedulerPrintf_P(PSTR("Scheduler[%d] %S[%d] done in %lu\n"), iteration, pRunTask->id(), pRunTask->taskId, elapsed_micros(start, end));
+
+#ifdef SERIAL_DEBUG_SCHEDULER_CLI
+        if ((oldSREG & 0x80) && !(newSREG & 0x80)) {
+            serialDebugSchedulerCliPrintf_P(PSTR("Sched: task %S, interrupts disabled, last %S:%d:%d\n"), pRunTask->id(), pCliFile, nCliLine, nSeiLine);
+        }
+#endif
+    }
+
+#ifdef SERIAL_DEBUG_SCHEDULER_CLI
+    // KLUDGE: if interrupts are disabled in a task, enable them here
+    sei();
+#endif
+    return 0;
+}
+
 void Scheduler::loopMicros(time_t timeSlice) {
-    const time_t tick = micros();
+    // clock is read here and after each task that runs, not for every task slot
+    sched_time_t now = getMicros();
+    const time_t tick = (time_t) now;
 
 #if defined(SCHED_MIN_LOOP_TIMESLICE_MICROS) && SCHED_MIN_LOOP_TIMESLICE_MICROS
     if (!isElapsed(tick, startLoopMicros + SCHED_MIN_LOOP_TIMESLICE_MICROS)) {
@@ -83,73 +242,58 @@ void Scheduler::loopMicros(time_t timeSlice) {
     // offset task index by nextTask so we can interrupt at a getTask
     // and continue with the same getTask next time slice
     uint8_t lastId = -1;
-    time_t timeSliceLimit = timeSlice + tick;
     uint8_t hadTask = 0;
 
-    for (uint8_t i = 0; i < taskCount; i++) {
-        uint8_t id = i + nextTask;
-        if (id >= taskCount) id -= taskCount;
-        lastId = id;
-
-        startTaskMicros = micros();
-        time_t start = startTaskMicros;
+#ifdef SCHED_READY_BITMAP
+    CLI();
+    const uint8_t needWake = haveWakeMicros && isTimeElapsed(now, nextWakeMicros);
+    SEI();
 
-        if (taskTimes[id] == TASK_DELAY_SUSPENDED || !isElapsed(startTaskMicros, taskTimes[id])) continue;
-
-        // the task is ready
-        pTask = getTask(id);
+    if (needWake) {
+        wakeSleepingTasks(now);
+    }
 
-        if (!(pTask->getFlags() & TASK_DBG_FLAGS_NO_SCHED)) {
-            hadTask |= 1;
+    // visit ready tasks in [nextTask, taskCount) then in [0, nextTask)
+    const uint8_t firstTask = nextTask;
+    uint8_t id = firstTask;
+    uint8_t end = taskCount;
+    uint8_t wrapped = !firstTask;
+
+    for (;;) {
+        id = findReadyTask(id, end);
+        if (id == NULL_TASK) {
+            if (wrapped) break;
+            wrapped = 1;
+            end = firstTask;
+            id = 0;
+            continue;
         }
 
-#ifdef SERIAL_DEBUG_SCHEDULER_CLI
-        uint8_t oldSREG = SREG;
-#endif
-        executeTask();
-#ifdef SERIAL_DEBUG_SCHEDULER_CLI
-        uint8_t newSREG = SREG;
-#endif
-
-        Task *pLastTask = pTask;
-        pTask = NULL;
-
-        time_t end = micros();
-
-#ifdef SCHED_TASK_ACTIVE
-        pLastTask->activeTaskMicros += end - startTaskMicros;
-        startTaskMicros = 0;
-#endif
-
-        if (timeSlice && isElapsed(tick, timeSliceLimit)) {
-#ifdef SERIAL_DEBUG_SCHEDULER
-            if (!(pTask->getFlags() & TASK_DBG_FLAGS_NO_SCHED)) {
-                debugSchedulerPrintf_P(PSTR("Scheduler[%u] time slice ended %lu limit %u last getTask %S[%d] took %lu\n"), iteration, (uint32_t) (end - tick), timeSlice, pLastTask->id(), pLastTask->taskId, (uint32_t) (end - start));
-            }
-#endif
+        lastId = id;
+        startTaskMicros = (time_t) now;
 
-            // next time continue checking after the current getTask
-            nextTask = id + 1;
-            if (nextTask >= taskCount) nextTask = 0;
+        if (runReadyTask(id, tick, timeSlice, hadTask, now)) {
             lastId = -1;
             break;
         }
+        id++;
+    }
+#else
+    for (uint8_t i = 0; i < taskCount; i++) {
+        uint8_t id = i + nextTask;
+        if (id >= taskCount) id -= taskCount;
+        lastId = id;
 
-        if (hadTask) {
-            debugSchedulerPrintf_P(PSTR("Scheduler[%d] %S[%d] done in %lu\n"), iteration, pLastTask->id(), pLastTask->taskId, elapsed_micros(start, end));
+        if (taskTimes[id] == TASK_DELAY_SUSPENDED || !isTimeElapsed(now, taskTimes[id])) continue;
 
-#ifdef SERIAL_DEBUG_SCHEDULER_CLI
-            if ((oldSREG & 0x80) && !(newSREG & 0x80)) {
-                serialDebugSchedulerCliPrintf_P(PSTR("Sched: task %S, interrupts disabled, last %S:%d:%d\n"), pLastTask->id(), pCliFile, nCliLine, nSeiLine);
-            }
-#endif
-        }
+        startTaskMicros = (time_t) now;
 
-#ifdef SERIAL_DEBUG_SCHEDULER_CLI
-        // KLUDGE: if interrupts are disabled in a task, enable them here
-        sei();
-#endif
+        if (runReadyTask(id, tick, timeSlice, hadTask, now)) {
+            lastId = -1;
+            break;
+        }
     }
+#endif
 
     if (lastId != (uint8_t) -1) {
         // all ran, next time start with the first
@@ -158,18 +302,22 @@ void Scheduler::loopMicros(time_t timeSlice) {
 
 #ifdef SERIAL_DEBUG_SCHEDULER
     if (hadTask) {
-        uint32_t time = micros();
+        uint32_t time = sched_micros();
         debugSchedulerPrintf_P(PSTR("Scheduler end run %ld\n"), elapsed_micros(tick, time));
     }
 #endif
 
-    flags &= SCHED_FLAGS_IN_LOOP;
+    flags &= ~SCHED_FLAGS_IN_LOOP;
 }
 
 void Scheduler::executeTask() {
     if (pTask->isAsync()) {
         AsyncTask *pAsyncTask = reinterpret_cast<AsyncTask *>(pTask);
         pAsyncTask->clearFlags(TASK_DBG_FLAGS_FAKE_YIELD);
+#ifdef SERIAL_DEBUG_SCHEDULER_MAX_STACKS
+        const uint16_t depth = stack_depth();
+        if (pAsyncTask->maxResumeDepth < depth) pAsyncTask->maxResumeDepth = depth;
+#endif
         resumeContext(pAsyncTask->pContext);
 #ifdef SERIAL_DEBUG_SCHEDULER_CLI
         if (pAsyncTask->getFlags() & TASK_DBG_FLAGS_FAKE_YIELD) {
@@ -178,8 +326,10 @@ void Scheduler::executeTask() {
 #endif
 #ifdef SERIAL_DEBUG_SCHEDULER_MAX_STACKS
         if (pAsyncTask->maxStackUsed() > pAsyncTask->maxStack()) {
-            serialDebugPrintf_P(PSTR("Sched: task %S stack %d > max %d\n"), pAsyncTask->id(), pAsyncTask->maxStackUsed(), pAsyncTask->maxStack());
-            for (;;);
+            // saved stack overran its buffer, the task cannot be safely resumed
+            serialDebugPrintf_P(PSTR("Sched: task %S stack %d > max %d, suspended\n"), pAsyncTask->id(), pAsyncTask->maxStackUsed(), pAsyncTask->maxStack());
+            suspend(pAsyncTask);
+            dumpMaxStackInfo();
         }
 #endif
     } else {
@@ -197,40 +347,130 @@ bool Scheduler::isSuspended(Task *task) {
     return taskTimes[task->taskId] == TASK_DELAY_SUSPENDED;
 }
 
+uint8_t Scheduler::getNextResumeMicros(sched_time_t &time) {
+    uint8_t haveTime = 0;
+
+    for (uint8_t i = 0; i < taskCount; i++) {
+        CLI();
+        const sched_time_t taskTime = taskTimes[i];
+        SEI();
+
+        if (taskTime == TASK_DELAY_SUSPENDED) continue;
+
+        if (!haveTime || !isTimeElapsed(taskTime, time)) {
+            time = taskTime;
+            haveTime = 1;
+        }
+    }
+    return haveTime;
+}
+
 /**
  * Set current getCurrentTask's delay to infinite
  */
 void Scheduler::suspend(uint8_t taskId) {
+#ifdef SCHED_READY_BITMAP
+    CLI();
     taskTimes[taskId] = TASK_DELAY_SUSPENDED;
+    readyBits[taskId >> 3] &= ~(1 << (taskId & 0x07));
+    suspendedBits[taskId >> 3] |= 1 << (taskId & 0x07);
+    SEI();
+#else
+    taskTimes[taskId] = TASK_DELAY_SUSPENDED;
+#endif
+}
+
+/**
+ * Set task ready time and update ready bitmaps if used
+ *
+ * @param taskId    task index
+ * @param endTime   time when task is ready to run
+ * @param isReady   true if endTime has already elapsed
+ */
+#ifdef SCHED_READY_BITMAP
+
+void Scheduler::setTaskTime(uint8_t taskId, sched_time_t endTime, uint8_t isReady) {
+    const uint8_t mask = 1 << (taskId & 0x07);
+
+    // NOTE: can be called from interrupts, e.g. Res2Lock::makeAvailable()
+    CLI();
+    taskTimes[taskId] = endTime;
+    suspendedBits[taskId >> 3] &= ~mask;
+    if (!isReady) {
+        readyBits[taskId >> 3] &= ~mask;
+        setWakeMicros(endTime);
+    } else {
+        readyBits[taskId >> 3] |= mask;
+    }
+    SEI();
 }
 
+#else
+
+// isReady is only needed for the ready bitmap
+void Scheduler::setTaskTime(uint8_t taskId, sched_time_t endTime, uint8_t) {
+    taskTimes[taskId] = endTime;
+}
+
+#endif
+
 void Scheduler::resumeMicros(uint8_t taskId, time_t microseconds) {
 #ifdef SERIAL_DEBUG_SCHEDULER_VALIDATE
     if (taskId < taskCount) {
 #endif
-    if (microseconds >= TASK_DELAY_MAX) {
-        microseconds = TASK_DELAY_MAX - 1;
+#ifdef SCHED_TIME64
+    // no need to clamp the delay, 64 bit time will not wrap
+    sched_time_t endTime = getMicros() + microseconds;
+    if (endTime == TASK_DELAY_SUSPENDED) endTime++;
+    setTaskTime(taskId, endTime, !microseconds);
+#else
+    setTaskTime(taskId, resume_time_micros(microseconds), !microseconds);
+#endif
+#ifdef SERIAL_DEBUG_SCHEDULER_VALIDATE
     }
+#endif
+}
 
-    time_t endTime = (time_t) (microseconds + micros());
-    if (endTime == TASK_DELAY_SUSPENDED) endTime++;
-    taskTimes[taskId] = endTime;
+void Scheduler::resumeAt(uint8_t taskId, sched_time_t time) {
+#ifdef SERIAL_DEBUG_SCHEDULER_VALIDATE
+    if (taskId < taskCount) {
+#endif
+    if (time == TASK_DELAY_SUSPENDED) time++;
+    setTaskTime(taskId, time, isTimeElapsed(getMicros(), time));
 #ifdef SERIAL_DEBUG_SCHEDULER_VALIDATE
     }
 #endif
 }
 
-time_t Scheduler::getResumeMicros(uint8_t taskId) {
+sched_time_t Scheduler::getResumeMicros(uint8_t taskId) {
 #ifdef SERIAL_DEBUG_SCHEDULER_VALIDATE
     if (taskId < taskCount) {
         return taskTimes[taskId];
     }
-    return micros();
+    return getMicros();
 #else
     return taskTimes[taskId];
 #endif
 }
 
+#ifdef SCHED_TIME64
+
+sched_time_t Scheduler::getMicros() {
+    // NOTE: can be called from interrupts, e.g. resumeMicros() from Res2Lock::makeAvailable()
+    CLI();
+    const time_t now = sched_micros();
+    if (now < lastMicros) {
+        // micros() wrapped around
+        microsHigh++;
+    }
+    lastMicros = now;
+    const sched_time_t time = ((sched_time_t) microsHigh << 32) | now;
+    SEI();
+    return time;
+}
+
+#endif
+
 uint8_t Scheduler::getCurrentTaskId() {
     return pTask ? pTask->taskId : NULL_TASK;
 }
@@ -255,6 +495,22 @@ int32_t elapsed_micros(time_t startTime, time_t endTime) {
     return (int32_t) diff;
 }
 
+/**
+ * Get task resume timestamp for given delay from now, clamped to TASK_DELAY_MAX and never TASK_DELAY_SUSPENDED.
+ *
+ * @param microseconds  delay from now
+ * @return              micros() timestamp when delay will have elapsed
+ */
+time_t resume_time_micros(time_t microseconds) {
+    if (microseconds >= TASK_DELAY_MAX) {
+        microseconds = TASK_DELAY_MAX - 1;
+    }
+
+    time_t endTime = (time_t) (microseconds + sched_micros());
+    if (endTime == TASK_DELAY_SUSPENDED) endTime++;
+    return endTime;
+}
+
 /**
  * Test if endTime has elapsed past now. ie. difference is -ve
  *
@@ -281,15 +537,18 @@ uint8_t is_elapsed(time_t now, time_t endTime) {
 
 time_t Task::getCurrentActiveMicros() const {
 #ifdef SCHED_TASK_ACTIVE
-    return activeTaskMicros + (micros() - scheduler.startTaskMicros);
+    return activeTaskMicros + (sched_micros() - scheduler.startTaskMicros);
 #else
-    return micros();
+    return sched_micros();
 #endif
 }
 
 AsyncTask::AsyncTask(uint8_t *pStack, uint8_t stackMax) : Task() {
     // NOLINT(cppcoreguidelines-pro-type-member-init)
     pContext = (AsyncContext *) pStack;
+#ifdef SERIAL_DEBUG_SCHEDULER_MAX_STACKS
+    maxResumeDepth = 0;
+#endif
     initContext(pStack, AsyncTask::yieldingLoop, this, stackMax);
 }
 
@@ -298,13 +557,14 @@ AsyncTask::AsyncTask(uint8_t *pStack, uint8_t stackMax) : Task() {
  * If successfully yielded, this function will return after the task is resumed.
  *
  * If the task is not the current context, it will not yield and return immediately.
- * Check return value for true if it did not yield and handle it, if needed.
+ * Check return value for true if it did not yield and handle it, if needed. With ASYNC_STACK_POOL it does not
+ * yield when the pool is exhausted, the task stays suspended.
  *
- * @return 0 if successfully yielded. 1 if no yield because was not the active task
+ * @return 0 if successfully yielded. 1 if no yield
  */
-void AsyncTask::yieldSuspend() {
+uint8_t AsyncTask::yieldSuspend() {
     suspend();
-    yieldContext();
+    return yieldContext();
 }
 
 /**
@@ -314,10 +574,11 @@ void AsyncTask::yieldSuspend() {
  * If there is no async context, it will not yield and return immediately.
  *
  * @param microseconds delay in microseconds before resuming task
+ * @return 0 if successfully yielded. 1 if no yield, ASYNC_STACK_POOL exhausted
  */
-void AsyncTask::yieldResumeMicros(time_t microseconds) {
+uint8_t AsyncTask::yieldResumeMicros(time_t microseconds) {
     resumeMicros(microseconds);
-    yieldContext();
+    return yieldContext();
 }
 
 #ifdef SERIAL_DEBUG_SCHEDULER_MAX_STACKS
@@ -336,16 +597,16 @@ void AsyncTask::fakeYield() {
  * Check return value for true if it did not yield and handle it, if needed.
  *
  * @param milliseconds delay in milliseconds to wait before resuming calls to loop()
- * @return 0 if successfully yielded. 1 if no yield because was not the active task
+ * @return 0 if successfully yielded. 1 if no yield, ASYNC_STACK_POOL exhausted
  */
-void AsyncTask::yieldResume(uint16_t milliseconds) {
+uint8_t AsyncTask::yieldResume(uint16_t milliseconds) {
     resume(milliseconds);
-    yieldContext();
+    return yieldContext();
 }
 
-void AsyncTask::yield() {
+uint8_t AsyncTask::yield() {
     resume(0);
-    yieldContext();
+    return yieldContext();
 }
 
 uint8_t AsyncTask::hasYielded() const {
@@ -367,7 +628,40 @@ void AsyncTask::yieldingLoop(void *arg) {
 #ifdef SERIAL_DEBUG_SCHEDULER_MAX_STACKS
 
 void Scheduler::dumpMaxStackInfo() {
-    // TODO: implement
+    debugSchedulerMaxStacksPrintf_P(PSTR("Sched: stacks, task: max used resume peak\n"));
+
+    for (uint8_t i = 0; i < taskCount; i++) {
+        Task *pStackTask = getTask(i);
+        if (!pStackTask->isAsync()) continue;
+
+        AsyncTask *pAsyncTask = reinterpret_cast<AsyncTask *>(pStackTask);
+        const uint16_t resumeDepth = pAsyncTask->getMaxResumeDepth();
+
+        debugSchedulerMaxStacksPrintf_P(PSTR("  %S[%d]: %d %d %u %u%S\n"), pAsyncTask->id(), i
+                                        , pAsyncTask->maxStack(), pAsyncTask->maxStackUsed()
+                                        , resumeDepth, resumeDepth + pAsyncTask->maxStackUsed()
+                                        , pAsyncTask->maxStackUsed() > pAsyncTask->maxStack() ? PSTR(" OVERFLOW") : PSTR(""));
+    }
+
+    debugSchedulerMaxStacksPrintf_P(PSTR("  main: depth %u peak %u free %u\n"), stack_depth(), stack_max_depth(), stack_unused());
+
+#if defined(ASYNC_STACK_POOL) && !defined(CONSOLE_DEBUG)
+    debugSchedulerMaxStacksPrintf_P(PSTR("  pool: used %u peak %u failures %d\n"), stack_pool_used, stack_pool_max_used, stack_pool_failures);
+#endif
+
+#if defined(SERIAL_DEBUG_SCHEDULER_STACK_SIZING) && !defined(ASYNC_STACK_POOL)
+    // peak is only for yields seen so far, task buffer holds a byte count so size is limited to 255
+    for (uint8_t i = 0; i < taskCount; i++) {
+        Task *pStackTask = getTask(i);
+        if (!pStackTask->isAsync()) continue;
+
+        AsyncTask *pAsyncTask = reinterpret_cast<AsyncTask *>(pStackTask);
+        uint16_t size = pAsyncTask->maxStackUsed() + SCHED_STACK_SIZING_MARGIN;
+        if (size > 255) size = 255;
+
+        debugSchedulerMaxStacksPrintf_P(PSTR("  %S: sizeOfStack(%u), was %d\n"), pAsyncTask->id(), size, pAsyncTask->maxStack());
+    }
+#endif
 }
 
 #endif
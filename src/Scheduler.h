@@ -15,6 +15,15 @@
 
 #include "TinySwitcher.h"
 #include "common_defs.h"
+#include "SchedClock.h"
+
+#if defined(SERIAL_DEBUG_SCHEDULER_STACK_SIZING) && !defined(SERIAL_DEBUG_SCHEDULER_MAX_STACKS)
+#define SERIAL_DEBUG_SCHEDULER_MAX_STACKS
+#endif
+
+#ifdef SERIAL_DEBUG_SCHEDULER_MAX_STACKS
+#include "StackPaint.h"
+#endif
 
 #if defined(SERIAL_DEBUG_SCHEDULER) || defined(SERIAL_DEBUG_SCHEDULER_ERRORS) \
  || defined(SERIAL_DEBUG_SCHEDULER_DELAYS) || defined(SERIAL_DEBUG_SCHEDULER_MAX_STACKS) \
@@ -28,6 +37,14 @@
 #define TASK_DBG_FLAGS_NO_SCHED     (0x01) // don't debug trace task execution
 #define TASK_DBG_FLAGS_FAKE_YIELD   (0x02) // resume context right after yieldContext (used to simulate context switch for max stack determination)
 
+#ifdef SCHED_TIME64
+// monotonic 64 bit micros, extended by the scheduler from micros(), task times are stored as absolute 64 bit times
+// and compared without wrap around inference, so resume delays are not limited by TASK_DELAY_MAX
+typedef uint64_t sched_time_t;
+#else
+typedef time_t sched_time_t;
+#endif
+
 class Scheduler;
 
 // this must be declared in the main sketch
@@ -101,7 +118,7 @@ public:
 #ifdef SCHED_TASK_ACTIVE
         return activeTaskMicros;
 #else
-        return micros();
+        return sched_micros();
 #endif
     }
 
@@ -131,7 +148,14 @@ public:
      */
     bool isSuspended();
 
-    time_t getResumeMicros();
+    sched_time_t getResumeMicros();
+
+    /**
+     * Resume this task at given absolute scheduler time, @see Scheduler::resumeAt()
+     *
+     * @param time  scheduler time, Scheduler::getMicros() based
+     */
+    void resumeAt(sched_time_t time);
 };
 
 // this task can call blocking wait functions of the scheduler
@@ -140,6 +164,9 @@ class AsyncTask : public Task {
 
 protected:
     AsyncContext *pContext;
+#ifdef SERIAL_DEBUG_SCHEDULER_MAX_STACKS
+    uint16_t maxResumeDepth;        // deepest main stack at resumeContext() of this task
+#endif
 
     uint8_t isAsync() override {
         return true;
@@ -163,8 +190,13 @@ public:
      *
      * If the task is not the current context, it will not yield and return immediately.
      * Check return value for true if it did not yield and handle it, if needed.
+     *
+     * With ASYNC_STACK_POOL the yield fails when the pool has no free block for the stack. The task stays
+     * suspended, it should return from loop() which is called from the start when the task is resumed.
+     *
+     * @return 0 if successfully yielded. 1 if no yield
      */
-    void yieldSuspend();
+    uint8_t yieldSuspend();
 
     /**
      * Set the resume milliseconds and yield the task's execution context. If successfully yielded, this
@@ -173,8 +205,9 @@ public:
      * If there is no async context, it will not yield and return immediately.
      *
      * @param microseconds delay in microseconds before resuming task
+     * @return 0 if successfully yielded. 1 if no yield, ASYNC_STACK_POOL exhausted
      */
-    void yieldResumeMicros(time_t microseconds);
+    uint8_t yieldResumeMicros(time_t microseconds);
 
 #ifdef SERIAL_DEBUG_SCHEDULER_MAX_STACKS
     /**
@@ -190,13 +223,16 @@ public:
      * If the task is not the current context, it will not yield and return immediately.
      *
      * @param milliseconds delay in milliseconds before resuming task
+     * @return 0 if successfully yielded. 1 if no yield, ASYNC_STACK_POOL exhausted
      */
-    void yieldResume(uint16_t milliseconds);
+    uint8_t yieldResume(uint16_t milliseconds);
 
     /**
      * Yield cpu to other tasks. Returns to caller after the task was resumed.
+     *
+     * @return 0 if successfully yielded. 1 if no yield, ASYNC_STACK_POOL exhausted
      */
-    void yield();
+    uint8_t yield();
 
     /**
      * Test if the task has yielded or exited its loop function. Applies outside the task
@@ -216,6 +252,18 @@ public:
      */
     uint8_t maxStack() const;
 
+#ifdef SERIAL_DEBUG_SCHEDULER_MAX_STACKS
+    /**
+     * Get the deepest main stack at resumption of this task. The task's saved stack is restored on top of it, so main
+     * stack depth while the task runs is up to maxResumeDepth() + maxStackUsed() plus interrupts.
+     *
+     * @return maximum main stack depth in bytes at resumeContext() of this task
+     */
+    inline uint16_t getMaxResumeDepth() const {
+        return maxResumeDepth;
+    }
+#endif
+
 private:
     static void yieldingLoop(void *arg);
 };
@@ -225,12 +273,22 @@ private:
 
 #define SCHED_FLAGS_IN_LOOP     (0x01)           // scheduler is currently in loop() execution
 
+#ifndef SCHED_STACK_SIZING_MARGIN
+#define SCHED_STACK_SIZING_MARGIN (4)               // bytes added to measured peak for recommended sizeOfStack() values
+#endif
+
 #ifndef SCHED_MIN_LOOP_TIMESLICE_MICROS
 #define SCHED_MIN_LOOP_TIMESLICE_MICROS (250UL)      // least delay between loop() executions, ie. max resolution of task delay is this.
 #endif
 
+#ifdef SCHED_READY_BITMAP
+// Use this macro to allocate space for ready and suspended task bitmaps
+#define sizeOfSchedulerBitmaps(count)   (((count) + 7) / 8 * 2)
+#endif
+
 extern "C" uint8_t is_elapsed(time_t now, time_t endTime);
 extern "C" int32_t elapsed_micros(time_t startTime, time_t endTime);
+extern "C" time_t resume_time_micros(time_t microseconds);
 
 // inline time_t to_micros(uint16_t millis) {
 //     return millis * 1000UL;
@@ -242,7 +300,7 @@ class Scheduler {
 
     uint8_t flags;
     uint8_t taskCount;              // getTask count
-    time_t *taskTimes;              // task ready timestamp
+    sched_time_t *taskTimes;        // task ready timestamp
     PGM_P tasks;                    // pointer to task table
 
     // loop() invocation state variables
@@ -251,6 +309,27 @@ class Scheduler {
     time_t startLoopMicros;               // clock tick for last scheduler.loop() invocation
     time_t startTaskMicros;             // micros for last task invocation
 
+#ifdef SCHED_READY_BITMAP
+    // ready task bitmap mode, loop only visits ready tasks and sleeping tasks are checked when nextWakeMicros elapses
+    uint8_t *readyBits;             // bit set if task delay has elapsed
+    uint8_t *suspendedBits;         // bit set if task is suspended
+    volatile uint8_t haveWakeMicros; // true if nextWakeMicros is valid
+    sched_time_t nextWakeMicros;    // earliest resume time of sleeping tasks, ie. not ready and not suspended
+
+    void setWakeMicros(sched_time_t endTime);
+    void wakeSleepingTasks(sched_time_t now);
+    uint8_t findReadyTask(uint8_t id, uint8_t end);
+#endif
+
+#ifdef SCHED_TIME64
+    uint32_t microsHigh;            // high 32 bits of extended micros
+    time_t lastMicros;              // last micros() used to extend time, used to detect wrap around
+#endif
+
+    void setTaskTime(uint8_t taskId, sched_time_t endTime, uint8_t isReady);
+
+    inline uint8_t runReadyTask(uint8_t id, time_t tick, time_t timeSlice, uint8_t &hadTask, sched_time_t &now);
+
 
 #ifdef SERIAL_DEBUG_SCHEDULER
     uint16_t iteration;
@@ -274,6 +353,12 @@ public:
         return startLoopMicros;
     }
 
+    /**
+     * Get clock timestamp captured for the current task invocation. It is read once per pass and after each task
+     * runs, so tasks can use it for deadline checks instead of reading the clock.
+     *
+     * @return  sched_micros() before the current task started
+     */
     inline time_t getStartTaskMicros() const {
         return startTaskMicros;
     }
@@ -313,6 +398,40 @@ public:
         return is_elapsed(now, endTime);
     }
 
+    /**
+     * Test if the given task time has elapsed, same as isElapsed() unless SCHED_TIME64 is defined, in which case
+     * times are compared as 64 bit values without wrap around.
+     *
+     * @param now       scheduler time from getMicros()
+     * @param endTime   task timestamp when it is ready to run.
+     * @return true if task is ready to run
+     */
+    inline static uint8_t isTimeElapsed(sched_time_t now, sched_time_t endTime) {
+#ifdef SCHED_TIME64
+        return now >= endTime;
+#else
+        return is_elapsed(now, endTime);
+#endif
+    }
+
+#ifdef SCHED_TIME64
+    /**
+     * Get monotonic 64 bit micros, extended from micros() by counting its wrap arounds.
+     *
+     * CAVEAT: must be called at least once every 71 minutes to detect micros() wrap around,
+     *  loopMicros() calls it on every invocation.
+     *
+     * @return  microseconds since startup
+     */
+    sched_time_t getMicros();
+#else
+
+    inline sched_time_t getMicros() {
+        return sched_micros();
+    }
+
+#endif
+
     /**
      * Get task given by index
      *
@@ -337,6 +456,7 @@ public:
      */
     uint8_t getCurrentTaskId();
 
+#ifndef SCHED_READY_BITMAP
     /**
      * Construct scheduler instance
      *
@@ -344,7 +464,30 @@ public:
      * @param taskTable     pointer to task table in PROGMEM
      * @param delayTable    pointer to task delay table in RAM
      */
-    Scheduler(uint8_t count, PGM_P taskTable, time_t *delayTable);
+    Scheduler(uint8_t count, PGM_P taskTable, sched_time_t *delayTable);
+#else
+    // ready task bitmap mode needs the bitmap table
+    Scheduler(uint8_t count, PGM_P taskTable, sched_time_t *delayTable) = delete;
+
+    /**
+     * Construct scheduler instance using ready task bitmaps
+     *
+     * @param count         number of tasks in the table
+     * @param taskTable     pointer to task table in PROGMEM
+     * @param delayTable    pointer to task delay table in RAM
+     * @param bitmapTable   pointer to bitmap table in RAM, sizeOfSchedulerBitmaps(count) bytes
+     */
+    Scheduler(uint8_t count, PGM_P taskTable, sched_time_t *delayTable, uint8_t *bitmapTable);
+
+    /**
+     * Test if task is ready to run, ie. its bit is set in the ready bitmap
+     * @param taskId of task to test
+     * @return true if task is ready
+     */
+    inline uint8_t isTaskReady(uint8_t taskId) const {
+        return readyBits[taskId >> 3] & (1 << (taskId & 0x07));
+    }
+#endif
 
     /**
      * Startup scheduler and call begin() of all tasks
@@ -381,11 +524,18 @@ public:
         pTask = NULL;
     }
 
+public:
 #ifdef SERIAL_DEBUG_SCHEDULER_MAX_STACKS
+    /**
+     * Print stack usage report: for each async task the declared stack buffer, peak buffer use and deepest main
+     * stack at resume, followed by main stack current and peak depth from stack painting and free RAM.
+     *
+     * With SERIAL_DEBUG_SCHEDULER_STACK_SIZING also prints recommended sizeOfStack() values, measured peak plus
+     * SCHED_STACK_SIZING_MARGIN. Only valid after all code paths of the tasks have run at least once.
+     */
     void dumpMaxStackInfo();
 #endif
 
-public:
     /**
      * Suspend task. The task's loop() will not be called until a resume() for the Task is called.
      *
@@ -407,7 +557,22 @@ public:
      *
      */
     void resumeMicros(uint8_t taskId, time_t microseconds);
-    time_t getResumeMicros(uint8_t taskId);
+    sched_time_t getResumeMicros(uint8_t taskId);
+
+    /**
+     * Resume task at given absolute time. The task's loop() will be called when getMicros() reaches the time.
+     *
+     * CAVEAT: without SCHED_TIME64, time must be within 0x7fffffff of micros() to avoid being treated as wrap
+     *   around.
+     *
+     * @param taskId            task index
+     * @param time              scheduler time, getMicros() based
+     */
+    void resumeAt(uint8_t taskId, sched_time_t time);
+
+    inline void resumeAt(Task *task, sched_time_t time) {
+        resumeAt(task->taskId, time);
+    }
 
     inline void resumeMicros(Task *task, time_t microseconds) {
         resumeMicros(task->taskId, microseconds);
@@ -443,6 +608,14 @@ public:
      */
     bool isSuspended(Task *task);
 
+    /**
+     * Get earliest resume time of tasks which are not suspended, can be used to sleep or to skip idle time
+     *
+     * @param time  set to earliest task resume time, getMicros() based
+     * @return      false if all tasks are suspended, time is not set
+     */
+    uint8_t getNextResumeMicros(sched_time_t &time);
+
 #ifdef CONSOLE_DEBUG
     // print out queue for testing
     void dump(char *buffer, uint32_t sizeofBuffer, uint8_t indent = 0);
@@ -465,16 +638,21 @@ inline bool Task::isSuspended() {
     return scheduler.isSuspended(this);
 }
 
-inline time_t Task::getResumeMicros() {
+inline sched_time_t Task::getResumeMicros() {
     return scheduler.getResumeMicros(taskId);
 }
 
+inline void Task::resumeAt(sched_time_t time) {
+    scheduler.resumeAt(this, time);
+}
+
 #ifdef SERIAL_DEBUG
 #else
 #undef SERIAL_DEBUG_SCHEDULER
 #undef SERIAL_DEBUG_SCHEDULER_ERRORS
 #undef SERIAL_DEBUG_SCHEDULER_DELAYS
 #undef SERIAL_DEBUG_SCHEDULER_MAX_STACKS
+#undef SERIAL_DEBUG_SCHEDULER_STACK_SIZING
 #endif
 
 #ifdef SERIAL_DEBUG
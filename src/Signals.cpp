@@ -3,7 +3,7 @@
 
 #ifdef CONSOLE_DEBUG
 
-#include "../tests/FileTestResults_AddResult.h"
+#include "tests/FileTestResults_AddResult.h"
 
 #endif // CONSOLE_DEBUG
 
@@ -12,8 +12,7 @@ uint8_t Signal::wait(Task *pTask) {
         queue.addTail(pTask->getTaskId());
 
         if (pTask->isAsync()) {
-            reinterpret_cast<AsyncTask *>(pTask)->yieldSuspend();
-            return 0;
+            return reinterpret_cast<AsyncTask *>(pTask)->yieldSuspend();
         } else {
             pTask->suspend();
             return 1;
@@ -0,0 +1,161 @@
+#include "SimRuntime.h"
+
+#ifdef CONSOLE_DEBUG
+
+SimRuntime simRuntime;
+
+SimRuntime::SimRuntime() {
+    begin();
+}
+
+void SimRuntime::begin() {
+    eventCount = 0;
+    simMicros = 0;
+    lastClock = sched_micros();
+    loopCount = 0;
+    idleJumps = 0;
+    idleMicros = 0;
+}
+
+// add any virtual clock changes made directly with sched_clock_advance_micros()
+void SimRuntime::syncClock() {
+    const time_t now = sched_micros();
+    simMicros += (time_t) (now - lastClock);
+    lastClock = now;
+}
+
+sim_time_t SimRuntime::getMicros() {
+    syncClock();
+    return simMicros;
+}
+
+void SimRuntime::advanceMicros(sim_time_t microseconds) {
+#ifdef SCHED_CLOCK_VIRTUAL
+    syncClock();
+    sched_clock_advance_micros(microseconds);
+    simMicros += microseconds;
+    lastClock = sched_micros();
+#else
+    // clock cannot be moved, wait for it
+    const sim_time_t end = getMicros() + microseconds;
+    while (getMicros() < end);
+#endif
+}
+
+uint8_t SimRuntime::scheduleEvent(time_t microseconds, SimEventCallback callback, void *pParam) {
+    return scheduleEventAt(getMicros() + microseconds, callback, pParam);
+}
+
+uint8_t SimRuntime::scheduleEventAt(sim_time_t time, SimEventCallback callback, void *pParam) {
+    if (eventCount >= SIM_MAX_EVENTS) return 0;
+
+    // insert after events with same or earlier time, so events at the same time are dispatched in order added
+    uint8_t i = eventCount;
+    while (i && events[i - 1].time > time) {
+        events[i] = events[i - 1];
+        i--;
+    }
+
+    events[i].time = time;
+    events[i].callback = callback;
+    events[i].pParam = pParam;
+    eventCount++;
+    return 1;
+}
+
+uint8_t SimRuntime::cancelEvents(SimEventCallback callback, void *pParam) {
+    uint8_t removed = 0;
+    uint8_t j = 0;
+
+    for (uint8_t i = 0; i < eventCount; i++) {
+        if (events[i].callback == callback && events[i].pParam == pParam) {
+            removed++;
+        } else {
+            events[j++] = events[i];
+        }
+    }
+
+    eventCount = j;
+    return removed;
+}
+
+void SimRuntime::dispatchEvents() {
+    // callbacks can schedule more events, including ones which are already due
+    while (eventCount && events[0].time <= getMicros()) {
+        const SimEvent event = events[0];
+
+        eventCount--;
+        for (uint8_t i = 0; i < eventCount; i++) {
+            events[i] = events[i + 1];
+        }
+
+        event.callback(event.pParam);
+    }
+}
+
+void SimRuntime::waitMicros(time_t microseconds) {
+    const sim_time_t now = getMicros();
+    sim_time_t next = now + microseconds;
+
+    if (eventCount && events[0].time < next) {
+        next = events[0].time;
+    }
+
+    if (next > now) {
+        advanceMicros(next - now);
+    }
+
+    dispatchEvents();
+}
+
+void SimRuntime::runUntil(sim_time_t time, time_t timeSlice) {
+    while (getMicros() < time) {
+        dispatchEvents();
+
+        scheduler.loopMicros(timeSlice);
+        loopCount++;
+
+        dispatchEvents();
+
+        // find next point in time when something can happen
+        const sim_time_t now = getMicros();
+        sim_time_t next = time;
+
+        if (eventCount && events[0].time < next) {
+            next = events[0].time;
+        }
+
+        sched_time_t resumeTime;
+        if (scheduler.getNextResumeMicros(resumeTime)) {
+            const sched_time_t clockNow = scheduler.getMicros();
+            sim_time_t delay = 0;
+
+            if (!Scheduler::isTimeElapsed(clockNow, resumeTime)) {
+                delay = (sched_time_t) (resumeTime - clockNow);
+            }
+
+#if defined(SCHED_MIN_LOOP_TIMESLICE_MICROS) && SCHED_MIN_LOOP_TIMESLICE_MICROS
+            // scheduler will skip the pass if called sooner than this after the last one
+            const time_t sinceLoop = (time_t) clockNow - scheduler.getStartLoopMicros();
+            if (sinceLoop < SCHED_MIN_LOOP_TIMESLICE_MICROS && delay < SCHED_MIN_LOOP_TIMESLICE_MICROS - sinceLoop) {
+                delay = SCHED_MIN_LOOP_TIMESLICE_MICROS - sinceLoop;
+            }
+#endif
+
+            if (now + delay < next) {
+                next = now + delay;
+            }
+        }
+
+        if (next > now) {
+            idleJumps++;
+            idleMicros += next - now;
+            advanceMicros(next - now);
+        } else if (!eventCount || events[0].time > now) {
+            // tasks are ready but take no time, make sure time moves forward
+            advanceMicros(1);
+        }
+    }
+}
+
+#endif // CONSOLE_DEBUG
@@ -0,0 +1,152 @@
+#ifndef SCHEDULER_SIMRUNTIME_H
+#define SCHEDULER_SIMRUNTIME_H
+
+/*
+ * Discrete event simulation runtime for the CONSOLE_DEBUG host build.
+ *
+ * Drives scheduler.loopMicros() on the SCHED_CLOCK_VIRTUAL clock. When no task is ready, virtual time jumps directly
+ * to the earliest of the next task resume time and the next pending event, so idle time costs nothing to simulate.
+ * On the default micros() clock the simulation runs in real time, time is waited for instead of jumped over.
+ * Events stand in for interrupts, their callback is called between scheduler passes at the event's virtual time,
+ * e.g. to complete a TWI request with twi_complete_request().
+ *
+ * Tasks which want to model their execution time call simRuntime.consumeMicros(), otherwise tasks take no time.
+ *
+ * Usage:
+ *
+ *     scheduler.begin();
+ *     simRuntime.begin();
+ *     simRuntime.scheduleEvent(500, onTwiDone, pStream);
+ *     simRuntime.runMicros(3600UL * 1000000UL);
+ */
+
+#ifdef CONSOLE_DEBUG
+
+#include "Scheduler.h"
+
+#ifndef SIM_MAX_EVENTS
+#define SIM_MAX_EVENTS              (32)        // max pending events
+#endif
+
+typedef uint64_t sim_time_t;
+typedef void (*SimEventCallback)(void *pParam);
+
+struct SimEvent {
+    sim_time_t time;                // simulation time of event
+    SimEventCallback callback;      // called as if from an interrupt
+    void *pParam;
+};
+
+class SimRuntime {
+    SimEvent events[SIM_MAX_EVENTS];    // pending events, sorted by time
+    uint8_t eventCount;
+    sim_time_t simMicros;               // 64 bit simulation time, does not wrap
+    time_t lastClock;                   // virtual clock at last sync, detects external clock changes
+
+    uint32_t loopCount;                 // number of scheduler passes
+    uint32_t idleJumps;                 // number of idle time jumps
+    sim_time_t idleMicros;              // total idle time skipped
+
+    void syncClock();
+    void advanceMicros(sim_time_t microseconds);
+    void dispatchEvents();
+
+public:
+    SimRuntime();
+
+    /**
+     * Reset simulation time, events and statistics to 0, virtual clock is left as is.
+     */
+    void begin();
+
+    /**
+     * Get simulation time, 64 bit microseconds since begin()
+     */
+    sim_time_t getMicros();
+
+    /**
+     * Advance virtual time to simulate execution time of the current task or interrupt, waits for it on the
+     * micros() clock
+     *
+     * @param microseconds  time consumed
+     */
+    inline void consumeMicros(time_t microseconds) {
+        advanceMicros(microseconds);
+    }
+
+    /**
+     * Add an event to be dispatched after given delay from now.
+     *
+     * @param microseconds  delay from now
+     * @param callback      callback function
+     * @param pParam        callback argument
+     * @return              false if event table is full
+     */
+    uint8_t scheduleEvent(time_t microseconds, SimEventCallback callback, void *pParam);
+
+    /**
+     * Add an event to be dispatched at given simulation time, if time is in the past it is dispatched before the
+     * next scheduler pass.
+     *
+     * @param time          simulation time of event
+     * @param callback      callback function
+     * @param pParam        callback argument
+     * @return              false if event table is full
+     */
+    uint8_t scheduleEventAt(sim_time_t time, SimEventCallback callback, void *pParam);
+
+    /**
+     * Remove pending events with given callback and param
+     *
+     * @return      number of events removed
+     */
+    uint8_t cancelEvents(SimEventCallback callback, void *pParam);
+
+    NO_DISCARD inline uint8_t getEventCount() const {
+        return eventCount;
+    }
+
+    /**
+     * Advance virtual time to the next pending event, at most by given microseconds, and dispatch due events. For busy
+     * wait loops, e.g. twi_wait(), which would otherwise never see the virtual clock move or the request complete.
+     *
+     * @param microseconds  maximum time to advance
+     */
+    void waitMicros(time_t microseconds);
+
+    /**
+     * Run scheduler and events until given simulation time
+     *
+     * @param time          simulation time to stop at
+     * @param timeSlice     time slice passed to scheduler.loopMicros()
+     */
+    void runUntil(sim_time_t time, time_t timeSlice = 0);
+
+    /**
+     * Run scheduler and events for given duration
+     *
+     * @param microseconds  duration to run
+     * @param timeSlice     time slice passed to scheduler.loopMicros()
+     */
+    inline void runMicros(sim_time_t microseconds, time_t timeSlice = 0) {
+        runUntil(getMicros() + microseconds, timeSlice);
+    }
+
+    NO_DISCARD inline uint32_t getLoopCount() const {
+        return loopCount;
+    }
+
+    NO_DISCARD inline uint32_t getIdleJumps() const {
+        return idleJumps;
+    }
+
+    NO_DISCARD inline sim_time_t getIdleMicros() const {
+        return idleMicros;
+    }
+};
+
+extern SimRuntime simRuntime;
+
+#endif // CONSOLE_DEBUG
+
+#endif //SCHEDULER_SIMRUNTIME_H
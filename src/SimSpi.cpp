@@ -0,0 +1,80 @@
+#include "SimSpi.h"
+
+#if defined(CONSOLE_DEBUG) && defined(INCLUDE_SPI_MODULE)
+
+#include "CByteBuffer.h"
+
+SimSpiBus simSpi;
+
+SimSpiBus::SimSpiBus() {
+    deviceCount = 0;
+    pStream = NULL;
+    clock = F_CPU / SPI_CLOCK_DIVIDER;
+    begin();
+}
+
+void SimSpiBus::begin() {
+    requests = 0;
+    bytes = 0;
+    busyMicros = 0;
+}
+
+bool SimSpiBus::addDevice(SimSpiDevice *pDevice) {
+    if (deviceCount == SIM_SPI_MAX_DEVICES) return false;
+    devices[deviceCount++] = pDevice;
+    return true;
+}
+
+SimSpiDevice *SimSpiBus::findDevice(uint8_t csPin) {
+    for (uint8_t i = 0; i < deviceCount; i++) {
+        if (devices[i]->csPin == csPin) return devices[i];
+    }
+    return NULL;
+}
+
+void SimSpiBus::start(CByteStream_t *pStream) {
+    this->pStream = pStream;
+    pStream->flags |= STREAM_FLAGS_PROCESSING;
+
+    SimSpiDevice *pDevice = findDevice(SPI_ADDRESS_CS_PIN(pStream->addr));
+    uint16_t byteCount = 0;
+
+    if (pDevice) pDevice->select(SPI_ADDRESS_MODE(pStream->addr));
+
+    while (!stream_is_empty(pStream)) {
+        const uint8_t data = stream_get(pStream);
+        if (pDevice) pDevice->transfer(data);
+        byteCount++;
+    }
+
+    if (pStream->nRdSize && pStream->pRdData) {
+        CByteBuffer_t rdBuffer;
+        buffer_init(&rdBuffer, pStream->flags & STREAM_FLAGS_BUFF_REVERSE, pStream->pRdData, pStream->nRdSize);
+
+        for (uint8_t i = 0; i < pStream->nRdSize; i++) {
+            buffer_put(&rdBuffer, pDevice ? pDevice->transfer(0xFF) : 0xFF);
+            byteCount++;
+        }
+    }
+
+    if (pDevice) pDevice->deselect();
+
+    const time_t duration = (time_t) ((byteCount * 8ULL * 1000000ULL + clock - 1) / clock + byteCount * SIM_SPI_BYTE_OVERHEAD_MICROS);
+
+    requests++;
+    bytes += byteCount;
+    busyMicros += duration;
+
+    simRuntime.scheduleEvent(duration, SimSpiBus::completeRequest, this);
+}
+
+void SimSpiBus::completeRequest(void *pParam) {
+    SimSpiBus *thizz = (SimSpiBus *) pParam;
+    CByteStream_t *pStream = thizz->pStream;
+
+    // completing the request can start the next one
+    thizz->pStream = NULL;
+    spi_complete_request(pStream);
+}
+
+#endif // CONSOLE_DEBUG
@@ -0,0 +1,128 @@
+#ifndef SCHEDULER_SIMSPI_H
+#define SCHEDULER_SIMSPI_H
+
+/*
+ * Simulated SPI bus for the CONSOLE_DEBUG host build.
+ *
+ * SpiController::startProcessingRequest() hands requests to simSpi instead of spiint_start(). The device with the
+ * request's chip select pin is selected, each stream byte is exchanged with it, then the read bytes are clocked in
+ * with 0xFF sent and stored in the request's read buffer as spiint does. The request is completed with
+ * spi_complete_request() after the time the transfer takes at the configured clock, 8 bits per byte plus the
+ * per byte interrupt overhead, using a SimRuntime event.
+ *
+ * Requests for a chip select without a device read 0xFF, the same as a floating MISO line with pull-up.
+ *
+ * Usage:
+ *
+ *     class SimFlash : public SimSpiDevice { ... };
+ *     SimFlash flash(10);
+ *
+ *     simSpi.addDevice(&flash);
+ *     simRuntime.runMicros(1000000UL);
+ */
+
+#if defined(CONSOLE_DEBUG) && defined(INCLUDE_SPI_MODULE)
+
+#include "SimRuntime.h"
+#include "CByteStream.h"
+#include "spiint.h"
+
+#ifndef SIM_SPI_MAX_DEVICES
+#define SIM_SPI_MAX_DEVICES         (4)
+#endif
+
+#ifndef SIM_SPI_BYTE_OVERHEAD_MICROS
+#define SIM_SPI_BYTE_OVERHEAD_MICROS    (2)     // SPI_STC_vect entry, processing and exit per byte
+#endif
+
+class SimSpiDevice {
+    friend class SimSpiBus;
+
+protected:
+    uint8_t csPin;
+
+public:
+    explicit SimSpiDevice(uint8_t csPin) : csPin(csPin) {}
+
+    virtual ~SimSpiDevice() = default;
+
+    /**
+     * Chip select driven low
+     *
+     * @param mode  SPI_MODE0..SPI_MODE3 of the request
+     */
+    virtual void select(uint8_t mode) {}
+
+    /**
+     * Exchange a byte
+     *
+     * @param data  byte sent on MOSI
+     * @return      byte returned on MISO
+     */
+    virtual uint8_t transfer(uint8_t data) = 0;
+
+    /**
+     * Chip select driven high, end of request
+     */
+    virtual void deselect() {}
+};
+
+class SimSpiBus {
+    SimSpiDevice *devices[SIM_SPI_MAX_DEVICES];
+    uint8_t deviceCount;
+
+    CByteStream_t *pStream;             // request being transferred
+    uint32_t clock;
+
+    // statistics
+    uint32_t requests;
+    uint32_t bytes;
+    sim_time_t busyMicros;
+
+    SimSpiDevice *findDevice(uint8_t csPin);
+    static void completeRequest(void *pParam);
+
+public:
+    SimSpiBus();
+
+    /**
+     * Clear statistics
+     */
+    void begin();
+
+    /**
+     * Add device, return false if SIM_SPI_MAX_DEVICES are already added
+     */
+    bool addDevice(SimSpiDevice *pDevice);
+
+    inline void setClock(uint32_t clock) {
+        this->clock = clock;
+    }
+
+    /**
+     * Start processing request, called from SpiController::startProcessingRequest()
+     */
+    void start(CByteStream_t *pStream);
+
+    NO_DISCARD inline uint8_t isBusy() const {
+        return pStream != NULL;
+    }
+
+    NO_DISCARD inline uint32_t getRequests() const {
+        return requests;
+    }
+
+    NO_DISCARD inline uint32_t getBytes() const {
+        return bytes;
+    }
+
+    NO_DISCARD inline sim_time_t getBusyMicros() const {
+        return busyMicros;
+    }
+};
+
+extern SimSpiBus simSpi;
+
+#endif // CONSOLE_DEBUG
+
+#endif //SCHEDULER_SIMSPI_H
@@ -0,0 +1,440 @@
+#include "SimTwi.h"
+
+#ifdef CONSOLE_DEBUG
+
+#include "Controller.h"
+
+SimTwiBus simTwiBus;
+
+SimTwiBus::SimTwiBus() {
+    deviceCount = 0;
+    pStream = NULL;
+    pController = NULL;
+    bitRate = TWI_FREQUENCY;
+    byteOverheadMicros = 0;
+    nackRate = 0;
+    arbLostRate = 0;
+    randomState = 1;
+    hangCount = 0;
+    begin();
+}
+
+void SimTwiBus::begin() {
+    requests = 0;
+    bytes = 0;
+    nacks = 0;
+    arbLosts = 0;
+    busyMicros = 0;
+#ifdef SERIAL_DEBUG_TWI_REQ_TIMING
+    totalLatencyMicros = 0;
+    maxLatencyMicros = 0;
+#endif
+}
+
+uint8_t SimTwiBus::addDevice(SimTwiDevice *pDevice) {
+    if (deviceCount >= SIM_TWI_MAX_DEVICES) return 0;
+    devices[deviceCount++] = pDevice;
+    return 1;
+}
+
+void SimTwiBus::setErrorRates(uint16_t nackRate, uint16_t arbLostRate, uint32_t seed) {
+    this->nackRate = nackRate;
+    this->arbLostRate = arbLostRate;
+    randomState = seed ? seed : 1;
+}
+
+SimTwiDevice *SimTwiBus::findDevice(uint8_t address) {
+    for (uint8_t i = 0; i < deviceCount; i++) {
+        if (devices[i]->address == address) return devices[i];
+    }
+    return NULL;
+}
+
+uint8_t SimTwiBus::injectError(uint16_t rate) {
+    if (!rate) return 0;
+
+    // xorshift32
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return (uint16_t) randomState < rate;
+}
+
+void SimTwiBus::start(CByteStream_t *pStream) {
+    this->pStream = pStream;
+    pStream->flags |= STREAM_FLAGS_PROCESSING;
+    pStream->error = TWI_ERR_NONE;
+    twiint_request_start_time = sched_micros();
+
+#ifdef SERIAL_DEBUG_TWI_REQ_TIMING
+    if (!pStream->startTime) {
+        pStream->startTime = twiint_request_start_time;
+        if (!pStream->startTime) pStream->startTime = 1;
+    }
+#endif
+
+    if (hangCount) {
+        // SCL held low, request does not complete until watchdog() times it out
+        hangCount--;
+        return;
+    }
+
+    const uint8_t nHead = pStream->byteQueue.nHead;
+    uint8_t attempts = 0;
+    uint32_t bitCount = 0;
+    uint16_t byteCount = 0;
+
+    for (;;) {
+        const uint8_t error = transfer(pStream, &bitCount, &byteCount);
+        if (!error) break;
+
+        if (error == TWI_ERR_ARB_LOST) {
+            arbLosts++;
+        } else {
+            nacks++;
+        }
+
+        if (!(twiint_retry_on & TWI_RETRY_FLAG(error)) || attempts >= twiint_retries) {
+            pStream->error = error;
+            twiint_errors++;
+            break;
+        }
+
+        // start over, same as twiint
+        attempts++;
+        twiint_retry_count++;
+        pStream->byteQueue.nHead = nHead;
+    }
+
+    const time_t duration = (time_t) ((bitCount * 1000000ULL + bitRate - 1) / bitRate) + byteCount * byteOverheadMicros;
+
+    requests++;
+    bytes += byteCount;
+    busyMicros += duration;
+
+    simRuntime.scheduleEvent(duration, SimTwiBus::completeRequest, this);
+}
+
+uint8_t SimTwiBus::transfer(CByteStream_t *pStream, uint32_t *pBitCount, uint16_t *pByteCount) {
+    uint32_t bitCount = 1 + 9;      // START and address
+    uint16_t byteCount = 1;
+    uint8_t error = TWI_ERR_NONE;
+
+    if (injectError(arbLostRate)) {
+        // arbitration is lost during the address byte, bus is released without STOP
+        *pBitCount += bitCount;
+        *pByteCount += byteCount;
+        return TWI_ERR_ARB_LOST;
+    }
+
+    SimTwiDevice *pDevice = findDevice(pStream->addr >> 1);
+
+    if (!pDevice || injectError(nackRate)) {
+        error = TWI_ERR_SLA_NACK;
+    } else {
+        pDevice->start(0);
+
+        while (!stream_is_empty(pStream)) {
+            bitCount += 9;
+            byteCount++;
+
+            if (!pDevice->write(stream_get(pStream)) || injectError(nackRate)) {
+                error = TWI_ERR_DATA_NACK;
+                break;
+            }
+        }
+
+        if (!error && pStream->nRdSize && pStream->pRdData) {
+            // repeated START and read address, last byte is NACKed by master
+            bitCount += 1 + 9;
+            byteCount++;
+
+            if (injectError(nackRate)) {
+                error = TWI_ERR_SLA_NACK;
+            } else {
+                CByteBuffer_t rdBuffer;
+                buffer_init(&rdBuffer, pStream->flags & STREAM_FLAGS_BUFF_REVERSE, pStream->pRdData, pStream->nRdSize);
+
+                pDevice->start(1);
+                for (uint8_t i = 0; i < pStream->nRdSize; i++) {
+                    buffer_put(&rdBuffer, pDevice->read());
+                    bitCount += 9;
+                    byteCount++;
+                }
+            }
+        }
+
+        pDevice->stop();
+    }
+
+    bitCount++;                     // STOP
+
+    *pBitCount += bitCount;
+    *pByteCount += byteCount;
+    return error;
+}
+
+uint8_t SimTwiBus::watchdog() {
+    if (!pStream || (time_t) (sched_micros() - twiint_request_start_time) < TWI_WATCHDOG_MICROS) return 0;
+
+    // bus recovery clocks out the hung device
+    pStream->error = TWI_ERR_TIMEOUT;
+    twiint_errors++;
+    twiint_recoveries++;
+    completeRequest(this);
+    return 1;
+}
+
+void SimTwiBus::completeRequest(void *pParam) {
+    SimTwiBus *thizz = (SimTwiBus *) pParam;
+    CByteStream_t *pStream = thizz->pStream;
+
+    // completing the request can start the next one
+    thizz->pStream = NULL;
+
+#ifdef SERIAL_DEBUG_TWI_REQ_TIMING
+    const time_t latency = sched_micros() - pStream->startTime;
+    thizz->totalLatencyMicros += latency;
+    if (thizz->maxLatencyMicros < latency) thizz->maxLatencyMicros = latency;
+#endif
+
+    if (thizz->pController) {
+        thizz->pController->endProcessingRequest((ByteStream *) pStream);
+    } else {
+        twi_complete_request(pStream);
+    }
+}
+
+SimXL9535::SimXL9535(uint8_t address) : SimTwiDevice(address) {
+    registers[IOX_REG_INPUT_PORT0] = 0;
+    registers[IOX_REG_INPUT_PORT1] = 0;
+    registers[IOX_REG_OUTPUT_PORT0] = 0xff;
+    registers[IOX_REG_OUTPUT_PORT1] = 0xff;
+    registers[IOX_REG_POLARITY_INVERSION_PORT0] = 0;
+    registers[IOX_REG_POLARITY_INVERSION_PORT1] = 0;
+    registers[IOX_REG_CONFIGURATION_PORT0] = 0xff;
+    registers[IOX_REG_CONFIGURATION_PORT1] = 0xff;
+    pointer = 0;
+    haveWritten = 0;
+    pins = 0xffff;
+}
+
+void SimXL9535::start(uint8_t isRead) {
+    haveWritten = 0;
+
+    if (isRead) {
+        // input registers are latched at read start
+        const uint16_t config = getConfiguration();
+        const uint16_t outputs = registers[IOX_REG_OUTPUT_PORT0] | (registers[IOX_REG_OUTPUT_PORT1] << 8);
+        const uint16_t polarity = registers[IOX_REG_POLARITY_INVERSION_PORT0] | (registers[IOX_REG_POLARITY_INVERSION_PORT1] << 8);
+        const uint16_t inputs = ((pins & config) | (outputs & ~config)) ^ polarity;
+
+        registers[IOX_REG_INPUT_PORT0] = inputs;
+        registers[IOX_REG_INPUT_PORT1] = inputs >> 8;
+    }
+}
+
+uint8_t SimXL9535::write(uint8_t data) {
+    if (!haveWritten) {
+        if (data > IOX_REG_CONFIGURATION_PORT1) return 0;
+        pointer = data;
+        haveWritten = 1;
+        return 1;
+    }
+
+    if (pointer > IOX_REG_INPUT_PORT1) {
+        registers[pointer] = data;
+    }
+    pointer ^= 1;
+    return 1;
+}
+
+uint8_t SimXL9535::read() {
+    const uint8_t data = registers[pointer];
+    pointer ^= 1;
+    return data;
+}
+
+uint16_t SimXL9535::getOutputs() const {
+    const uint16_t outputs = registers[IOX_REG_OUTPUT_PORT0] | (registers[IOX_REG_OUTPUT_PORT1] << 8);
+    return outputs & ~getConfiguration();
+}
+
+static const uint8_t dacRegisters[] = {
+        REG_STATUS,
+        REG_GENERAL_CONFIG,
+        REG_MED_ALARM_CONFIG,
+        REG_TRIGGER,
+        REG_DATA,
+        REG_MARGIN_HIGH,
+        REG_MARGIN_LOW,
+        REG_PMBUS_OP,
+        REG_PMBUS_STATUS_BYTE,
+        REG_PMBUS_VERSION,
+};
+
+SimDac53401::SimDac53401(uint8_t address) : SimTwiDevice(address) {
+    reset();
+    index = NULL_BYTE;
+    byteCount = 0;
+    highByte = 0;
+}
+
+void SimDac53401::reset() {
+    // power on defaults from the datasheet
+    registers[0] = DAC_STATUS_DEVICE_VERSION_ID_53401;
+    registers[1] = 0x01F0;
+    registers[2] = 0x0000;
+    registers[3] = 0x0000;
+    registers[4] = 0x0000;
+    registers[5] = 0x0000;
+    registers[6] = 0x0000;
+    registers[7] = 0x0000;
+    registers[8] = 0x0000;
+    registers[9] = 0x0022;
+}
+
+uint8_t SimDac53401::registerIndex(uint8_t reg) {
+    for (uint8_t i = 0; i < lengthof(dacRegisters); i++) {
+        if (dacRegisters[i] == reg) return i;
+    }
+    return NULL_BYTE;
+}
+
+uint16_t SimDac53401::getRegister(uint8_t reg) const {
+    const uint8_t i = registerIndex(reg);
+    return i == NULL_BYTE ? 0 : registers[i];
+}
+
+void SimDac53401::start(uint8_t isRead) {
+    if (!isRead) index = NULL_BYTE;
+    byteCount = 0;
+}
+
+uint8_t SimDac53401::write(uint8_t data) {
+    if (index == NULL_BYTE) {
+        index = registerIndex(data);
+        byteCount = 0;
+        return index != NULL_BYTE;
+    }
+
+    if (!(byteCount & 1)) {
+        highByte = data;
+    } else if (index) {
+        // STATUS at index 0 is read only
+        const uint16_t value = (highByte << 8) | data;
+
+        if (dacRegisters[index] == REG_TRIGGER && (value & WR_TRIGGER_DEVICE_CONFIG_RESET(1))) {
+            reset();
+        } else {
+            registers[index] = value;
+        }
+    }
+
+    byteCount++;
+    return 1;
+}
+
+uint8_t SimDac53401::read() {
+    const uint16_t value = index == NULL_BYTE ? 0xffff : registers[index];
+    return byteCount++ & 1 ? value & 0xff : value >> 8;
+}
+
+SimSsd1306::SimSsd1306(uint8_t address) : SimTwiDevice(address) {
+    memset(ram, 0, sizeof(ram));
+    control = NULL_BYTE;
+    command = 0;
+    argCount = 0;
+    columnStart = 0;
+    columnEnd = 127;
+    column = 0;
+    pageStart = 0;
+    pageEnd = 7;
+    page = 0;
+    dataBytes = 0;
+}
+
+void SimSsd1306::start(uint8_t isRead) {
+    // command cut off by a NACK or stop is dropped
+    control = NULL_BYTE;
+    command = 0;
+}
+
+// argument bytes of commands, 0 for single byte commands
+static uint8_t ssd1306ArgCount(uint8_t command) {
+    switch (command) {
+        case 0x21:  // column address
+        case 0x22:  // page address
+            return 2;
+
+        case 0x20:  // memory addressing mode
+        case 0x81:  // contrast
+        case 0x8D:  // charge pump
+        case 0xA8:  // multiplex ratio
+        case 0xD3:  // display offset
+        case 0xD5:  // clock divide
+        case 0xD9:  // pre-charge period
+        case 0xDA:  // COM pins
+        case 0xDB:  // VCOMH deselect level
+            return 1;
+
+        default:
+            return 0;
+    }
+}
+
+void SimSsd1306::doCommand(uint8_t data) {
+    if (!command) {
+        if (ssd1306ArgCount(data)) {
+            command = data;
+            argCount = 0;
+        }
+        return;
+    }
+
+    args[argCount++] = data;
+    if (argCount < ssd1306ArgCount(command)) return;
+
+    if (command == 0x21) {
+        columnStart = args[0] & 0x7f;
+        columnEnd = args[1] & 0x7f;
+        column = columnStart;
+    } else if (command == 0x22) {
+        pageStart = args[0] & 0x07;
+        pageEnd = args[1] & 0x07;
+        page = pageStart;
+    }
+    command = 0;
+}
+
+uint8_t SimSsd1306::write(uint8_t data) {
+    if (control == NULL_BYTE) {
+        control = data;
+        return 1;
+    }
+
+    if (!(control & 0x40)) {
+        doCommand(data);
+    } else {
+        ram[page][column] = data;
+        dataBytes++;
+
+        if (column++ == columnEnd) {
+            column = columnStart;
+            page = page == pageEnd ? pageStart : page + 1;
+        }
+    }
+
+    // continuation bit, another control byte follows
+    if (control & 0x80) {
+        control = NULL_BYTE;
+    }
+    return 1;
+}
+
+uint8_t SimSsd1306::read() {
+    // status byte, display on
+    return 0x00;
+}
+
+#endif // CONSOLE_DEBUG
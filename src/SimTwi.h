@@ -0,0 +1,304 @@
+#ifndef SCHEDULER_SIMTWI_H
+#define SCHEDULER_SIMTWI_H
+
+/*
+ * Simulated TWI bus for the CONSOLE_DEBUG host build.
+ *
+ * TwiController::startProcessingRequest() hands requests to simTwiBus instead of twiint_start(). The bus transfers
+ * the request bytes to the device model at the request's address, reads the response into the stream's read buffer
+ * and completes the request with twi_complete_request() after the time the transfer takes at the configured bit
+ * rate, using a SimRuntime event. Address and data NACKs and arbitration loss can be injected at given rates, they
+ * are handled the way twiint does: the request is retried from the start per twiint_retries and twiint_retry_on,
+ * after which it ends with the error in the stream's error and counts in twiint_errors. setHangCount() makes
+ * requests hang the bus until watchdog(), called by TwiController::service(), times them out.
+ *
+ * Device models are register level: SimXL9535 I/O expander, SimDac53401 DAC and SimSsd1306 display.
+ *
+ * Usage:
+ *
+ *     SimXL9535 iox(IOX_I2C_ADDRESS(0));
+ *     SimDac53401 dac(0x48);
+ *
+ *     simTwiBus.addDevice(&iox);
+ *     simTwiBus.addDevice(&dac);
+ *     simTwiBus.setErrorRates(10, 0, 1);     // 10/65536 NACK rate
+ *     simRuntime.runMicros(60UL * 1000000UL);
+ *     printf("%u req/s\n", simTwiBus.getRequests() / 60);
+ */
+
+#ifdef CONSOLE_DEBUG
+
+#include "SimRuntime.h"
+#include "CByteStream.h"
+#include "twiint.h"
+#include "CIOExpander_cmd.h"
+#include "CDac53401_cmd.h"
+
+class Controller;
+
+#ifndef SIM_TWI_MAX_DEVICES
+#define SIM_TWI_MAX_DEVICES         (8)
+#endif
+
+class SimTwiDevice {
+    friend class SimTwiBus;
+
+protected:
+    uint8_t address;                    // 7 bit device address
+
+public:
+    explicit SimTwiDevice(uint8_t address) {
+        this->address = address;
+    }
+
+    NO_DISCARD inline uint8_t getAddress() const {
+        return address;
+    }
+
+    /**
+     * Start or repeated start addressed to this device
+     *
+     * @param isRead    true if master will read
+     */
+    virtual void start(uint8_t isRead) = 0;
+
+    /**
+     * Byte written by master
+     *
+     * @return  true to ACK, false to NACK
+     */
+    virtual uint8_t write(uint8_t data) = 0;
+
+    /**
+     * Byte read by master
+     */
+    virtual uint8_t read() = 0;
+
+    /**
+     * Stop condition
+     */
+    virtual void stop() {
+    }
+};
+
+class SimTwiBus {
+    SimTwiDevice *devices[SIM_TWI_MAX_DEVICES];
+    uint8_t deviceCount;
+
+    CByteStream_t *pStream;             // request being transferred
+    Controller *pController;            // controller to end requests on, NULL for twi_complete_request()
+    uint32_t bitRate;                   // bus bit rate
+    time_t byteOverheadMicros;          // interrupt processing time added per byte
+    uint16_t nackRate;                  // NACK probability per byte, in 1/65536
+    uint16_t arbLostRate;               // arbitration loss probability per request, in 1/65536
+    uint32_t randomState;
+    uint8_t hangCount;                  // number of next requests which hang the bus
+
+    // statistics
+    uint32_t requests;
+    uint32_t bytes;                     // bytes on the bus, including address bytes
+    uint16_t nacks;
+    uint16_t arbLosts;
+    sim_time_t busyMicros;
+#ifdef SERIAL_DEBUG_TWI_REQ_TIMING
+    sim_time_t totalLatencyMicros;
+    time_t maxLatencyMicros;
+#endif
+
+    SimTwiDevice *findDevice(uint8_t address);
+    uint8_t injectError(uint16_t rate);
+    uint8_t transfer(CByteStream_t *pStream, uint32_t *pBitCount, uint16_t *pByteCount);
+    static void completeRequest(void *pParam);
+
+public:
+    SimTwiBus();
+
+    /**
+     * Reset statistics, devices stay attached
+     */
+    void begin();
+
+    uint8_t addDevice(SimTwiDevice *pDevice);
+
+    /**
+     * End completed requests on given controller instead of twiController, for buses of other controllers, e.g.
+     * SoftTwiController::setSimBus()
+     */
+    inline void setController(Controller *pController) {
+        this->pController = pController;
+    }
+
+    inline void setBitRate(uint32_t bitRate) {
+        this->bitRate = bitRate;
+    }
+
+    inline void setByteOverheadMicros(time_t microseconds) {
+        byteOverheadMicros = microseconds;
+    }
+
+    /**
+     * Set error injection rates, the random sequence is deterministic for a given seed
+     *
+     * @param nackRate      NACK probability per address or data byte, in 1/65536
+     * @param arbLostRate   arbitration loss probability per request, in 1/65536
+     * @param seed          random generator seed, non-zero
+     */
+    void setErrorRates(uint16_t nackRate, uint16_t arbLostRate, uint32_t seed);
+
+    /**
+     * Make the next requests hang the bus, they end with TWI_ERR_TIMEOUT from watchdog()
+     *
+     * @param count     number of requests to hang
+     */
+    inline void setHangCount(uint8_t count) {
+        hangCount = count;
+    }
+
+    /**
+     * Start processing request, called from TwiController::startProcessingRequest()
+     */
+    void start(CByteStream_t *pStream);
+
+    /**
+     * Time out request hanging the bus for TWI_WATCHDOG_MICROS, same as twiint_watchdog()
+     *
+     * @return  true if request was timed out
+     */
+    uint8_t watchdog();
+
+    NO_DISCARD inline uint8_t isBusy() const {
+        return pStream != NULL;
+    }
+
+    NO_DISCARD inline uint32_t getRequests() const {
+        return requests;
+    }
+
+    NO_DISCARD inline uint32_t getBytes() const {
+        return bytes;
+    }
+
+    NO_DISCARD inline uint16_t getNacks() const {
+        return nacks;
+    }
+
+    NO_DISCARD inline uint16_t getArbLosts() const {
+        return arbLosts;
+    }
+
+    NO_DISCARD inline sim_time_t getBusyMicros() const {
+        return busyMicros;
+    }
+
+#ifdef SERIAL_DEBUG_TWI_REQ_TIMING
+    /**
+     * Average time from stream startTime to request completion. startTime is set at start of transfer unless it was
+     * already set, so requests given a startTime when queued include time waiting in the controller queue.
+     */
+    NO_DISCARD inline time_t getAvgLatencyMicros() const {
+        return requests ? (time_t) (totalLatencyMicros / requests) : 0;
+    }
+
+    NO_DISCARD inline time_t getMaxLatencyMicros() const {
+        return maxLatencyMicros;
+    }
+#endif
+};
+
+extern SimTwiBus simTwiBus;
+
+/**
+ * XL9535 16 bit I/O expander model, register pairs with pointer toggling within a pair as in the datasheet.
+ */
+class SimXL9535 : public SimTwiDevice {
+    uint8_t registers[8];
+    uint8_t pointer;
+    uint8_t haveWritten;                // pointer byte was received
+    uint16_t pins;                      // externally driven pin levels of input pins
+
+public:
+    explicit SimXL9535(uint8_t address);
+
+    void start(uint8_t isRead) override;
+    uint8_t write(uint8_t data) override;
+    uint8_t read() override;
+
+    inline void setPins(uint16_t pins) {
+        this->pins = pins;
+    }
+
+    /**
+     * Pin levels driven by outputs, bits configured as inputs are 0
+     */
+    NO_DISCARD uint16_t getOutputs() const;
+
+    NO_DISCARD inline uint16_t getConfiguration() const {
+        return registers[IOX_REG_CONFIGURATION_PORT0] | (registers[IOX_REG_CONFIGURATION_PORT1] << 8);
+    }
+};
+
+/**
+ * DAC53401 model, 8 bit register pointer followed by 16 bit big-endian register values.
+ */
+class SimDac53401 : public SimTwiDevice {
+    uint16_t registers[10];
+    uint8_t index;                      // index of addressed register, NULL_BYTE if none
+    uint8_t byteCount;                  // bytes received or sent since pointer
+    uint8_t highByte;
+
+    static uint8_t registerIndex(uint8_t reg);
+    void reset();
+
+public:
+    explicit SimDac53401(uint8_t address);
+
+    void start(uint8_t isRead) override;
+    uint8_t write(uint8_t data) override;
+    uint8_t read() override;
+
+    NO_DISCARD uint16_t getRegister(uint8_t reg) const;
+
+    /**
+     * 10 bit output code from DAC_DATA register
+     */
+    NO_DISCARD inline uint16_t getDataCode() const {
+        return (getRegister(REG_DATA) & 0x0FFC) >> 2;
+    }
+};
+
+/**
+ * SSD1306 128x64 display model, display RAM written in horizontal addressing mode within the column and page
+ * address ranges. Control bytes with the continuation bit are followed by one byte and another control byte. Other
+ * commands are skipped with their argument bytes.
+ */
+class SimSsd1306 : public SimTwiDevice {
+    uint8_t ram[8][128];
+    uint8_t control;                    // last control byte, NULL_BYTE if next byte is one
+    uint8_t command;                    // command taking argument bytes, 0 if none
+    uint8_t argCount;                   // argument bytes received
+    uint8_t args[2];
+    uint8_t columnStart, columnEnd, column;
+    uint8_t pageStart, pageEnd, page;
+    uint32_t dataBytes;                 // display RAM bytes written
+
+    void doCommand(uint8_t data);
+
+public:
+    explicit SimSsd1306(uint8_t address);
+
+    void start(uint8_t isRead) override;
+    uint8_t write(uint8_t data) override;
+    uint8_t read() override;
+
+    NO_DISCARD inline const uint8_t *getPage(uint8_t page) const {
+        return ram[page];
+    }
+
+    NO_DISCARD inline uint32_t getDataBytes() const {
+        return dataBytes;
+    }
+};
+
+#endif // CONSOLE_DEBUG
+
+#endif //SCHEDULER_SIMTWI_H
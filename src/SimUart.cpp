@@ -0,0 +1,62 @@
+#include "SimUart.h"
+
+#if defined(CONSOLE_DEBUG) && defined(INCLUDE_UART_MODULE)
+
+SimUart simUart;
+
+SimUart::SimUart() {
+    pStream = NULL;
+    baud = UART_BAUD;
+    echo = 0;
+    begin();
+}
+
+void SimUart::begin() {
+    clearOutput();
+    requests = 0;
+    bytes = 0;
+    busyMicros = 0;
+}
+
+void SimUart::capture(uint8_t data) {
+    if (outputLength == SIM_UART_OUTPUT_SIZE) {
+        // keep the newer half
+        memmove(output, output + SIM_UART_OUTPUT_SIZE / 2, SIM_UART_OUTPUT_SIZE / 2);
+        outputLength = SIM_UART_OUTPUT_SIZE / 2;
+    }
+
+    output[outputLength++] = data;
+    output[outputLength] = '\0';
+
+    if (echo) putchar(data);
+}
+
+void SimUart::start(CByteStream_t *pStream) {
+    this->pStream = pStream;
+    pStream->flags |= STREAM_FLAGS_PROCESSING;
+
+    uint16_t byteCount = 0;
+    while (!stream_is_empty(pStream)) {
+        capture(stream_get(pStream));
+        byteCount++;
+    }
+
+    const time_t duration = (time_t) ((byteCount * 10ULL * 1000000ULL + baud - 1) / baud);
+
+    requests++;
+    bytes += byteCount;
+    busyMicros += duration;
+
+    simRuntime.scheduleEvent(duration, SimUart::completeRequest, this);
+}
+
+void SimUart::completeRequest(void *pParam) {
+    SimUart *thizz = (SimUart *) pParam;
+    CByteStream_t *pStream = thizz->pStream;
+
+    // completing the request can start the next one
+    thizz->pStream = NULL;
+    uart_complete_request(pStream);
+}
+
+#endif // CONSOLE_DEBUG
@@ -0,0 +1,99 @@
+#ifndef SCHEDULER_SIMUART_H
+#define SCHEDULER_SIMUART_H
+
+/*
+ * Simulated UART for the CONSOLE_DEBUG host build.
+ *
+ * UartController::startProcessingRequest() hands requests to simUart instead of uartint_start(). The request bytes
+ * are captured into an output buffer, optionally echoed to stdout, and the request is completed with
+ * uart_complete_request() after the time the transfer takes at the configured baud rate, 10 bits per byte, using a
+ * SimRuntime event.
+ *
+ * Usage:
+ *
+ *     simUart.setBaud(115200);
+ *     simRuntime.runMicros(1000000UL);
+ *     printf("%s", simUart.getOutput());
+ */
+
+#if defined(CONSOLE_DEBUG) && defined(INCLUDE_UART_MODULE)
+
+#include "SimRuntime.h"
+#include "CByteStream.h"
+#include "uartint.h"
+
+#ifndef SIM_UART_OUTPUT_SIZE
+#define SIM_UART_OUTPUT_SIZE        (4096)      // captured output, older output is discarded when full
+#endif
+
+class SimUart {
+    CByteStream_t *pStream;             // request being transferred
+    uint32_t baud;
+    uint8_t echo;                       // copy output to stdout
+
+    char output[SIM_UART_OUTPUT_SIZE + 1];
+    uint16_t outputLength;
+
+    // statistics
+    uint32_t requests;
+    uint32_t bytes;
+    sim_time_t busyMicros;
+
+    void capture(uint8_t data);
+    static void completeRequest(void *pParam);
+
+public:
+    SimUart();
+
+    /**
+     * Clear output and statistics
+     */
+    void begin();
+
+    inline void setBaud(uint32_t baud) {
+        this->baud = baud;
+    }
+
+    inline void setEcho(uint8_t echo) {
+        this->echo = echo;
+    }
+
+    /**
+     * Start processing request, called from UartController::startProcessingRequest()
+     */
+    void start(CByteStream_t *pStream);
+
+    NO_DISCARD inline uint8_t isBusy() const {
+        return pStream != NULL;
+    }
+
+    /**
+     * Captured output, NUL terminated
+     */
+    NO_DISCARD inline const char *getOutput() const {
+        return output;
+    }
+
+    inline void clearOutput() {
+        outputLength = 0;
+        output[0] = '\0';
+    }
+
+    NO_DISCARD inline uint32_t getRequests() const {
+        return requests;
+    }
+
+    NO_DISCARD inline uint32_t getBytes() const {
+        return bytes;
+    }
+
+    NO_DISCARD inline sim_time_t getBusyMicros() const {
+        return busyMicros;
+    }
+};
+
+extern SimUart simUart;
+
+#endif // CONSOLE_DEBUG
+
+#endif //SCHEDULER_SIMUART_H
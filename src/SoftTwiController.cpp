@@ -0,0 +1,51 @@
+#include "SoftTwiController.h"
+#include "twiint.h"
+
+#ifdef CONSOLE_DEBUG
+#include "SimTwi.h"
+
+void SoftTwiController::setSimBus(SimTwiBus *pBus) {
+    pSimBus = pBus;
+    pBus->setController(this);
+}
+
+#endif
+
+void SoftTwiController::begin() {
+#ifndef CONSOLE_DEBUG
+    softtwi_init(&softTwi, sdaPin, sclPin);
+#endif
+}
+
+void SoftTwiController::startProcessingRequest(ByteStream *pStream) {
+    pStream->flags |= STREAM_FLAGS_PROCESSING;
+    resumeService(0);
+}
+
+void SoftTwiController::service() {
+    // marks the next request as processing
+    Controller::service();
+
+    CLI();
+    ByteStream *pStream = getProcessingRequest();
+    SEI();
+    if (!pStream) return;
+
+#ifndef CONSOLE_DEBUG
+    const uint8_t result = softtwi_transfer(&softTwi, (CByteStream_t *) pStream);
+    if (result != SOFT_TWI_OK) {
+        // bit-bang transfer does not tell address from data NACK
+        pStream->error = result == SOFT_TWI_NACK ? TWI_ERR_SLA_NACK : TWI_ERR_TIMEOUT;
+    }
+
+    // called from task code, protect queues from interrupts, next request is started by the next pass
+    CLI_ONLY();
+    endProcessingRequest(pStream);
+    SEI();
+#else
+    // completed by a bus event, the same as by the transfer above
+    if (!pSimBus->isBusy()) {
+        pSimBus->start((CByteStream_t *) pStream);
+    }
+#endif
+}
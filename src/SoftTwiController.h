@@ -0,0 +1,84 @@
+#ifndef SCHEDULER_SOFTTWICONTROLLER_H
+#define SCHEDULER_SOFTTWICONTROLLER_H
+
+#include "Controller.h"
+#include "softtwi.h"
+
+#ifdef CONSOLE_DEBUG
+class SimTwiBus;
+#endif
+
+/**
+ * TWI requests on a second, bit-banged bus through the Controller request pipeline, see softtwi.h. Requests use
+ * the same stream format as TwiController, so the iox_* and dac_* helpers work with either controller's handle.
+ *
+ * Requests are transferred by service() with interrupts enabled, one request per pass of the controller's task or
+ * ControllerGroup, so other tasks run between transfers. The controller does not auto start requests,
+ * startProcessingRequest() only marks the request for the next service() pass and requests end without starting the
+ * next one. twi_wait_sent() calls service() while it waits.
+ *
+ * Usage:
+ *
+ *     ControllerStorage<4, 2, 16> stepperBusStorage;
+ *     SoftTwiController stepperBus(stepperBusStorage, SDA2_PIN, SCL2_PIN);
+ *
+ *     iox_out(stepperBus.getHandle(), IOX_I2C_ADDRESS(0), outputs);
+ *
+ * CONSOLE_DEBUG builds send requests to the SimTwiBus given to setSimBus().
+ */
+class SoftTwiController : public Controller {
+    CSoftTwi_t softTwi;
+    uint8_t sdaPin;
+    uint8_t sclPin;
+#ifdef CONSOLE_DEBUG
+    SimTwiBus *pSimBus;
+#endif
+
+public:
+    SoftTwiController(uint8_t *pData, uint8_t maxStreams, uint8_t maxTasks, uint8_t writeBufferSize, uint8_t sdaPin, uint8_t sclPin, uint8_t flags = 0)
+            : Controller(pData, maxStreams, maxTasks, writeBufferSize, flags), softTwi(), sdaPin(sdaPin), sclPin(sclPin) {
+#ifdef CONSOLE_DEBUG
+        pSimBus = NULL;
+#endif
+    }
+
+    template<uint16_t nStreams, uint16_t nTasks, uint16_t nBufferSize>
+    SoftTwiController(ControllerStorage<nStreams, nTasks, nBufferSize> &storage, uint8_t sdaPin, uint8_t sclPin, uint8_t flags = 0)
+            : Controller(storage, flags), softTwi(), sdaPin(sdaPin), sclPin(sclPin) {
+#ifdef CONSOLE_DEBUG
+        pSimBus = NULL;
+#endif
+    }
+
+    defineSchedulerTaskId("SoftTwiController");
+
+    /**
+     * @return requests which failed with NACK or clock stretch timeout, wraps around
+     */
+    NO_DISCARD inline uint16_t getErrors() const {
+        return softTwi.errors;
+    }
+
+#ifdef CONSOLE_DEBUG
+    /**
+     * Simulated bus for requests, its completed requests are ended on this controller
+     */
+    void setSimBus(SimTwiBus *pBus);
+#endif
+
+    void begin() override;
+
+    /**
+     * Mark request as processing, it is transferred by the next service() pass
+     *
+     * IMPORTANT: called with interrupts disabled
+     */
+    void startProcessingRequest(ByteStream *pStream) override;
+
+    /**
+     * Recycle completed requests, then transfer the next request
+     */
+    void service() override;
+};
+
+#endif //SCHEDULER_SOFTTWICONTROLLER_H
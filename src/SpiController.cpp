@@ -0,0 +1,28 @@
+#ifdef INCLUDE_SPI_MODULE
+
+#include "SpiController.h"
+
+#ifdef CONSOLE_DEBUG
+#include "SimSpi.h"
+#endif
+
+void spi_complete_request(CByteStream_t *pStream) {
+    spiController.endProcessingRequest((ByteStream *) pStream);
+
+    // requests complete in microseconds, recycle completed streams on next pass instead of the 20ms controller delay
+    spiController.resumeService(0);
+}
+
+void SpiController::startProcessingRequest(ByteStream *pStream) {
+    CLI();
+    resumeService(0);
+    SEI();
+
+#ifndef CONSOLE_DEBUG
+    spiint_start((CByteStream_t *) pStream);
+#else
+    simSpi.start((CByteStream_t *) pStream);
+#endif
+}
+
+#endif // INCLUDE_SPI_MODULE
@@ -0,0 +1,54 @@
+#ifndef SCHEDULER_SPICONTROLLER_H
+#define SCHEDULER_SPICONTROLLER_H
+
+#include "Controller.h"
+#include "spiint.h"
+
+/**
+ * SPI master requests through the Controller request pipeline. Streams are transferred from the SPI STC interrupt
+ * by spiint, producers use reserveResources() for admission control the same as for TwiController.
+ *
+ * Stream address is SPI_ADDRESS(csPin, mode), chip select and mode are per request so several devices can share the
+ * bus. Bytes read after the stream's bytes are sent go to the stream's read buffer, set with setRdBuffer(), with the
+ * same reverse buffer option as TWI reads.
+ *
+ * Usage:
+ *
+ *     ControllerStorage<SPI_MAX_STREAMS, SPI_MAX_TASKS, SPI_MAX_BUFFER> spiStorage;
+ *     SpiController spiController(spiStorage);
+ *
+ *     // in setup()
+ *     spiint_init();
+ *
+ *     // in a task
+ *     if (spiController.reserveResources(1, 2)) return;
+ *     ByteStream *pStream = spiController.getWriteStream();
+ *     pStream->setAddress(SPI_ADDRESS(10, SPI_MODE0));
+ *     pStream->put(READ_STATUS);
+ *     pStream->setRdBuffer(false, &status, 1);
+ *     spiController.processStream(pStream);
+ *     spiController.releaseResources();
+ *
+ * CONSOLE_DEBUG builds send requests to simSpi.
+ */
+class SpiController : public Controller {
+
+public:
+    SpiController(uint8_t *pData, uint8_t maxStreams, uint8_t maxTasks, uint8_t writeBufferSize, uint8_t flags = CTR_FLAGS_REQ_AUTO_START)
+            : Controller(pData, maxStreams, maxTasks, writeBufferSize, flags) {
+    }
+
+    template<uint16_t nStreams, uint16_t nTasks, uint16_t nBufferSize>
+    explicit SpiController(ControllerStorage<nStreams, nTasks, nBufferSize> &storage, uint8_t flags = CTR_FLAGS_REQ_AUTO_START)
+            : Controller(storage, flags) {
+    }
+
+    defineSchedulerTaskId("SpiController");
+
+    // IMPORTANT: must be called with interrupts disabled
+    void startProcessingRequest(ByteStream *pStream) override;
+};
+
+extern SpiController spiController;
+
+#endif //SCHEDULER_SPICONTROLLER_H
@@ -0,0 +1,166 @@
+#include "Ssd1306Updater.h"
+
+#ifdef GFX_PAGED_UPDATES
+
+#include "twiint.h"
+
+Ssd1306Updater::Ssd1306Updater() : Task() {
+    pController = NULL;
+    pFrame = NULL;
+    addr = SSD1306_I2C_ADDRESS;
+    width = 0;
+    pages = 0;
+    page = 0;
+    flags = 0;
+    bytesSent = 0;
+    pagesSent = 0;
+    sentPage = 0;
+    sentStart = 0;
+    sentEnd = 0;
+}
+
+void Ssd1306Updater::init(Controller *pController, const uint8_t *pFrame, uint8_t width, uint8_t height, uint8_t addr) {
+    this->pController = pController;
+    this->pFrame = pFrame;
+    this->width = width > SSD1306_MAX_WIDTH ? SSD1306_MAX_WIDTH : width;
+    this->pages = height >> 3 > SSD1306_MAX_PAGES ? SSD1306_MAX_PAGES : height >> 3;
+    this->addr = addr;
+    page = 0;
+    flags |= SSD1306_FLAGS_IDLE;
+    markAllDirty();
+}
+
+void Ssd1306Updater::begin() {
+    // idle until init() if not initialized yet
+    if (pFrame) {
+        resumeMicros(0);
+    } else {
+        flags |= SSD1306_FLAGS_IDLE;
+        suspend();
+    }
+}
+
+void Ssd1306Updater::markDirty(int16_t x0, int16_t y0, int16_t x1, int16_t y1) {
+    if (x0 > x1 || y0 > y1 || x1 < 0 || y1 < 0 || x0 >= width || y0 >= pages * 8) return;
+
+    const uint8_t start = x0 < 0 ? 0 : x0;
+    const uint8_t end = x1 >= width ? width : x1 + 1;
+    const uint8_t lastPage = y1 >= pages * 8 ? pages - 1 : y1 >> 3;
+
+    for (uint8_t p = y0 < 0 ? 0 : y0 >> 3; p <= lastPage; p++) {
+        if (dirtyStart[p] >= dirtyEnd[p]) {
+            dirtyStart[p] = start;
+            dirtyEnd[p] = end;
+        } else {
+            if (dirtyStart[p] > start) dirtyStart[p] = start;
+            if (dirtyEnd[p] < end) dirtyEnd[p] = end;
+        }
+    }
+
+    // only resume if idle, not while waiting for the page request or for resources
+    if (flags & SSD1306_FLAGS_IDLE) {
+        flags &= ~SSD1306_FLAGS_IDLE;
+        resumeMicros(0);
+    }
+}
+
+void Ssd1306Updater::markAllDirty() {
+    markDirty(0, 0, width - 1, pages * 8 - 1);
+}
+
+uint8_t Ssd1306Updater::isDirty() const {
+    for (uint8_t p = 0; p < pages; p++) {
+        if (dirtyStart[p] < dirtyEnd[p]) return 1;
+    }
+    return 0;
+}
+
+// IMPORTANT: called from interrupt
+void Ssd1306Updater::pageSent(const CByteStream_t *pStream) {
+    Ssd1306Updater *pUpdater = (Ssd1306Updater *) pStream->pCallbackParam;
+
+    if (pStream->error) {
+        pUpdater->flags |= SSD1306_FLAGS_RESEND;
+    }
+    pUpdater->flags &= ~SSD1306_FLAGS_SENDING;
+    pUpdater->resumeMicros(0);
+}
+
+void Ssd1306Updater::loop() {
+    CLI();
+    if (flags & SSD1306_FLAGS_SENDING) {
+        // pageSent() resumes
+        suspend();
+        SEI();
+        return;
+    }
+    SEI();
+
+    if (flags & SSD1306_FLAGS_RESEND) {
+        flags &= ~SSD1306_FLAGS_RESEND;
+        markDirty(sentStart, sentPage * 8, sentEnd - 1, sentPage * 8);
+    }
+
+    // next dirty page, round-robin so a page being redrawn all the time does not hold back the others
+    uint8_t p = page;
+    for (uint8_t i = 0; dirtyStart[p] >= dirtyEnd[p]; i++) {
+        if (i == pages) {
+            flags |= SSD1306_FLAGS_IDLE;
+            suspend();
+            return;
+        }
+        if (++p == pages) p = 0;
+    }
+
+    // resumed when resources are available
+    if (pController->reserveResources(1, 0)) return;
+
+    const uint8_t start = dirtyStart[p];
+    const uint8_t end = dirtyEnd[p];
+    const uint8_t count = end - start;
+
+    dirtyStart[p] = 0;
+    dirtyEnd[p] = 0;
+    page = p + 1 == pages ? 0 : p + 1;
+    sentPage = p;
+    sentStart = start;
+    sentEnd = end;
+
+    uint8_t *pData = pageData;
+    *pData++ = SSD1306_CTRL_COMMAND;
+    *pData++ = SSD1306_COLUMN_ADDRESS;
+    *pData++ = SSD1306_CTRL_COMMAND;
+    *pData++ = start;
+    *pData++ = SSD1306_CTRL_COMMAND;
+    *pData++ = end - 1;
+    *pData++ = SSD1306_CTRL_COMMAND;
+    *pData++ = SSD1306_PAGE_ADDRESS;
+    *pData++ = SSD1306_CTRL_COMMAND;
+    *pData++ = p;
+    *pData++ = SSD1306_CTRL_COMMAND;
+    *pData++ = p;
+    *pData++ = SSD1306_CTRL_DATA;
+    memcpy(pData, pFrame + (uint16_t) p * width + start, count);
+
+    ByteStream *pStream = pController->getWriteStream();
+    pStream->setOwnBuffer(pageData, SSD1306_PAGE_HEADER + count + 1);
+    pStream->setAddress(TWI_ADDRESS_W(addr));
+    pStream->setCallback(pageSent, this);
+
+    // suspend before the request, it can complete before processStream() returns
+    flags |= SSD1306_FLAGS_SENDING;
+    suspend();
+
+    if (!pController->processStream(pStream)) {
+        // not sent, span is sent on the next run
+        flags = (flags & ~SSD1306_FLAGS_SENDING) | SSD1306_FLAGS_RESEND;
+        resumeMicros(SSD1306_RETRY_MICROS);
+    } else {
+        bytesSent += SSD1306_PAGE_HEADER + count;
+        pagesSent++;
+    }
+
+    pController->releaseResources();
+}
+
+#endif // GFX_PAGED_UPDATES
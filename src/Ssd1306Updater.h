@@ -0,0 +1,121 @@
+#ifndef SCHEDULER_SSD1306UPDATER_H
+#define SCHEDULER_SSD1306UPDATER_H
+
+#include "Scheduler.h"
+#include "Controller.h"
+
+#ifdef GFX_PAGED_UPDATES
+
+/**
+ * Incremental SSD1306 display update, sends only the changed column span of each page of the frame buffer.
+ *
+ * Drawing code marks what it changed with markDirty(), the task sends one dirty page per run and suspends until it
+ * is sent. A page is one own buffer request of the column and page address commands, each with a continuation
+ * control byte, followed by the span's data, so a retried request starts at the right address. Each page takes one
+ * reserveResources() of a request and no write buffer bytes, the data is copied to the updater's page buffer so
+ * drawing can go on while it is sent. Other tasks get the bus between pages.
+ *
+ * The frame buffer is the display library's, pages of width bytes with the top pixel in bit 0, and the display must
+ * be in horizontal addressing mode, which is the SSD1306 setup of the usual libraries. A few changed digits in one
+ * text line are one or two pages of tens of bytes, instead of the full frame of 1024 bytes.
+ *
+ * Usage:
+ *
+ *     Ssd1306Updater displayUpdater;
+ *
+ *     // in setup(), after display initialization
+ *     displayUpdater.init(&twiController, display.getBuffer());
+ *
+ *     // after drawing
+ *     display.print(count);
+ *     displayUpdater.markDirty(x, y, x + w - 1, y + h - 1);
+ */
+
+#ifndef SSD1306_I2C_ADDRESS
+#define SSD1306_I2C_ADDRESS         (0x3C)
+#endif
+
+#ifndef SSD1306_RETRY_MICROS
+#define SSD1306_RETRY_MICROS        (1000L)     // page retry delay when no request is free
+#endif
+
+#define SSD1306_MAX_WIDTH           (128)
+#define SSD1306_MAX_PAGES           (8)
+
+#define SSD1306_CTRL_COMMAND        (0x80)      // control byte, one command byte and another control byte follow
+#define SSD1306_CTRL_DATA           (0x40)      // control byte, display data follows
+#define SSD1306_COLUMN_ADDRESS      (0x21)      // start and end column
+#define SSD1306_PAGE_ADDRESS        (0x22)      // start and end page
+#define SSD1306_PAGE_HEADER         (13)        // address commands and data control byte ahead of span data
+
+#define SSD1306_FLAGS_SENDING       (0x01)      // page data request outstanding, pageSent() resumes
+#define SSD1306_FLAGS_IDLE          (0x02)      // no dirty pages, markDirty() resumes
+#define SSD1306_FLAGS_RESEND        (0x04)      // page request failed, span is sent again
+
+class Ssd1306Updater : public Task {
+    Controller *pController;
+    const uint8_t *pFrame;
+    uint8_t addr;
+    uint8_t width;
+    uint8_t pages;
+    uint8_t page;                               // next page to check for changes
+    volatile uint8_t flags;
+
+    uint8_t dirtyStart[SSD1306_MAX_PAGES];      // first changed column of page
+    uint8_t dirtyEnd[SSD1306_MAX_PAGES];        // column after last changed one, not greater than dirtyStart if none
+
+    uint8_t pageData[SSD1306_PAGE_HEADER + SSD1306_MAX_WIDTH + 1];    // page request in flight, own buffer spare byte
+    uint8_t sentPage;                           // page and span of pageData
+    uint8_t sentStart;
+    uint8_t sentEnd;
+
+    uint32_t bytesSent;
+    uint16_t pagesSent;
+
+    static void pageSent(const CByteStream_t *pStream);
+
+public:
+    Ssd1306Updater();
+
+    /**
+     * Set the display, whole frame is dirty
+     *
+     * @param pController   controller of the display's bus
+     * @param pFrame        display library frame buffer
+     * @param width         display width
+     * @param height        display height, multiple of 8
+     * @param addr          display 7 bit address
+     */
+    void init(Controller *pController, const uint8_t *pFrame, uint8_t width = SSD1306_MAX_WIDTH, uint8_t height = SSD1306_MAX_PAGES * 8, uint8_t addr = SSD1306_I2C_ADDRESS);
+
+    void begin() override;
+
+    void loop() override;
+
+    /**
+     * Mark changed rectangle, inclusive coordinates, clipped to the display
+     */
+    void markDirty(int16_t x0, int16_t y0, int16_t x1, int16_t y1);
+
+    void markAllDirty();
+
+    NO_DISCARD uint8_t isDirty() const;
+
+    NO_DISCARD inline uint8_t isSending() const {
+        return flags & SSD1306_FLAGS_SENDING;
+    }
+
+    NO_DISCARD inline uint32_t getBytesSent() const {
+        return bytesSent;
+    }
+
+    NO_DISCARD inline uint16_t getPagesSent() const {
+        return pagesSent;
+    }
+
+    defineSchedulerTaskId("Ssd1306Updater");
+};
+
+#endif // GFX_PAGED_UPDATES
+
+#endif //SCHEDULER_SSD1306UPDATER_H
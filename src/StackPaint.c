@@ -0,0 +1,45 @@
+#include "StackPaint.h"
+
+#ifndef CONSOLE_DEBUG
+
+#include <avr/io.h>
+
+extern uint8_t __heap_start;
+extern void *__brkval;
+
+static inline uint8_t *stack_heap_end(void) {
+    return __brkval ? (uint8_t *) __brkval : &__heap_start;
+}
+
+void stack_paint(void) {
+    CLI();
+    uint8_t *p = stack_heap_end();
+    uint8_t *pEnd = (uint8_t *) SP - STACK_PAINT_GUARD;
+
+    while (p < pEnd) {
+        *p++ = STACK_PAINT_PATTERN;
+    }
+    SEI();
+}
+
+uint16_t stack_unused(void) {
+    const uint8_t *p = stack_heap_end();
+    const uint8_t *pEnd = (const uint8_t *) SP;
+    uint16_t count = 0;
+
+    while (p < pEnd && *p == STACK_PAINT_PATTERN) {
+        p++;
+        count++;
+    }
+    return count;
+}
+
+uint16_t stack_depth(void) {
+    return RAMEND - SP;
+}
+
+uint16_t stack_max_depth(void) {
+    return RAMEND + 1 - (uint16_t) stack_heap_end() - stack_unused();
+}
+
+#endif
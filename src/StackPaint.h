@@ -0,0 +1,64 @@
+#ifndef SCHEDULER_STACKPAINT_H
+#define SCHEDULER_STACKPAINT_H
+
+/*
+ * Main stack high-water measurement by stack painting.
+ *
+ * stack_paint() fills free RAM between the end of the heap and the current stack pointer with STACK_PAINT_PATTERN,
+ * stack_unused() counts the pattern bytes which were never overwritten, starting from the end of the heap. The
+ * result includes interrupt handlers and async task stacks restored onto the main stack by resumeContext().
+ *
+ * Call stack_paint() once, early in setup(), Scheduler::begin() does it under SERIAL_DEBUG_SCHEDULER_MAX_STACKS.
+ * Heap growth after painting is not a problem since counting starts at the current end of the heap.
+ *
+ * CONSOLE_DEBUG builds have no main stack to measure, all functions return 0.
+ */
+
+#include "Arduino.h"
+#include "common_defs.h"
+
+#define STACK_PAINT_PATTERN     (0xC5)
+#define STACK_PAINT_GUARD       (16)        // bytes below stack pointer not painted, used by stack_paint() itself
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef CONSOLE_DEBUG
+
+/**
+ * Paint free RAM between the end of the heap and the stack pointer
+ */
+extern void stack_paint(void);
+
+/**
+ * Count painted bytes from end of heap to first overwritten byte
+ *
+ * @return  minimum free RAM between heap and stack since stack_paint()
+ */
+extern uint16_t stack_unused(void);
+
+/**
+ * @return  current main stack depth in bytes
+ */
+extern uint16_t stack_depth(void);
+
+/**
+ * @return  maximum main stack depth in bytes since stack_paint()
+ */
+extern uint16_t stack_max_depth(void);
+
+#else
+
+#define stack_paint()           ((void)0)
+#define stack_unused()          ((uint16_t)0)
+#define stack_depth()           ((uint16_t)0)
+#define stack_max_depth()       ((uint16_t)0)
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //SCHEDULER_STACKPAINT_H
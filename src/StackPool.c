@@ -0,0 +1,73 @@
+#include "StackPool.h"
+
+#if defined(ASYNC_STACK_POOL) && !defined(CONSOLE_DEBUG)
+
+// blocks are a uint16_t header with the size of the data following it and STACK_POOL_BLOCK_USED bit, the blocks
+// cover the whole pool. Free blocks are merged with following free blocks during allocation.
+static uint8_t *pStackPool;
+static uint16_t nStackPoolSize;
+
+uint16_t stack_pool_used;
+uint16_t stack_pool_max_used;
+uint8_t stack_pool_failures;
+
+#define blockHeader(p)      (*(uint16_t *) (p))
+
+void stack_pool_init(uint8_t *pPool, uint16_t nSize) {
+    pStackPool = pPool;
+    nStackPoolSize = nSize > STACK_POOL_BLOCK_HEADER ? nSize : 0;
+    if (nStackPoolSize) {
+        blockHeader(pPool) = nSize - STACK_POOL_BLOCK_HEADER;
+    }
+
+    stack_pool_used = 0;
+    stack_pool_max_used = 0;
+    stack_pool_failures = 0;
+}
+
+uint8_t *stack_pool_alloc(uint8_t nSize) {
+    uint8_t *p = pStackPool;
+    uint8_t *pEnd = pStackPool + nStackPoolSize;
+
+    while (p < pEnd) {
+        uint16_t nBlock = blockHeader(p) & ~STACK_POOL_BLOCK_USED;
+
+        if (!(blockHeader(p) & STACK_POOL_BLOCK_USED)) {
+            uint8_t *pNext = p + STACK_POOL_BLOCK_HEADER + nBlock;
+            while (pNext < pEnd && !(blockHeader(pNext) & STACK_POOL_BLOCK_USED)) {
+                nBlock += STACK_POOL_BLOCK_HEADER + blockHeader(pNext);
+                pNext = p + STACK_POOL_BLOCK_HEADER + nBlock;
+            }
+
+            if (nBlock >= nSize) {
+                // split if the rest can hold a block with data
+                if (nBlock > nSize + STACK_POOL_BLOCK_HEADER) {
+                    blockHeader(p + STACK_POOL_BLOCK_HEADER + nSize) = nBlock - nSize - STACK_POOL_BLOCK_HEADER;
+                    nBlock = nSize;
+                }
+
+                blockHeader(p) = nBlock | STACK_POOL_BLOCK_USED;
+                stack_pool_used += STACK_POOL_BLOCK_HEADER + nBlock;
+                if (stack_pool_max_used < stack_pool_used) stack_pool_max_used = stack_pool_used;
+                return p + STACK_POOL_BLOCK_HEADER;
+            }
+
+            blockHeader(p) = nBlock;
+        }
+
+        p += STACK_POOL_BLOCK_HEADER + nBlock;
+    }
+
+    if (stack_pool_failures < 255) stack_pool_failures++;
+    return NULL;
+}
+
+void stack_pool_free(uint8_t *pBlock) {
+    uint8_t *p = pBlock - STACK_POOL_BLOCK_HEADER;
+    const uint16_t nBlock = blockHeader(p) & ~STACK_POOL_BLOCK_USED;
+
+    blockHeader(p) = nBlock;
+    stack_pool_used -= STACK_POOL_BLOCK_HEADER + nBlock;
+}
+
+#endif
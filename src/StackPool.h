@@ -0,0 +1,68 @@
+#ifndef SCHEDULER_STACKPOOL_H
+#define SCHEDULER_STACKPOOL_H
+
+/*
+ * Shared stack pool for async task contexts, enabled with ASYNC_STACK_POOL compile definition, AVR only.
+ *
+ * In pooled mode an AsyncContext has no stack buffer. yieldContext() saves the task's live stack slice in a block
+ * allocated from the pool and resumeContext() frees it after restoring the stack, so the pool only needs to hold
+ * the stacks of tasks which are yielded at the same time, instead of every task's worst case stack.
+ *
+ * When the pool has no free block large enough, yieldContext() does not yield, returns 1 to the task right away and
+ * stack_pool_failures is incremented. AsyncTask yield functions return it, lock and signal waits then return 1 the
+ * same as for a Task, which is suspended and has its loop() called from the start when resumed. Size the pool so
+ * this does not happen, stack_pool_max_used gives the peak working set including block headers.
+ *
+ * Usage, in the main sketch before scheduler.begin():
+ *
+ *     uint8_t stackPool[sizeOfStackPool(160, 4)];     // up to 4 yielded tasks using 160 bytes in total
+ *
+ *     stack_pool_init(stackPool, sizeof(stackPool));
+ *
+ * Task stacks are still declared with sizeOfStack(), which is only the context in pooled mode.
+ */
+
+#include "common_defs.h"
+
+#define STACK_POOL_BLOCK_USED       (0x8000)
+#define STACK_POOL_BLOCK_HEADER     (sizeof(uint16_t))
+
+// Use this macro to allocate the pool for total stack bytes of up to blocks concurrently yielded tasks
+#define sizeOfStackPool(bytes, blocks)  ((bytes) + STACK_POOL_BLOCK_HEADER * (blocks))
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern uint16_t stack_pool_used;            // bytes in allocated blocks, including headers
+extern uint16_t stack_pool_max_used;        // peak of stack_pool_used
+extern uint8_t stack_pool_failures;         // yields which did not get a block, saturates at 255
+
+/**
+ * Set the pool buffer, must be called before any async task yields
+ *
+ * @param pPool     pool buffer
+ * @param nSize     size of pool buffer, use sizeOfStackPool()
+ */
+extern void stack_pool_init(uint8_t *pPool, uint16_t nSize);
+
+/**
+ * Allocate first fitting block, called from yieldContext()
+ *
+ * @param nSize     bytes needed
+ * @return          block or NULL if none large enough is free
+ */
+extern uint8_t *stack_pool_alloc(uint8_t nSize);
+
+/**
+ * Free block, called from resumeContext()
+ *
+ * @param pBlock    block from stack_pool_alloc()
+ */
+extern void stack_pool_free(uint8_t *pBlock);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //SCHEDULER_STACKPOOL_H
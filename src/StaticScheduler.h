@@ -0,0 +1,356 @@
+#ifndef SCHEDULER_STATICSCHEDULER_H
+#define SCHEDULER_STATICSCHEDULER_H
+
+#include "Arduino.h"
+#include "Scheduler.h"
+
+/*
+ * Compile time task list alternative to Scheduler.
+ *
+ * Tasks derive from StaticTask<Derived> or StaticAsyncTask<Derived> and have no vtable. Each task keeps its own
+ * resume timestamp, so there is no separate delay table or PROGMEM task pointer table. The scheduler is
+ * instantiated with the list of task instances and calls begin()/loop() of each task directly, task ids are the
+ * positions in the list and async-ness is a compile time constant of the task type.
+ *
+ * RAM per task is 4 bytes for the resume time, vs 7 bytes for Task (vtable pointer, taskId and delay table entry).
+ *
+ * CAVEAT: static tasks are not Task instances and are not known to the global scheduler, so they cannot use
+ *   Mutex, Signal, Res2Lock or Controller::reserveResources(), which suspend and resume tasks by Scheduler task id.
+ *
+ * begin() and loop() of the derived class are called non-virtually, so they must be public or the derived class
+ * must declare StaticTask<Derived> a friend.
+ *
+ * Usage:
+ *
+ *     class Blinker : public StaticTask<Blinker> {
+ *     public:
+ *         void begin() { resume(0); }
+ *         void loop() { ...; resume(500); }
+ *     } blinker;
+ *
+ *     StaticScheduler<staticTaskEntry(blinker), staticTaskEntry(updater)> staticScheduler;
+ */
+
+template<class... Entries>
+class StaticScheduler;
+
+template<class T>
+class StaticTask {
+    template<class...> friend
+    class StaticScheduler;
+
+protected:
+    time_t resumeTime;      // task ready timestamp, TASK_DELAY_SUSPENDED if suspended
+
+    // call derived class loop() directly, hidden by StaticAsyncTask to resume its context instead
+    inline void execute() {
+        static_cast<T *>(this)->loop();
+    }
+
+    inline void start() {
+        static_cast<T *>(this)->begin();
+    }
+
+public:
+    inline StaticTask() {
+        resumeTime = TASK_DELAY_SUSPENDED;
+    }
+
+    static constexpr uint8_t isAsync() {
+        return false;
+    }
+
+    /**
+     * Test if the task is ready to run
+     *
+     * @param now   sched_micros() timestamp
+     * @return      true if not suspended and resume time has elapsed
+     */
+    NO_DISCARD inline uint8_t isReady(time_t now) const {
+        return resumeTime != TASK_DELAY_SUSPENDED && is_elapsed(now, resumeTime);
+    }
+
+    /**
+     * Suspend this task, its loop() will not be called until resumed
+     */
+    inline void suspend() {
+        resumeTime = TASK_DELAY_SUSPENDED;
+    }
+
+    /**
+     * Resume this task after given delay in microseconds
+     *
+     * @param microseconds delay in microseconds to wait before resuming calls to loop()
+     */
+    inline void resumeMicros(time_t microseconds) {
+        resumeTime = resume_time_micros(microseconds);
+    }
+
+    /**
+     * Resume this task after given delay in milliseconds
+     *
+     * @param milliseconds delay in milliseconds to wait before resuming calls to loop()
+     */
+    inline void resume(uint16_t milliseconds) {
+        resumeMicros(milliseconds * 1000UL);
+    }
+
+    NO_DISCARD inline uint8_t isSuspended() const {
+        return resumeTime == TASK_DELAY_SUSPENDED;
+    }
+
+    NO_DISCARD inline time_t getResumeMicros() const {
+        return resumeTime;
+    }
+};
+
+template<class T>
+class StaticAsyncTask : public StaticTask<T> {
+    template<class...> friend
+    class StaticScheduler;
+
+protected:
+    AsyncContext *pContext;
+
+    inline void execute() {
+        resumeContext(pContext);
+    }
+
+public:
+    /**
+     * Constructor of a yielding static task.
+     *
+     * @param pStack    stack buffer, at least sizeOfStack(stackMax)
+     * @param stackMax  size of stack buffer
+     */
+    StaticAsyncTask(uint8_t *pStack, uint8_t stackMax) {
+        pContext = (AsyncContext *) pStack;
+        initContext(pStack, StaticAsyncTask::yieldingLoop, this, stackMax);
+    }
+
+    static constexpr uint8_t isAsync() {
+        return true;
+    }
+
+    /**
+     * Suspend the task's execution and yield context, returns after the task is resumed.
+     *
+     * @return 0 if yielded, 1 if no yield because ASYNC_STACK_POOL is exhausted, the task stays suspended
+     */
+    inline uint8_t yieldSuspend() {
+        this->suspend();
+        return yieldContext();
+    }
+
+    /**
+     * Set the resume microseconds and yield the task's execution context.
+     *
+     * @param microseconds delay in microseconds before resuming task
+     * @return 0 if yielded, 1 if no yield because ASYNC_STACK_POOL is exhausted
+     */
+    inline uint8_t yieldResumeMicros(time_t microseconds) {
+        this->resumeMicros(microseconds);
+        return yieldContext();
+    }
+
+    /**
+     * Set the resume milliseconds and yield the task's execution context.
+     *
+     * @param milliseconds delay in milliseconds before resuming task
+     * @return 0 if yielded, 1 if no yield because ASYNC_STACK_POOL is exhausted
+     */
+    inline uint8_t yieldResume(uint16_t milliseconds) {
+        this->resume(milliseconds);
+        return yieldContext();
+    }
+
+    /**
+     * Yield cpu to other tasks. Returns to caller after the task was resumed.
+     *
+     * @return 0 if yielded, 1 if no yield because ASYNC_STACK_POOL is exhausted
+     */
+    inline uint8_t yield() {
+        this->resume(0);
+        return yieldContext();
+    }
+
+    NO_DISCARD inline uint8_t hasYielded() const {
+        return pContext->stackUsed;
+    }
+
+    NO_DISCARD inline uint8_t maxStackUsed() const {
+        return pContext->stackMaxUsed;
+    }
+
+    NO_DISCARD inline uint8_t maxStack() const {
+        return pContext->stackMax;
+    }
+
+private:
+    static void yieldingLoop(void *arg) {
+        static_cast<T *>(static_cast<StaticAsyncTask *>(arg))->loop();
+    }
+};
+
+/**
+ * Task list entry, binds task type and instance at compile time. Use staticTaskEntry(task) to declare.
+ */
+template<class T, T &task>
+struct StaticTaskEntry {
+    typedef T TaskType;
+
+    static inline T &get() {
+        return task;
+    }
+};
+
+#define staticTaskEntry(task)   StaticTaskEntry<decltype(task), task>
+
+template<class E, class... Entries>
+struct StaticTaskIndex;
+
+template<class E, class... Entries>
+struct StaticTaskIndex<E, E, Entries...> {
+    static constexpr uint8_t value = 0;
+};
+
+template<class E, class F, class... Entries>
+struct StaticTaskIndex<E, F, Entries...> {
+    static constexpr uint8_t value = 1 + StaticTaskIndex<E, Entries...>::value;
+};
+
+template<class... Entries>
+class StaticScheduler {
+    static_assert(sizeof...(Entries) > 0, "StaticScheduler: needs at least one task");
+    static_assert(sizeof...(Entries) < NULL_TASK, "StaticScheduler: too many tasks");
+
+    uint8_t flags;
+    uint8_t nextTask;               // id of task to check first on next loop(), set when timeSlice ran out
+    time_t startLoopMicros;         // micros for last loopMicros() invocation
+    time_t startTaskMicros;         // micros for last task invocation
+
+    // unrolled at compile time into a chain of id compares with direct calls, which the compiler turns into a switch
+    template<uint8_t index, class... Es>
+    struct Dispatch {
+        static inline void begin() { }
+
+        static inline uint8_t run(uint8_t id, time_t now) { return 0; }
+
+        static inline uint8_t isAsync(uint8_t id) { return 0; }
+    };
+
+    template<uint8_t index, class E, class... Es>
+    struct Dispatch<index, E, Es...> {
+        static inline void begin() {
+            E::get().start();
+            Dispatch<index + 1, Es...>::begin();
+        }
+
+        static inline uint8_t run(uint8_t id, time_t now) {
+            if (id == index) {
+                typename E::TaskType &task = E::get();
+                if (!task.isReady(now)) return 0;
+                task.execute();
+                return 1;
+            }
+            return Dispatch<index + 1, Es...>::run(id, now);
+        }
+
+        static inline uint8_t isAsync(uint8_t id) {
+            return id == index ? E::TaskType::isAsync() : Dispatch<index + 1, Es...>::isAsync(id);
+        }
+    };
+
+public:
+    StaticScheduler() {
+        flags = 0;
+        nextTask = 0;
+        startLoopMicros = 0;
+        startTaskMicros = 0;
+    }
+
+    static constexpr uint8_t getTaskCount() {
+        return sizeof...(Entries);
+    }
+
+    /**
+     * Compile time task id of a task entry
+     */
+    template<class E>
+    static constexpr uint8_t getTaskId() {
+        return StaticTaskIndex<E, Entries...>::value;
+    }
+
+    static inline uint8_t isAsyncTask(uint8_t taskId) {
+        return Dispatch<0, Entries...>::isAsync(taskId);
+    }
+
+    NO_DISCARD inline uint8_t isInLoop() const {
+        return flags & SCHED_FLAGS_IN_LOOP;
+    }
+
+    NO_DISCARD inline time_t getStartLoopMicros() const {
+        return startLoopMicros;
+    }
+
+    NO_DISCARD inline time_t getStartTaskMicros() const {
+        return startTaskMicros;
+    }
+
+    /**
+     * Startup scheduler and call begin() of all tasks
+     */
+    void begin() {
+        startLoopMicros = sched_micros();
+        Dispatch<0, Entries...>::begin();
+    }
+
+    /**
+     * call loop() of ready tasks, return when all ready tasks have been called once or time slice exceeded
+     *
+     * @param timeSlice     maximum time allotted to single loop() in microseconds, 0 means no limit, see Scheduler::loopMicros()
+     */
+    void loopMicros(time_t timeSlice = 0) {
+        // clock is read here and after each task that runs, not for every task slot
+        time_t now = sched_micros();
+        const time_t tick = now;
+
+#if defined(SCHED_MIN_LOOP_TIMESLICE_MICROS) && SCHED_MIN_LOOP_TIMESLICE_MICROS
+        if (!is_elapsed(tick, startLoopMicros + SCHED_MIN_LOOP_TIMESLICE_MICROS)) {
+            // this is to avoid needlessly scanning the tasks too frequently
+            return;
+        }
+#endif
+
+        flags |= SCHED_FLAGS_IN_LOOP;
+        startLoopMicros = tick;
+
+        const time_t timeSliceLimit = timeSlice + tick;
+        uint8_t id = nextTask;
+        nextTask = 0;
+
+        for (uint8_t i = 0; i < getTaskCount(); i++) {
+            startTaskMicros = now;
+
+            if (Dispatch<0, Entries...>::run(id, now)) {
+                now = sched_micros();
+                if (timeSlice && is_elapsed(now, timeSliceLimit)) {
+                    // next time continue checking after the current task
+                    nextTask = id + 1;
+                    if (nextTask >= getTaskCount()) nextTask = 0;
+                    break;
+                }
+            }
+
+            if (++id >= getTaskCount()) id = 0;
+        }
+
+        flags &= ~SCHED_FLAGS_IN_LOOP;
+    }
+
+    inline void loop(uint16_t timeSlice = 0) {
+        loopMicros(timeSlice * 1000UL);
+    }
+};
+
+#endif //SCHEDULER_STATICSCHEDULER_H
@@ -0,0 +1,177 @@
+#ifdef INCLUDE_STEPQ_MODULE
+
+#include "StepQueue.h"
+#include "twiint.h"
+
+#ifdef CONSOLE_DEBUG
+#include "SimRuntime.h"
+#endif
+
+void stepq_timer_event(void) {
+    stepQueue.timerEvent();
+}
+
+StepQueue::StepQueue() {
+    pIox = NULL;
+    pController = NULL;
+    nHead = 0;
+    nTail = 0;
+    state = STEP_QUEUE_IDLE;
+    nextStream = 0;
+    headLate = 0;
+    lastStepTime = 0;
+    streams[0].flags = 0;
+    streams[1].flags = 0;
+    steps = 0;
+    lateSteps = 0;
+}
+
+void StepQueue::begin(CIOExpander_t *pIox) {
+    cancel();
+    this->pIox = pIox;
+    pController = Controller::fromHandle(pIox->pCtrl);
+}
+
+#ifdef CONSOLE_DEBUG
+
+void StepQueue::simTimerEvent(void *pParam) {
+    ((StepQueue *) pParam)->timerEvent();
+}
+
+#endif
+
+uint8_t StepQueue::arm(time_t time) {
+#ifndef CONSOLE_DEBUG
+    return stepqint_arm(time);
+#else
+    const int32_t remaining = (int32_t) (time - sched_micros());
+    if (remaining < STEPQINT_MIN_MICROS) return 0;
+
+    simRuntime.scheduleEvent(remaining, simTimerEvent, this);
+    return 1;
+#endif
+}
+
+void StepQueue::disarm() {
+#ifndef CONSOLE_DEBUG
+    stepqint_disarm();
+#else
+    simRuntime.cancelEvents(simTimerEvent, this);
+#endif
+}
+
+uint8_t StepQueue::add(time_t time, uint8_t ccwDir) {
+    CLI();
+    const uint8_t next = (nTail + 1) & (STEP_QUEUE_SIZE - 1);
+    if (next == nHead) {
+        SEI();
+        return 0;
+    }
+
+    stepTimes[nTail] = time;
+    stepPhases[nTail] = ciox_next_phase(pIox, ccwDir);
+    nTail = next;
+
+    if (state == STEP_QUEUE_IDLE) {
+        state = STEP_QUEUE_HOLD;
+        timerEvent();
+    }
+    SEI();
+    return 1;
+}
+
+void StepQueue::cancel() {
+    CLI();
+    disarm();
+    nHead = nTail;
+    headLate = 0;
+
+    if (state == STEP_QUEUE_STEP) {
+        pController->releaseRequests();
+    }
+    state = STEP_QUEUE_IDLE;
+    SEI();
+}
+
+// IMPORTANT: called with interrupts disabled
+void StepQueue::countLate() {
+    // retries of the same step are not counted again
+    if (!headLate) {
+        headLate = 1;
+        lateSteps++;
+    }
+}
+
+// IMPORTANT: called with interrupts disabled
+uint8_t StepQueue::startStep() {
+    CByteStream_t *pStream = streams + nextStream;
+
+    // stream still in use or a priority request is outstanding, previous step or another user's, which can only be one
+    if ((pStream->flags & (STREAM_FLAGS_PENDING | STREAM_FLAGS_PROCESSING)) || pController->hasPriorityRequest()) {
+        return 0;
+    }
+
+    pIox->outputs = (pIox->outputs & ~IOX_OUT_MOT_PHASES) | stepPhases[nHead] | IOX_OUT_MOT_EN;
+    pIox->lastOutputs = pIox->outputs;
+    pIox->flags |= IOX_FLAGS_STEPPING;
+    pIox->stepStartTick = sched_micros();
+    pIox->stepPeriod = stepTimes[nHead] - lastStepTime;
+    lastStepTime = stepTimes[nHead];
+
+    queue_init(&pStream->byteQueue, streamData[nextStream], sizeof(streamData[0]));
+    queue_put(&pStream->byteQueue, IOX_REG_OUTPUT_PORT0);
+    queue_put(&pStream->byteQueue, pIox->outputs);
+
+    pStream->flags = STREAM_FLAGS_RD | STREAM_FLAGS_UNBUFFERED | STREAM_FLAGS_PENDING;
+    pStream->addr = TWI_ADDRESS_W(IOX_I2C_ADDRESS(pIox->flags & IOX_FLAGS_ADDRESS));
+    pStream->fCallback = ciox_step_callback;
+    pStream->pCallbackParam = pIox;
+#ifdef SERIAL_DEBUG_TWI_REQ_TIMING
+    pStream->startTime = 0;
+#endif
+    pStream->nRdSize = 0;
+    pStream->pRdData = NULL;
+    pStream->error = 0;
+
+    nextStream ^= 1;
+    steps++;
+
+    if (!pController->startPriorityRequest((ByteStream *) pStream)) {
+        // waits for request which did not complete in lookahead time
+        countLate();
+    }
+    return 1;
+}
+
+void StepQueue::timerEvent() {
+    for (;;) {
+        if (nHead == nTail) {
+            state = STEP_QUEUE_IDLE;
+            return;
+        }
+
+        // start early by measured request time so outputs change at step time
+        const time_t stepTime = stepTimes[nHead] - pIox->stepLatency;
+
+        if (state == STEP_QUEUE_HOLD) {
+            if (arm(stepTime - STEP_QUEUE_LOOKAHEAD_MICROS)) return;
+
+            pController->holdRequests();
+            state = STEP_QUEUE_STEP;
+        }
+
+        if (arm(stepTime)) return;
+
+        if (!startStep()) {
+            countLate();
+            arm(sched_micros() + STEP_QUEUE_RETRY_MICROS);
+            return;
+        }
+
+        nHead = (nHead + 1) & (STEP_QUEUE_SIZE - 1);
+        headLate = 0;
+        state = STEP_QUEUE_HOLD;
+    }
+}
+
+#endif // INCLUDE_STEPQ_MODULE
@@ -0,0 +1,146 @@
+#ifndef SCHEDULER_STEPQUEUE_H
+#define SCHEDULER_STEPQUEUE_H
+
+#include "Controller.h"
+#include "CIOExpander.h"
+#include "stepqint.h"
+
+/**
+ * Timed step sequence for an IOExpander stepper. A task queues steps with their sched_micros() times ahead of time,
+ * each step's phase write request is started from the Timer1 compare interrupt at its time, see stepqint, so step
+ * timing does not depend on task scheduling or on other requests queued on the bus.
+ *
+ * STEP_QUEUE_LOOKAHEAD_MICROS before each step the controller's pending requests are held with holdRequests(), so a
+ * request in progress completes and the bus is free at the step time. The step request is started with
+ * startPriorityRequest(), which releases the held requests. Lookahead must be at least the longest request on the
+ * bus or steps start late, counted in getLateSteps(). Held requests wait at most the lookahead, less if steps are
+ * closer together.
+ *
+ * Steps are started early by the expander's measured step request time, ciox_step_latency(), so the outputs change at
+ * the queued time. The expander's stepError is the last step to step interval less the queued interval.
+ *
+ * Each completed step calls the expander's step callback, IOExpander::stepDone(), the same as step(). Phase outputs
+ * are combined with the current LED and other outputs when the step is started. Do not mix with step() calls while
+ * steps are queued.
+ *
+ * Usage:
+ *
+ *     StepQueue stepQueue;
+ *
+ *     // in setup(), after sched_clock_begin()
+ *     stepqint_init();
+ *     stepQueue.begin(iox.getHandle());
+ *
+ *     // in a task
+ *     while (stepQueue.getCapacity()) {
+ *         stepQueue.add(nextStepTime, ccw);
+ *         nextStepTime += stepMicros;
+ *     }
+ *
+ * Compiled with INCLUDE_STEPQ_MODULE, which needs INCLUDE_IOX_MODULE and INCLUDE_STP_MODULE. CONSOLE_DEBUG builds use
+ * SimRuntime events for the timer.
+ */
+
+#ifndef STEP_QUEUE_SIZE
+#define STEP_QUEUE_SIZE                 (8)         // queued steps + 1, power of 2
+#endif
+
+#ifndef STEP_QUEUE_LOOKAHEAD_MICROS
+#define STEP_QUEUE_LOOKAHEAD_MICROS     (500L)      // requests held before a step, longest request on the bus
+#endif
+
+#ifndef STEP_QUEUE_RETRY_MICROS
+#define STEP_QUEUE_RETRY_MICROS         (50L)       // retry delay when previous step requests did not complete
+#endif
+
+#define STEP_QUEUE_IDLE                 (0)         // no steps queued
+#define STEP_QUEUE_HOLD                 (1)         // waiting for lookahead time of next step
+#define STEP_QUEUE_STEP                 (2)         // requests held, waiting for step time
+
+class StepQueue {
+    static_assert((STEP_QUEUE_SIZE & (STEP_QUEUE_SIZE - 1)) == 0 && STEP_QUEUE_SIZE <= 128, "StepQueue: STEP_QUEUE_SIZE must be a power of 2, up to 128");
+
+    CIOExpander_t *pIox;
+    Controller *pController;
+    time_t stepTimes[STEP_QUEUE_SIZE];
+    uint8_t stepPhases[STEP_QUEUE_SIZE];        // IOX_OUT_MOT_PHASES outputs of step
+    uint8_t nHead;
+    uint8_t nTail;
+    uint8_t state;
+    uint8_t nextStream;
+    uint8_t headLate;                           // step at nHead was counted in lateSteps
+    time_t lastStepTime;                        // queued time of last started step
+
+    // step requests, two so a step can be started while the previous one completes
+    CByteStream_t streams[2];
+    uint8_t streamData[2][3];                   // register and outputs, one extra byte for the queue
+
+    uint16_t steps;
+    uint16_t lateSteps;
+
+    uint8_t arm(time_t time);
+    void disarm();
+    uint8_t startStep();
+    void countLate();
+
+#ifdef CONSOLE_DEBUG
+    static void simTimerEvent(void *pParam);
+#endif
+
+public:
+    StepQueue();
+
+    /**
+     * Set the expander to step, its controller runs the step requests
+     */
+    void begin(CIOExpander_t *pIox);
+
+    /**
+     * Queue a step, phase is advanced when queued
+     *
+     * @param time      sched_micros() time of step, in the past starts it right away
+     * @param ccwDir    step ccw, else cw
+     * @return          false if queue is full
+     */
+    uint8_t add(time_t time, uint8_t ccwDir);
+
+    /**
+     * Drop queued steps, a step request already started completes
+     */
+    void cancel();
+
+    NO_DISCARD inline uint8_t getCount() const {
+        return (nTail - nHead) & (STEP_QUEUE_SIZE - 1);
+    }
+
+    NO_DISCARD inline uint8_t getCapacity() const {
+        return STEP_QUEUE_SIZE - 1 - getCount();
+    }
+
+    NO_DISCARD inline uint8_t isEmpty() const {
+        return nHead == nTail;
+    }
+
+    NO_DISCARD inline uint16_t getSteps() const {
+        return steps;
+    }
+
+    /**
+     * Steps which could not start at their time because the bus or step requests were busy, each counted once however
+     * often it is retried, wraps around
+     */
+    NO_DISCARD inline uint16_t getLateSteps() const {
+        return lateSteps;
+    }
+
+    /**
+     * Start steps which are due and arm timer for the next time
+     *
+     * IMPORTANT: called from interrupt or with interrupts disabled
+     */
+    void timerEvent();
+};
+
+extern StepQueue stepQueue;
+
+#endif //SCHEDULER_STEPQUEUE_H
@@ -30,6 +30,21 @@ struct AsyncContext {
 #include "Arduino.h"
 #include "common_defs.h"
 
+#ifdef ASYNC_STACK_POOL
+#include "StackPool.h"
+
+// saved stack is kept in a stack pool block only while the task is yielded, stack size is not needed
+typedef struct AsyncContext {
+    volatile uint8_t stackUsed;
+    volatile uint8_t stackMax;
+    volatile uint8_t stackMaxUsed;
+    void (*pEntry)();
+    void *pEntryArg;
+    uint8_t *pStack;                    // stack pool block or NULL
+} AsyncContext;
+
+#define sizeOfStack(s)      (sizeof(AsyncContext))
+#else
 typedef struct AsyncContext {
     volatile uint8_t stackUsed;
     volatile uint8_t stackMax;
@@ -40,6 +55,7 @@ typedef struct AsyncContext {
 } AsyncContext;
 
 #define sizeOfStack(s)      (sizeOfPlus(AsyncContext, (s), uint8_t))
+#endif // ASYNC_STACK_POOL
 #endif // CONSOLE_DEBUG
 
 #ifdef __cplusplus
@@ -50,7 +66,8 @@ extern "C" {
 extern AsyncContext *initContext(void *pContextBuff, EntryFunction entryFunction, void *entryArg, uint16_t stackSize);
 extern uint8_t isInAsyncContext();
 extern void resumeContext(AsyncContext *pContext);
-extern void yieldContext();
+// return 0 after the task yielded and was resumed, 1 if it did not yield because ASYNC_STACK_POOL has no free block
+extern uint8_t yieldContext();
 
 #ifdef __cplusplus
 }
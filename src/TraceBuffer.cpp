@@ -52,13 +52,13 @@ void TraceBuffer::dumpTrace(TraceBuffer *pBuffer) {
 
 #ifndef CONSOLE_DEBUG
             //serialDebugPrintf_P(PSTR("Waiting for TWI TRACER. "));
-            uint32_t start = micros();
+            uint32_t start = sched_micros();
             uint32_t timeoutMic = TWI_WAIT_TIMEOUT_MS * 1000L;
             uint8_t timedOut = 0;
 
             sei();
             while (twiint_busy()) {
-                uint32_t diff = micros() - start;
+                uint32_t diff = sched_micros() - start;
                 if (diff >= timeoutMic) {
                     timedOut = 1;
                     break;
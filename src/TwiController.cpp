@@ -3,28 +3,35 @@
 #include "CTwiController.h"
 #include "twiint.h"
 
+#ifdef CONSOLE_DEBUG
+#include "SimTwi.h"
+#include "SimRuntime.h"
+#endif
+
 void twi_complete_request(CByteStream_t *pStream) {
     twiController.endProcessingRequest((ByteStream *) pStream);
 }
 
-void twi_fresh_stream() {
-    twiStream = (CByteStream_t *) twiController.getWriteStream();
+CByteStream_t *twi_fresh_stream(CController_t *pCtrl) {
+    return (CByteStream_t *) Controller::fromHandle(pCtrl)->getWriteStream();
 }
 
-CByteStream_t *twi_get_write_buffer(uint8_t addr) {
-    ByteStream *pStream = twiController.getWriteStream();
+CByteStream_t *twi_get_write_buffer(CController_t *pCtrl, uint8_t addr) {
+    ByteStream *pStream = Controller::fromHandle(pCtrl)->getWriteStream();
     pStream->set_address(addr);
-    return twiStream = (CByteStream_t *) pStream;
+    return (CByteStream_t *) pStream;
 }
 
-CByteStream_t *twi_process(CByteStream_t *pStream) {
-    return (CByteStream_t *) twiController.processStream((ByteStream *) pStream);
+CByteStream_t *twi_process(CController_t *pCtrl, CByteStream_t *pStream) {
+    return (CByteStream_t *) Controller::fromHandle(pCtrl)->processStream((ByteStream *) pStream);
 }
 
-CByteStream_t *twi_unbuffered_request(uint8_t addr, uint8_t *pData, uint8_t nSize) {
-    ((ByteStream *)twiStream)->setOwnBuffer(pData, nSize);
-    twiStream->addr = addr;
-    return (CByteStream_t *) twiController.processStream((ByteStream *)twiStream);
+CByteStream_t *twi_unbuffered_request(CController_t *pCtrl, uint8_t addr, uint8_t *pData, uint8_t nSize) {
+    Controller *pController = Controller::fromHandle(pCtrl);
+    ByteStream *pStream = pController->getWriteStream();
+    pStream->setOwnBuffer(pData, nSize);
+    pStream->addr = addr;
+    return (CByteStream_t *) pController->processStream(pStream);
 }
 
 #ifdef SERIAL_DEBUG_DETAIL_TWI_STATS
@@ -34,47 +41,52 @@ uint16_t twi_send_bytes = 0;
 
 uint8_t twi_send_errors = 0;
 
-CByteStream_t *twiStream;
-
-void twi_add_byte(uint8_t byte) {
-    stream_put(twiStream, byte);
+void twi_add_byte(CController_t *pCtrl, uint8_t byte) {
+    Controller::fromHandle(pCtrl)->getWriteStream()->put(byte);
 }
 
-void twi_add_pgm_byte_list(const uint8_t *bytes, uint16_t count) {
+void twi_add_pgm_byte_list(CController_t *pCtrl, const uint8_t *bytes, uint16_t count) {
+    ByteStream *pStream = Controller::fromHandle(pCtrl)->getWriteStream();
     while (count--) {
-        stream_put(twiStream, pgm_read_byte(bytes++));
+        pStream->put(pgm_read_byte(bytes++));
     }
 }
 
-uint8_t twi_wait_sent(CByteStream_t *pStream) {
-    return twi_wait((TwiWaitCallback) stream_is_pending, pStream);
-
-}
 // IMPORTANT: assumes: interrupts are enabled, processing of requests should be done by interrupt
 //            routine sequentially sending all pending requests.
-//            i.e. set CTR_FLAGS_REQ_AUTO_START in controller constructor flags
-uint8_t twi_wait(TwiWaitCallback callback, void *pParam) {
-    uint32_t start = micros();
+//            i.e. set CTR_FLAGS_REQ_AUTO_START in controller constructor flags, otherwise requests are started
+//            by calling service() while waiting, e.g. SoftTwiController transfers them there
+static uint8_t twi_wait_controller(Controller *pController, TwiWaitCallback callback, void *pParam) {
+    uint32_t start = sched_micros();
     uint32_t diff = 0;
     uint32_t timeoutMic = TWI_WAIT_TIMEOUT_MS * 1000L;
 
     while (callback(pParam)) {
-        diff = micros() - start;
+        diff = sched_micros() - start;
         if (diff >= timeoutMic) {
 #ifdef SERIAL_DEBUG_TWI_TRACER
             TraceBuffer::dumpTrace();
 #endif
-            serialDebugTwiPrintf_P(PSTR("  TWI: #%d twi_wait timed out %ld.\n"), twiController.getReadStreamId((ByteStream *) pParam), diff / 1000L);
+            serialDebugTwiPrintf_P(PSTR("  TWI: #%d twi_wait timed out %ld.\n"), pController->getReadStreamId((ByteStream *) pParam), diff / 1000L);
 
 #ifdef SERIAL_DEBUG
-            ((ByteStream *)pParam)->serialDebugDump(twiController.getReadStreamId((ByteStream *)pParam));
+            ((ByteStream *)pParam)->serialDebugDump(pController->getReadStreamId((ByteStream *)pParam));
 #endif
             return 0;
         }
+
+        if (!pController->isRequestAutoStart()) {
+            pController->service();
+        }
+
+#ifdef CONSOLE_DEBUG
+        // run the simulation up to its next event, e.g. request completion, the virtual clock only moves when advanced
+        simRuntime.waitMicros(timeoutMic - diff);
+#endif
     }
 
     if (diff) {
-        serialDebugTwiPrintf_P(PSTR("  TWI: #%d twi_wait done %ld.\n"), twiController.getReadStreamId((ByteStream *) pParam), diff / 1000L);
+        serialDebugTwiPrintf_P(PSTR("  TWI: #%d twi_wait done %ld.\n"), pController->getReadStreamId((ByteStream *) pParam), diff / 1000L);
     }
 
 #ifdef SERIAL_DEBUG_TWI_TRACER
@@ -83,32 +95,42 @@ uint8_t twi_wait(TwiWaitCallback callback, void *pParam) {
     return 1;
 }
 
-CByteStream_t *twi_process_stream() {
+uint8_t twi_wait_sent(CController_t *pCtrl, CByteStream_t *pStream) {
+    return twi_wait_controller(Controller::fromHandle(pCtrl), (TwiWaitCallback) stream_is_pending, pStream) && !pStream->error;
+}
+
+uint8_t twi_wait(TwiWaitCallback callback, void *pParam) {
+    return twi_wait_controller(&twiController, callback, pParam);
+}
+
+CByteStream_t *twi_process_stream(CController_t *pCtrl) {
     // send the accumulated buffer
+    Controller *pController = Controller::fromHandle(pCtrl);
+    ByteStream *pWriteStream = pController->getWriteStream();
     CByteStream_t *pStream = NULL;
 
     START_SERIAL_DEBUG_TWI_STATS();
 #ifdef SERIAL_DEBUG_DETAIL_TWI_STATS
-    uint16_t reqSize = stream_count(twiStream);
+    uint16_t reqSize = pWriteStream->count();
 #endif
     // returns the same stream but updated head/tail, so address is unchanged
-    pStream = (CByteStream_t *) twiController.processStream((ByteStream *) twiStream);
+    pStream = (CByteStream_t *) pController->processStream(pWriteStream);
 
     END_SERIAL_DEBUG_TWI_STATS(reqSize);
 
-    serialDebugDetailTwiStatsPrintf_P(PSTR("%8ld: TWI %d command bytes, new bytes %d in %ld usec %d\n"), start / 1000L, twi_send_bytes, stream_count(twiStream), twi_send_time, twi_send_errors);
+    serialDebugDetailTwiStatsPrintf_P(PSTR("%8ld: TWI %d command bytes, new bytes %d in %ld usec %d\n"), start / 1000L, twi_send_bytes, pWriteStream->count(), twi_send_time, twi_send_errors);
 #ifdef SERIAL_DEBUG_DETAIL_TWI_STATS
     twi_send_bytes = 0;
 #endif
     return pStream;
 }
 
-void twi_set_own_buffer(uint8_t *pData, uint8_t nSize) {
-    ((ByteStream *) twiStream)->setOwnBuffer(pData, nSize);
+void twi_set_own_buffer(CController_t *pCtrl, uint8_t *pData, uint8_t nSize) {
+    Controller::fromHandle(pCtrl)->getWriteStream()->setOwnBuffer(pData, nSize);
 }
 
-void twi_set_rd_buffer(uint8_t rdReverse, uint8_t *pRdData, uint8_t nRdSize) {
-    ((ByteStream *) twiStream)->setRdBuffer(rdReverse, pRdData, nRdSize);
+void twi_set_rd_buffer(CController_t *pCtrl, uint8_t rdReverse, void *pRdData, uint8_t nRdSize) {
+    Controller::fromHandle(pCtrl)->getWriteStream()->setRdBuffer(rdReverse, (uint8_t *) pRdData, nRdSize);
 }
 
 
@@ -123,13 +145,22 @@ void TwiController::startProcessingRequest(ByteStream *pStream) {
 #endif
 
 #endif
-    this->resume(0);
+    resumeService(0);
 
     SEI();
 
 #ifndef CONSOLE_DEBUG
     twiint_start((CByteStream_t *) pStream);
 #else
-    pStream->flags |= STREAM_FLAGS_PROCESSING;
+    simTwiBus.start((CByteStream_t *) pStream);
+#endif
+}
+
+void TwiController::service() {
+#ifndef CONSOLE_DEBUG
+    twiint_watchdog();
+#else
+    simTwiBus.watchdog();
 #endif
+    Controller::service();
 }
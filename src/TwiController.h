@@ -12,10 +12,20 @@ public:
             : Controller(pData, maxStreams, maxTasks, writeBufferSize, flags) {
     }
 
+    template<uint16_t nStreams, uint16_t nTasks, uint16_t nBufferSize>
+    explicit TwiController(ControllerStorage<nStreams, nTasks, nBufferSize> &storage, uint8_t flags = CTR_FLAGS_REQ_AUTO_START)
+            : Controller(storage, flags) {
+    }
+
     defineSchedulerTaskId("TwiController");
 
     // IMPORTANT: must be called with interrupts disabled
     void startProcessingRequest(ByteStream *pStream) override;
+
+    /**
+     * Time out a request hanging the bus, then service requests
+     */
+    void service() override;
 };
 
 extern TwiController twiController;
@@ -0,0 +1,29 @@
+#ifdef INCLUDE_UART_MODULE
+
+#include "UartController.h"
+
+#ifdef CONSOLE_DEBUG
+#include "SimUart.h"
+#endif
+
+void uart_complete_request(CByteStream_t *pStream) {
+    uartController.endProcessingRequest((ByteStream *) pStream);
+
+    // recycle completed streams on next pass instead of the 20ms controller delay, producers waiting in
+    // reserveResources() would be held back by it at any baud rate
+    uartController.resumeService(0);
+}
+
+void UartController::startProcessingRequest(ByteStream *pStream) {
+    CLI();
+    resumeService(0);
+    SEI();
+
+#ifndef CONSOLE_DEBUG
+    uartint_start((CByteStream_t *) pStream);
+#else
+    simUart.start((CByteStream_t *) pStream);
+#endif
+}
+
+#endif // INCLUDE_UART_MODULE
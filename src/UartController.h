@@ -0,0 +1,49 @@
+#ifndef SCHEDULER_UARTCONTROLLER_H
+#define SCHEDULER_UARTCONTROLLER_H
+
+#include "Controller.h"
+#include "uartint.h"
+
+/**
+ * Non-blocking serial output through the Controller request pipeline. Streams are sent from the USART UDRE
+ * interrupt by uartint, producers use reserveResources() for admission control and are suspended when the write
+ * buffer or request streams are exhausted, the same as for TwiController. Stream address is not used.
+ *
+ * Usage:
+ *
+ *     ControllerStorage<UART_MAX_STREAMS, UART_MAX_TASKS, UART_MAX_BUFFER> uartStorage;
+ *     UartController uartController(uartStorage);
+ *
+ *     // in setup()
+ *     uartint_init();
+ *
+ *     // in a task
+ *     if (uartController.reserveResources(1, 16)) return;
+ *     ByteStream *pStream = uartController.getWriteStream();
+ *     pStream->put(...);
+ *     uartController.processStream(pStream);
+ *     uartController.releaseResources();
+ *
+ * CONSOLE_DEBUG builds send requests to simUart.
+ */
+class UartController : public Controller {
+
+public:
+    UartController(uint8_t *pData, uint8_t maxStreams, uint8_t maxTasks, uint8_t writeBufferSize, uint8_t flags = CTR_FLAGS_REQ_AUTO_START)
+            : Controller(pData, maxStreams, maxTasks, writeBufferSize, flags) {
+    }
+
+    template<uint16_t nStreams, uint16_t nTasks, uint16_t nBufferSize>
+    explicit UartController(ControllerStorage<nStreams, nTasks, nBufferSize> &storage, uint8_t flags = CTR_FLAGS_REQ_AUTO_START)
+            : Controller(storage, flags) {
+    }
+
+    defineSchedulerTaskId("UartController");
+
+    // IMPORTANT: must be called with interrupts disabled
+    void startProcessingRequest(ByteStream *pStream) override;
+};
+
+extern UartController uartController;
+
+#endif //SCHEDULER_UARTCONTROLLER_H
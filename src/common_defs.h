@@ -36,6 +36,7 @@ extern uint16_t nSeiLine;
 #endif
 #else
 #define CLI()   ((void)0)
+#define CLI_ONLY()   ((void)0)
 #define SEI()   ((void)0)
 #endif
 
@@ -47,6 +48,15 @@ extern uint16_t nSeiLine;
 
 #define TO_MICROS(ms)   ((ms) * 1000UL)
 
+#if defined(SERIAL_DEBUG_BINLOG) && !defined(CONSOLE_DEBUG)
+// debug output is logged in binary and formatted on the host, see BinLog.h
+#include "BinLog.h"
+#undef printf_P
+#undef puts_P
+#define printf_P(...) binlog_printf_P(__VA_ARGS__)
+#define puts_P(...) binlog_puts_P(__VA_ARGS__)
+#endif
+
 #ifdef SERIAL_DEBUG
 #define serialDebugPrintf_P(...) printf_P(__VA_ARGS__)
 #define serialDebugPuts_P(...) puts_P(__VA_ARGS__)
@@ -0,0 +1,47 @@
+#ifdef INCLUDE_DACW_MODULE
+#ifndef CONSOLE_DEBUG
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+#include "dacwint.h"
+
+// longest compare delay, half the timer period so a compare set from a late interrupt is not taken as past
+#define DACWINT_MAX_TICKS       (0x7fff)
+
+void dacwint_init(void) {
+    CLI();
+    TIMSK1 &= ~(1 << OCIE1A);
+    SEI();
+}
+
+uint8_t dacwint_arm(time_t time) {
+    // signed difference, time_t is unsigned and a time in the past is due now
+    const int32_t remaining = (int32_t) (time - sched_micros());
+
+    if (remaining < DACWINT_MIN_MICROS) {
+        TIMSK1 &= ~(1 << OCIE1A);
+        return 0;
+    }
+
+    const uint16_t ticks = remaining < (DACWINT_MAX_TICKS >> SCHED_CLOCK_TICK_SHIFT) ? remaining << SCHED_CLOCK_TICK_SHIFT : DACWINT_MAX_TICKS;
+
+    OCR1A = TCNT1 + ticks;
+    TIFR1 = (1 << OCF1A);
+    TIMSK1 |= (1 << OCIE1A);
+    return 1;
+}
+
+void dacwint_disarm(void) {
+    CLI();
+    TIMSK1 &= ~(1 << OCIE1A);
+    SEI();
+}
+
+ISR(TIMER1_COMPA_vect) {
+    TIMSK1 &= ~(1 << OCIE1A);
+    dacw_timer_event();
+}
+
+#endif // CONSOLE_DEBUG
+#endif // INCLUDE_DACW_MODULE
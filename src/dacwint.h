@@ -0,0 +1,63 @@
+#ifndef DACWINT_H_
+#define DACWINT_H_
+
+/*
+ * Timer1 compare A interrupt timing DacWavePlayer samples.
+ *
+ * Needs SCHED_CLOCK_TIMER1, the compare register runs on the free running clock timer so sample times are in
+ * sched_micros() time with 0.5us resolution at 16MHz. Times more than 16ms ahead are reached by re-arming from the
+ * interrupt, dacw_timer_event() is called on every compare and checks the time itself. Compare B is used by stepqint,
+ * both can be used together.
+ *
+ * Compiled with INCLUDE_DACW_MODULE. CONSOLE_DEBUG builds use SimRuntime events instead.
+ */
+
+#include "Arduino.h"
+#include <stdint.h>
+#include "SchedClock.h"
+
+#if !defined(CONSOLE_DEBUG) && !defined(SCHED_CLOCK_TIMER1)
+#error "dacwint: needs SCHED_CLOCK_TIMER1 clock source"
+#endif
+
+// time closer than this is reached, compare could be missed if set that close to the timer
+#ifndef DACWINT_MIN_MICROS
+#define DACWINT_MIN_MICROS      (4)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Disable compare interrupt, call after sched_clock_begin()
+ */
+void dacwint_init(void);
+
+/**
+ * Arm compare interrupt for given time
+ *
+ * IMPORTANT: must be called with interrupts disabled
+ *
+ * @param time  sched_micros() time
+ * @return      false if time is less than DACWINT_MIN_MICROS away and interrupt is not armed
+ */
+uint8_t dacwint_arm(time_t time);
+
+/**
+ * Disable compare interrupt
+ */
+void dacwint_disarm(void);
+
+/**
+ * Implemented by DacWavePlayer as a C callable function
+ *
+ * IMPORTANT: called from interrupt
+ */
+void dacw_timer_event(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DACWINT_H_ */
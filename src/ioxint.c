@@ -0,0 +1,36 @@
+#ifdef INCLUDE_IOX_INT
+#ifndef CONSOLE_DEBUG
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+#include "ioxint.h"
+
+void ioxint_init(void) {
+    CLI();
+    IOX_INT_DDR &= ~(1 << IOX_INT_BIT);
+    IOX_INT_PORT |= (1 << IOX_INT_BIT);
+    IOX_INT_PCMSK |= (1 << IOX_INT_BIT);
+    PCIFR = (1 << IOX_INT_GROUP);
+    PCICR |= (1 << IOX_INT_GROUP);
+    SEI();
+}
+
+void ioxint_disable(void) {
+    CLI();
+    IOX_INT_PCMSK &= ~(1 << IOX_INT_BIT);
+    if (!IOX_INT_PCMSK) {
+        PCICR &= ~(1 << IOX_INT_GROUP);
+    }
+    SEI();
+}
+
+ISR(IOX_INT_vect) {
+    // other pins of the group also land here, release of INT after the read is not a change
+    if (ioxint_is_active()) {
+        iox_int_event();
+    }
+}
+
+#endif // CONSOLE_DEBUG
+#endif // INCLUDE_IOX_INT
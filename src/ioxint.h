@@ -0,0 +1,83 @@
+#ifndef IOXINT_H_
+#define IOXINT_H_
+
+/*
+ * Pin change interrupt on the XL9535 INT output.
+ *
+ * INT is open drain, active low, it goes low when an input changes and is released when the input port is read, so
+ * only the falling edge is reported. iox_int_event() only flags the change, the input read is a TWI request which is
+ * made by IoxInputMonitor task, not from the interrupt.
+ *
+ * IOX_INT_PCINT selects the PCINT number of the pin, default is 18, PD2 or Arduino D2. Pins of PCINT0..7 are on
+ * PORTB, 8..14 on PORTC and 16..23 on PORTD, the interrupt uses the matching PCINTn_vect, which should not be used
+ * by anything else.
+ *
+ * Compiled with INCLUDE_IOX_INT. CONSOLE_DEBUG builds have no pin, tests call IoxInputMonitor::intEvent().
+ */
+
+#include "Arduino.h"
+#include <stdint.h>
+#include "common_defs.h"
+
+#ifndef IOX_INT_PCINT
+#define IOX_INT_PCINT           (18)
+#endif
+
+#define IOX_INT_GROUP           ((IOX_INT_PCINT) >> 3)
+#define IOX_INT_BIT             ((IOX_INT_PCINT) & 7)
+
+#ifndef CONSOLE_DEBUG
+#if IOX_INT_GROUP == 0
+#define IOX_INT_PIN             PINB
+#define IOX_INT_PORT            PORTB
+#define IOX_INT_DDR             DDRB
+#define IOX_INT_PCMSK           PCMSK0
+#define IOX_INT_vect            PCINT0_vect
+#elif IOX_INT_GROUP == 1
+#define IOX_INT_PIN             PINC
+#define IOX_INT_PORT            PORTC
+#define IOX_INT_DDR             DDRC
+#define IOX_INT_PCMSK           PCMSK1
+#define IOX_INT_vect            PCINT1_vect
+#elif IOX_INT_GROUP == 2
+#define IOX_INT_PIN             PIND
+#define IOX_INT_PORT            PORTD
+#define IOX_INT_DDR             DDRD
+#define IOX_INT_PCMSK           PCMSK2
+#define IOX_INT_vect            PCINT2_vect
+#else
+#error "ioxint: IOX_INT_PCINT must be 0..23"
+#endif
+
+// true if INT is asserted, a change was not yet read
+#define ioxint_is_active()      (!(IOX_INT_PIN & (1 << IOX_INT_BIT)))
+#else
+#define ioxint_is_active()      (0)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Set pin to input with pull-up and enable its pin change interrupt
+ */
+void ioxint_init(void);
+
+/**
+ * Disable pin change interrupt of the pin
+ */
+void ioxint_disable(void);
+
+/**
+ * Implemented by IoxInputMonitor as a C callable function
+ *
+ * IMPORTANT: called from interrupt
+ */
+void iox_int_event(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IOXINT_H_ */
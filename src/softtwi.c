@@ -0,0 +1,147 @@
+#ifndef CONSOLE_DEBUG
+
+#include "softtwi.h"
+#include "CByteBuffer.h"
+#include "common_defs.h"
+
+#define SDA_LOW(t)          (*(t)->pSdaDdr |= (t)->sdaMask)
+#define SDA_RELEASE(t)      (*(t)->pSdaDdr &= ~(t)->sdaMask)
+#define SDA_READ(t)         (*(t)->pSdaIn & (t)->sdaMask)
+#define SCL_LOW(t)          (*(t)->pSclDdr |= (t)->sclMask)
+#define SCL_RELEASE(t)      (*(t)->pSclDdr &= ~(t)->sclMask)
+#define SCL_READ(t)         (*(t)->pSclIn & (t)->sclMask)
+
+#define HALF_BIT()          delayMicroseconds(SOFT_TWI_HALF_BIT_MICROS)
+
+void softtwi_init(CSoftTwi_t *thizz, uint8_t sdaPin, uint8_t sclPin) {
+    const uint8_t sdaPort = digitalPinToPort(sdaPin);
+    const uint8_t sclPort = digitalPinToPort(sclPin);
+
+    thizz->sdaMask = digitalPinToBitMask(sdaPin);
+    thizz->sclMask = digitalPinToBitMask(sclPin);
+    thizz->pSdaDdr = portModeRegister(sdaPort);
+    thizz->pSclDdr = portModeRegister(sclPort);
+    thizz->pSdaIn = portInputRegister(sdaPort);
+    thizz->pSclIn = portInputRegister(sclPort);
+    thizz->errors = 0;
+
+    CLI();
+    SDA_RELEASE(thizz);
+    SCL_RELEASE(thizz);
+    // port bits stay 0, driving low is done by switching to output
+    *portOutputRegister(sdaPort) &= ~thizz->sdaMask;
+    *portOutputRegister(sclPort) &= ~thizz->sclMask;
+    SEI();
+}
+
+// release SCL and wait for slave clock stretching to end
+static uint8_t softtwi_scl_high(CSoftTwi_t *thizz) {
+    SCL_RELEASE(thizz);
+
+    uint16_t wait = SOFT_TWI_STRETCH_MICROS;
+    while (!SCL_READ(thizz)) {
+        if (!wait--) return SOFT_TWI_TIMEOUT;
+        delayMicroseconds(1);
+    }
+    return SOFT_TWI_OK;
+}
+
+// START or repeated START, SCL is high on entry for START and low for repeated START
+static uint8_t softtwi_start(CSoftTwi_t *thizz) {
+    SDA_RELEASE(thizz);
+    HALF_BIT();
+    if (softtwi_scl_high(thizz)) return SOFT_TWI_TIMEOUT;
+    HALF_BIT();
+    SDA_LOW(thizz);
+    HALF_BIT();
+    SCL_LOW(thizz);
+    return SOFT_TWI_OK;
+}
+
+static void softtwi_stop(CSoftTwi_t *thizz) {
+    SDA_LOW(thizz);
+    HALF_BIT();
+    softtwi_scl_high(thizz);
+    HALF_BIT();
+    SDA_RELEASE(thizz);
+    HALF_BIT();
+}
+
+static uint8_t softtwi_write(CSoftTwi_t *thizz, uint8_t data) {
+    for (uint8_t mask = 0x80; mask; mask >>= 1) {
+        if (data & mask) {
+            SDA_RELEASE(thizz);
+        } else {
+            SDA_LOW(thizz);
+        }
+        HALF_BIT();
+        if (softtwi_scl_high(thizz)) return SOFT_TWI_TIMEOUT;
+        HALF_BIT();
+        SCL_LOW(thizz);
+    }
+
+    // ACK bit
+    SDA_RELEASE(thizz);
+    HALF_BIT();
+    if (softtwi_scl_high(thizz)) return SOFT_TWI_TIMEOUT;
+    HALF_BIT();
+    const uint8_t nack = SDA_READ(thizz);
+    SCL_LOW(thizz);
+    return nack ? SOFT_TWI_NACK : SOFT_TWI_OK;
+}
+
+static uint8_t softtwi_read(CSoftTwi_t *thizz, uint8_t *pData, uint8_t ack) {
+    uint8_t data = 0;
+
+    SDA_RELEASE(thizz);
+    for (uint8_t i = 0; i < 8; i++) {
+        HALF_BIT();
+        if (softtwi_scl_high(thizz)) return SOFT_TWI_TIMEOUT;
+        HALF_BIT();
+        data <<= 1;
+        if (SDA_READ(thizz)) data |= 1;
+        SCL_LOW(thizz);
+    }
+
+    // master ACK all but last byte
+    if (ack) SDA_LOW(thizz);
+    HALF_BIT();
+    if (softtwi_scl_high(thizz)) return SOFT_TWI_TIMEOUT;
+    HALF_BIT();
+    SCL_LOW(thizz);
+    SDA_RELEASE(thizz);
+
+    *pData = data;
+    return SOFT_TWI_OK;
+}
+
+uint8_t softtwi_transfer(CSoftTwi_t *thizz, CByteStream_t *pStream) {
+    uint8_t result = softtwi_start(thizz);
+
+    if (!result) result = softtwi_write(thizz, pStream->addr);
+
+    while (!result && !stream_is_empty(pStream)) {
+        result = softtwi_write(thizz, stream_get(pStream));
+    }
+
+    if (!result && pStream->nRdSize && pStream->pRdData) {
+        CByteBuffer_t rdBuffer;
+        buffer_init(&rdBuffer, pStream->flags & STREAM_FLAGS_BUFF_REVERSE, pStream->pRdData, pStream->nRdSize);
+
+        result = softtwi_start(thizz);
+        if (!result) result = softtwi_write(thizz, pStream->addr | 0x01);
+
+        for (uint8_t i = pStream->nRdSize; !result && i; i--) {
+            uint8_t data;
+            result = softtwi_read(thizz, &data, i > 1);
+            if (!result) buffer_put(&rdBuffer, data);
+        }
+    }
+
+    softtwi_stop(thizz);
+
+    if (result) thizz->errors++;
+    return result;
+}
+
+#endif // CONSOLE_DEBUG
@@ -0,0 +1,67 @@
+#ifndef SOFTTWI_H_
+#define SOFTTWI_H_
+
+/*
+ * Bit-banged TWI master on any two pins, used by SoftTwiController for a second TWI bus.
+ *
+ * Pins are driven open drain, low by making the pin an output with port bit 0 and released by making it an input,
+ * external pull-ups are required. Slave clock stretching is supported with a SOFT_TWI_STRETCH_MICROS limit.
+ *
+ * Transfers are blocking, a request is sent from the calling task with interrupts enabled, interrupts only stretch
+ * the bus clock. At the default SOFT_TWI_HALF_BIT_MICROS the bus runs at about 80kHz, an XL9535 output write of
+ * 3 bytes takes about 450us.
+ *
+ * CONSOLE_DEBUG builds use a SimTwiBus instead.
+ */
+
+#include "Arduino.h"
+#include <stdint.h>
+#include "CByteStream.h"
+
+#ifndef SOFT_TWI_HALF_BIT_MICROS
+#define SOFT_TWI_HALF_BIT_MICROS    (5)         // SCL low and high time
+#endif
+
+#ifndef SOFT_TWI_STRETCH_MICROS
+#define SOFT_TWI_STRETCH_MICROS     (1000)      // max time slave may hold SCL low
+#endif
+
+#define SOFT_TWI_OK             (0)
+#define SOFT_TWI_NACK           (1)             // address or data byte not acknowledged
+#define SOFT_TWI_TIMEOUT        (2)             // SCL held low longer than SOFT_TWI_STRETCH_MICROS
+
+typedef struct CSoftTwi {
+    volatile uint8_t *pSdaDdr;
+    volatile uint8_t *pSdaIn;
+    volatile uint8_t *pSclDdr;
+    volatile uint8_t *pSclIn;
+    uint8_t sdaMask;
+    uint8_t sclMask;
+    uint16_t errors;                            // failed requests, wraps around
+} CSoftTwi_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Set up pins and release the bus
+ *
+ * @param sdaPin    Arduino pin number of SDA
+ * @param sclPin    Arduino pin number of SCL
+ */
+extern void softtwi_init(CSoftTwi_t *thizz, uint8_t sdaPin, uint8_t sclPin);
+
+/**
+ * Send the stream's bytes to its address, then read nRdSize bytes into the read buffer after a repeated start,
+ * the same request format twiint uses.
+ *
+ * @return SOFT_TWI_OK or error
+ */
+extern uint8_t softtwi_transfer(CSoftTwi_t *thizz, CByteStream_t *pStream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOFTTWI_H_ */
@@ -0,0 +1,108 @@
+#ifdef INCLUDE_SPI_MODULE
+#ifndef CONSOLE_DEBUG
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+#include "spiint.h"
+#include "CByteBuffer.h"
+
+#define SPI_FLAGS_READING   (0x01)      // byte in transfer is a read byte
+
+static CByteStream_t *volatile pSpiStream;
+static CByteBuffer_t spiRdBuffer;
+static uint8_t spiRdCount;
+static uint8_t spiFlags;
+static volatile uint8_t *pSpiCsPort;
+static uint8_t spiCsMask;
+
+uint16_t spiint_bytes;
+
+void spiint_init(void) {
+    pSpiStream = NULL;
+
+    // SS must be an output or a low level on it will switch SPI to slave mode
+    DDRB |= (1 << PB2) | (1 << PB3) | (1 << PB5);
+    PORTB |= (1 << PB2);
+
+    SPCR = (1 << SPE) | (1 << MSTR) | (SPI_SPR_VALUE << SPR0);
+    SPSR = SPI_SPI2X_VALUE << SPI2X;
+}
+
+bool spiint_busy(void) {
+    return pSpiStream != NULL;
+}
+
+static void spiint_end(void) {
+    CByteStream_t *pStream = pSpiStream;
+
+    *pSpiCsPort |= spiCsMask;
+    SPCR &= ~(1 << SPIE);
+    pSpiStream = NULL;
+    spi_complete_request(pStream);
+}
+
+// send next byte, return false if the request has no more bytes to transfer
+static inline bool spiint_next(CByteStream_t *pStream) {
+    if (!stream_is_empty(pStream)) {
+        spiFlags = 0;
+        SPDR = stream_get(pStream);
+        return true;
+    }
+
+    if (spiRdCount) {
+        spiFlags = SPI_FLAGS_READING;
+        SPDR = 0xFF;
+        return true;
+    }
+    return false;
+}
+
+void spiint_start(CByteStream_t *pStream) {
+    while (pSpiStream);
+
+    const uint8_t addr = pStream->addr;
+    const uint8_t csPin = SPI_ADDRESS_CS_PIN(addr);
+
+    pStream->flags |= STREAM_FLAGS_PROCESSING;
+    pSpiStream = pStream;
+
+    spiRdCount = 0;
+    if (pStream->nRdSize && pStream->pRdData) {
+        buffer_init(&spiRdBuffer, pStream->flags & STREAM_FLAGS_BUFF_REVERSE, pStream->pRdData, pStream->nRdSize);
+        spiRdCount = pStream->nRdSize;
+    }
+
+    pSpiCsPort = portOutputRegister(digitalPinToPort(csPin));
+    spiCsMask = digitalPinToBitMask(csPin);
+
+    // mode bits map to CPOL:CPHA
+    SPCR = (1 << SPIE) | (1 << SPE) | (1 << MSTR) | (SPI_SPR_VALUE << SPR0)
+           | (addr & SPI_ADDRESS_LSB_FIRST ? (1 << DORD) : 0)
+           | (SPI_ADDRESS_MODE(addr) << CPHA);
+
+    *pSpiCsPort &= ~spiCsMask;
+
+    if (!spiint_next(pStream)) {
+        spiint_end();
+    }
+}
+
+ISR(SPI_STC_vect) {
+    CByteStream_t *pStream = pSpiStream;
+    const uint8_t data = SPDR;
+
+    spiint_bytes++;
+
+    if (spiFlags & SPI_FLAGS_READING) {
+        buffer_put(&spiRdBuffer, data);
+        spiRdCount--;
+    }
+
+    if (!spiint_next(pStream)) {
+        spiint_end();
+    }
+}
+
+#endif // CONSOLE_DEBUG
+#endif // INCLUDE_SPI_MODULE
@@ -0,0 +1,98 @@
+#ifndef SPIINT_H_
+#define SPIINT_H_
+
+/*
+ * Interrupt driven SPI master transfer of CByteStream requests, used by SpiController.
+ *
+ * The stream address carries the request's chip select pin and SPI mode, see SPI_ADDRESS(). Chip select is driven
+ * low, the stream bytes are sent from the SPI_STC_vect interrupt, then nRdSize bytes are clocked in with 0xFF sent
+ * and stored in pRdData, in reverse if STREAM_FLAGS_BUFF_REVERSE, the same as twiint read after write. Chip select
+ * is driven high and spi_complete_request() called at the end of the request.
+ *
+ * Compiled with INCLUDE_SPI_MODULE. Clock is F_CPU / SPI_CLOCK_DIVIDER for all requests. At the higher clock rates
+ * the transfer is limited by the interrupt processing time per byte, not the SPI clock.
+ *
+ * CONSOLE_DEBUG builds use SimSpiBus instead.
+ */
+
+#include "Arduino.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include "CByteStream.h"
+
+#ifndef SPI_CLOCK_DIVIDER
+#define SPI_CLOCK_DIVIDER   (4)
+#endif
+
+#define SPI_MODE0           (0)         // CPOL 0, CPHA 0
+#define SPI_MODE1           (1)         // CPOL 0, CPHA 1
+#define SPI_MODE2           (2)         // CPOL 1, CPHA 0
+#define SPI_MODE3           (3)         // CPOL 1, CPHA 1
+
+#define SPI_ADDRESS_LSB_FIRST   (0x80)  // send least significant bit first
+
+/** Stream address for chip select Arduino pin 0..31 and SPI mode, or with SPI_ADDRESS_LSB_FIRST if needed */
+#define SPI_ADDRESS(csPin, mode)    (((csPin) & 0x1F) | (((mode) & 0x03) << 5))
+#define SPI_ADDRESS_CS_PIN(a)       ((a) & 0x1F)
+#define SPI_ADDRESS_MODE(a)         (((a) >> 5) & 0x03)
+
+#if SPI_CLOCK_DIVIDER == 2
+#define SPI_SPR_VALUE       (0)
+#define SPI_SPI2X_VALUE     (1)
+#elif SPI_CLOCK_DIVIDER == 4
+#define SPI_SPR_VALUE       (0)
+#define SPI_SPI2X_VALUE     (0)
+#elif SPI_CLOCK_DIVIDER == 8
+#define SPI_SPR_VALUE       (1)
+#define SPI_SPI2X_VALUE     (1)
+#elif SPI_CLOCK_DIVIDER == 16
+#define SPI_SPR_VALUE       (1)
+#define SPI_SPI2X_VALUE     (0)
+#elif SPI_CLOCK_DIVIDER == 32
+#define SPI_SPR_VALUE       (2)
+#define SPI_SPI2X_VALUE     (1)
+#elif SPI_CLOCK_DIVIDER == 64
+#define SPI_SPR_VALUE       (2)
+#define SPI_SPI2X_VALUE     (0)
+#elif SPI_CLOCK_DIVIDER == 128
+#define SPI_SPR_VALUE       (3)
+#define SPI_SPI2X_VALUE     (0)
+#else
+#error "SPI_CLOCK_DIVIDER must be one of 2, 4, 8, 16, 32, 64, 128"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern uint16_t spiint_bytes;              // bytes transferred, wraps around
+
+/**
+ * Initialize SPI master at F_CPU / SPI_CLOCK_DIVIDER, SS pin is made an output as needed for master mode.
+ * Chip select pins of devices must be set as outputs and high by the caller.
+ */
+void spiint_init(void);
+
+/**
+ * Returns true if a request is being transferred
+ */
+bool spiint_busy(void);
+
+/**
+ * Start transferring the stream, bytes are transferred from the interrupt. If a request is still being transferred,
+ * this function blocks until it is completed.
+ */
+void spiint_start(CByteStream_t *pStream);
+
+/**
+ * Implemented by SpiController as a C callable function
+ *
+ * @param pStream pointer to stream whose processing was completed
+ */
+void spi_complete_request(CByteStream_t *pStream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPIINT_H_ */
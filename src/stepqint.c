@@ -0,0 +1,47 @@
+#ifdef INCLUDE_STEPQ_MODULE
+#ifndef CONSOLE_DEBUG
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+#include "stepqint.h"
+
+// longest compare delay, half the timer period so a compare set from a late interrupt is not taken as past
+#define STEPQINT_MAX_TICKS      (0x7fff)
+
+void stepqint_init(void) {
+    CLI();
+    TIMSK1 &= ~(1 << OCIE1B);
+    SEI();
+}
+
+uint8_t stepqint_arm(time_t time) {
+    // signed difference, time_t is unsigned and a time in the past is due now
+    const int32_t remaining = (int32_t) (time - sched_micros());
+
+    if (remaining < STEPQINT_MIN_MICROS) {
+        TIMSK1 &= ~(1 << OCIE1B);
+        return 0;
+    }
+
+    const uint16_t ticks = remaining < (STEPQINT_MAX_TICKS >> SCHED_CLOCK_TICK_SHIFT) ? remaining << SCHED_CLOCK_TICK_SHIFT : STEPQINT_MAX_TICKS;
+
+    OCR1B = TCNT1 + ticks;
+    TIFR1 = (1 << OCF1B);
+    TIMSK1 |= (1 << OCIE1B);
+    return 1;
+}
+
+void stepqint_disarm(void) {
+    CLI();
+    TIMSK1 &= ~(1 << OCIE1B);
+    SEI();
+}
+
+ISR(TIMER1_COMPB_vect) {
+    TIMSK1 &= ~(1 << OCIE1B);
+    stepq_timer_event();
+}
+
+#endif // CONSOLE_DEBUG
+#endif // INCLUDE_STEPQ_MODULE
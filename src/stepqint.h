@@ -0,0 +1,62 @@
+#ifndef STEPQINT_H_
+#define STEPQINT_H_
+
+/*
+ * Timer1 compare B interrupt timing StepQueue steps.
+ *
+ * Needs SCHED_CLOCK_TIMER1, the compare register runs on the free running clock timer so step times are in
+ * sched_micros() time with 0.5us resolution at 16MHz. Times more than 16ms ahead are reached by re-arming from the
+ * interrupt, stepq_timer_event() is called on every compare and checks the time itself.
+ *
+ * Compiled with INCLUDE_STEPQ_MODULE. CONSOLE_DEBUG builds use SimRuntime events instead.
+ */
+
+#include "Arduino.h"
+#include <stdint.h>
+#include "SchedClock.h"
+
+#if !defined(CONSOLE_DEBUG) && !defined(SCHED_CLOCK_TIMER1)
+#error "stepqint: needs SCHED_CLOCK_TIMER1 clock source"
+#endif
+
+// time closer than this is reached, compare could be missed if set that close to the timer
+#ifndef STEPQINT_MIN_MICROS
+#define STEPQINT_MIN_MICROS     (4)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Disable compare interrupt, call after sched_clock_begin()
+ */
+void stepqint_init(void);
+
+/**
+ * Arm compare interrupt for given time
+ *
+ * IMPORTANT: must be called with interrupts disabled
+ *
+ * @param time  sched_micros() time
+ * @return      false if time is less than STEPQINT_MIN_MICROS away and interrupt is not armed
+ */
+uint8_t stepqint_arm(time_t time);
+
+/**
+ * Disable compare interrupt
+ */
+void stepqint_disarm(void);
+
+/**
+ * Implemented by StepQueue as a C callable function
+ *
+ * IMPORTANT: called from interrupt
+ */
+void stepq_timer_event(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STEPQINT_H_ */
@@ -44,15 +44,21 @@
 #include <avr/io.h>         //hardware registers
 #include <avr/interrupt.h>  //interrupt vectors
 #include <util/twi.h>       //TWI status masks
+#include <util/delay.h>
 
 #endif
 
 #include "twiint.h"
+#include "SchedClock.h"
 #include "CByteBuffer.h"
 
 CByteStream_t *pTwiStream;
 CByteBuffer_t rdBuffer;
 uint16_t twiint_errors;
+uint16_t twiint_retry_count;
+uint8_t twiint_recoveries;
+uint8_t twiint_retries = TWI_RETRIES;
+uint8_t twiint_retry_on = TWI_RETRY_ON;
 uint8_t twiint_flags;
 time_t twiint_request_start_time;
 time_t                                                                                      twiint_int_start_time;
@@ -70,6 +76,13 @@ bool twiint_busy(void) {
 void twiint_flush(void) {
 }
 
+void twiint_bus_recover(void) {
+}
+
+bool twiint_watchdog(void) {
+    return 0;
+}
+
 void twiint_start(CByteStream_t *pStream) {
     twiint_flush();
 }
@@ -84,6 +97,16 @@ void twint_cancel_rd(CByteStream_t *pStream) {
 
 #else
 
+// SDA and SCL pins of ATmega328P
+#define TWI_PORT            PORTC
+#define TWI_DDR             DDRC
+#define TWI_PIN             PINC
+#define TWI_SDA             PC4
+#define TWI_SCL             PC5
+
+static uint8_t twiStartHead;            // stream head at start of request, for rewinding on retry
+static uint8_t twiAttempts;             // retries of current request
+
 void twiint_init(void) {
     twiint_flags = 0;
 
@@ -101,19 +124,26 @@ void twiint_flush(void) {
     while (TWCR & (1 << TWIE));
 }
 
-void twiint_start(CByteStream_t *pStream) {
-    twiint_flush();
-
-    pStream->flags |= STREAM_FLAGS_PROCESSING;
-    pTwiStream = pStream;
+static void twiint_prep_read(CByteStream_t *pStream) {
     twiint_flags &= ~TWI_FLAGS_HAVE_READ;
 
     if (pStream->nRdSize && pStream->pRdData) {
         buffer_init(&rdBuffer, pStream->flags & STREAM_FLAGS_BUFF_REVERSE, pStream->pRdData, pStream->nRdSize);
         twiint_flags |= TWI_FLAGS_HAVE_READ;
     }
+}
 
-    twiint_request_start_time = micros();
+void twiint_start(CByteStream_t *pStream) {
+    twiint_flush();
+
+    pStream->flags |= STREAM_FLAGS_PROCESSING;
+    pStream->error = TWI_ERR_NONE;
+    pTwiStream = pStream;
+    twiStartHead = pStream->byteQueue.nHead;
+    twiAttempts = 0;
+    twiint_prep_read(pStream);
+
+    twiint_request_start_time = sched_micros();
     twiint_int_start_time = 0;
     twiint_flags |= TWI_FLAGS_INT_TIMESTAMP;
     TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWIE) | (1 << TWSTA);
@@ -123,6 +153,59 @@ void twint_cancel_rd(CByteStream_t *pStream) {
     twiint_flags &= ~TWI_FLAGS_HAVE_READ;
 }
 
+// half period of recovery clock, 100kHz
+#define TWI_RECOVER_HALF_BIT_US     (5)
+
+void twiint_bus_recover(void) {
+    // release pins from TWI, pins are driven open drain with internal pull-ups as in twiint_init()
+    TWCR = 0;
+    TWI_DDR &= ~((1 << TWI_SDA) | (1 << TWI_SCL));
+    TWI_PORT |= (1 << TWI_SDA) | (1 << TWI_SCL);
+    _delay_us(TWI_RECOVER_HALF_BIT_US);
+
+    if (!(TWI_PIN & (1 << TWI_SDA))) {
+        // slave is in the middle of sending a byte, clock it out until it releases SDA
+        for (uint8_t i = 0; i < 9 && !(TWI_PIN & (1 << TWI_SDA)); i++) {
+            TWI_PORT &= ~(1 << TWI_SCL);
+            TWI_DDR |= (1 << TWI_SCL);
+            _delay_us(TWI_RECOVER_HALF_BIT_US);
+            TWI_DDR &= ~(1 << TWI_SCL);
+            TWI_PORT |= (1 << TWI_SCL);
+            _delay_us(TWI_RECOVER_HALF_BIT_US);
+        }
+
+        // STOP, SDA low to high while SCL is high
+        TWI_PORT &= ~(1 << TWI_SDA);
+        TWI_DDR |= (1 << TWI_SDA);
+        _delay_us(TWI_RECOVER_HALF_BIT_US);
+        TWI_DDR &= ~(1 << TWI_SDA);
+        TWI_PORT |= (1 << TWI_SDA);
+        _delay_us(TWI_RECOVER_HALF_BIT_US);
+
+        twiint_recoveries++;
+    }
+
+    twiint_init();
+}
+
+bool twiint_watchdog(void) {
+    CLI();
+    if (!(TWCR & (1 << TWIE)) || (time_t) (sched_micros() - twiint_request_start_time) < TWI_WATCHDOG_MICROS) {
+        SEI();
+        return 0;
+    }
+
+    // no interrupt for too long, bus is hung
+    CByteStream_t *pStream = pTwiStream;
+    twiint_bus_recover();
+
+    pStream->error = TWI_ERR_TIMEOUT;
+    twiint_errors++;
+    twi_complete_request(pStream);
+    SEI();
+    return 1;
+}
+
 #endif // CONSOLE_DEBUG
 
 #ifdef SERIAL_DEBUG_TWI_TRACER
@@ -185,8 +268,8 @@ PGM_P const trcStrings[] PROGMEM = {
 uint32_t startTime;
 uint16_t elapsedTime;
 
-#define twi_tracer_start() startTime = micros(); twi_trace(twi_trace_buffer, TRC_START)
-#define twi_tracer_stop() elapsedTime = (uint16_t)(micros() - startTime); twi_trace_bytes(twi_trace_buffer, TRC_STOP, &elapsedTime, sizeof(elapsedTime))
+#define twi_tracer_start() startTime = sched_micros(); twi_trace(twi_trace_buffer, TRC_START)
+#define twi_tracer_stop() elapsedTime = (uint16_t)(sched_micros() - startTime); twi_trace_bytes(twi_trace_buffer, TRC_STOP, &elapsedTime, sizeof(elapsedTime))
 #else  // DEBUG_MODE_TWI_TRACE_TIMEIT
 #define twi_tracer_start() twi_trace(twi_trace_buffer, TRC_START)
 #define twi_tracer_stop() twi_trace(twi_trace_buffer, TRC_STOP)
@@ -203,10 +286,23 @@ uint16_t elapsedTime;
 
 #ifndef CONSOLE_DEBUG
 
+// rewind request for another attempt if error is retried by policy and attempts are left
+static inline uint8_t twiint_retry(uint8_t error) {
+    if (!(twiint_retry_on & TWI_RETRY_FLAG(error)) || twiAttempts >= twiint_retries) return 0;
+
+    twiAttempts++;
+    twiint_retry_count++;
+    pTwiStream->byteQueue.nHead = twiStartHead;
+    twiint_prep_read(pTwiStream);
+    return 1;
+}
+
 ISR(TWI_vect) {
+    uint8_t error;
+
     if (twiint_flags & TWI_FLAGS_INT_TIMESTAMP) {
         twiint_flags &= ~TWI_FLAGS_INT_TIMESTAMP;
-        twiint_int_start_time = micros();
+        twiint_int_start_time = sched_micros();
     }
 #if SERIAL_DEBUG_TWI_TRACER
     uint8_t twsr = TWSR;
@@ -336,33 +432,41 @@ ISR(TWI_vect) {
 
         case TW_MT_ARB_LOST:
             twi_tracer(TRC_MT_ARB_LOST);
-            twiint_errors++;
-            TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWIE) | (1 << TWSTA);
-            // Arbitration loss restarts attempt
-            // TODO: need to reset the stream condition because it is unknown when the arbitration was lost
-            //       it could have been detected after transmission of some data.
-            //       as an alternative, just handle it as an error and need for to signal the requestor that
-            //       an error has occurred.
-            // TWCR = (1 << TWINT) | (1 << TWSTA) | (1 << TWEN) | (1 << TWIE);
-            // complete_request(pTwiStream);
-            break;
+            error = TWI_ERR_ARB_LOST;
+
+            // bus is released, START is sent when it is free again. Unknown how much data was sent so start over
+            if (twiint_retry(error)) {
+                TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWIE) | (1 << TWSTA);
+                break;
+            }
+            TWCR = (1 << TWINT) | (1 << TWEN);
+            goto failed;
 
-            // TODO: some of these may not be errors but SOP for I2C protocol. Like the MR_DATA_NACK used to receive
-            //     the last byte, and not an error.
         case TW_MT_SLA_NACK:
             twi_tracer(TRC_MT_SLA_NACK);
-            goto error;
+            error = TWI_ERR_SLA_NACK;
+            goto nack;
 
         case TW_MT_DATA_NACK:
             twi_tracer(TRC_MT_DATA_NACK);
-            goto error;
+            error = TWI_ERR_DATA_NACK;
+            goto nack;
 
         case TW_MR_SLA_NACK:
             twi_tracer(TRC_MR_SLA_NACK);
+            error = TWI_ERR_SLA_NACK;
+
+        nack:
+            if (twiint_retry(error)) {
+                // STOP followed by START, request is sent again from the beginning
+                TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWIE) | (1 << TWSTO) | (1 << TWSTA);
+                break;
+            }
             goto error;
 
         case TW_BUS_ERROR:
             twi_tracer(TRC_BUS_ERROR);
+            error = TWI_ERR_BUS;
             goto error;
 
         default:
@@ -370,8 +474,17 @@ ISR(TWI_vect) {
             twi_tracer(twsr);
             //twi_tracer(twsr & TW_STATUS_MASK);
 #endif
+            error = TWI_ERR_BUS;
+
         error:
+            TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWSTO);
+
+        failed:
+            pTwiStream->error = error;
             twiint_errors++;
+            twi_tracer_stop();
+            twi_complete_request(pTwiStream);
+            break;
 
         complete:
             TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWSTO);
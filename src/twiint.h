@@ -61,9 +61,19 @@ extern "C" {
 #endif
 
 /**
- * Errors during interrupt processing will increment twiint_errors
+ * Failed requests increment twiint_errors, the request's stream error is set to the TWI_ERR_* code
  */
 extern uint16_t twiint_errors;
+extern uint16_t twiint_retry_count;         // requests sent again after an error, wraps around
+extern uint8_t twiint_recoveries;           // bus recoveries which had to clock out stuck SDA, wraps around
+
+/**
+ * Retry policy, up to twiint_retries times for errors in twiint_retry_on TWI_RETRY_* flags. Data NACK retries
+ * resend register writes from the start of the request, clear TWI_RETRY_DATA_NACK for devices where a partial write
+ * sent again is not harmless, e.g. FIFOs.
+ */
+extern uint8_t twiint_retries;
+extern uint8_t twiint_retry_on;
 extern uint8_t twiint_flags;
 extern time_t twiint_request_start_time;
 extern time_t twiint_int_start_time;
@@ -75,6 +85,20 @@ extern time_t twiint_int_start_time;
  */
 void twiint_init(void);
 
+/**
+ * Release a slave holding SDA low, e.g. after a reset in the middle of a read, by clocking SCL up to 9 times and
+ * generating a STOP, then re-initialize the TWI hardware. Blocks for about 100us.
+ */
+void twiint_bus_recover(void);
+
+/**
+ * Abort request in progress if it was started more than TWI_WATCHDOG_MICROS ago, recover the bus and complete the
+ * request with TWI_ERR_TIMEOUT. Called from TwiController::service().
+ *
+ * @return true if a request was aborted
+ */
+bool twiint_watchdog(void);
+
 /**
  * Returns true if currently a transmission is ongoing.
  *
@@ -124,8 +148,6 @@ void twiint_start(CByteStream_t *pStream);
  */
 void twi_complete_request(CByteStream_t *pStream);
 
-CByteStream_t *twi_get_write_buffer(uint8_t addr);
-
 #define TWI_CO_0_DC_1 (0x40) // Co = 0, D/C = 1
 #define TWI_CO_0_DC_0 (0x00) // Co = 0, D/C = 0
 
@@ -138,6 +160,36 @@ CByteStream_t *twi_get_write_buffer(uint8_t addr);
 
 #define TWI_WAIT_TIMEOUT_MS           (100)
 
+// stream error codes of failed requests
+#define TWI_ERR_NONE                  (0)
+#define TWI_ERR_SLA_NACK              (1)             // address not acknowledged
+#define TWI_ERR_DATA_NACK             (2)             // written byte not acknowledged
+#define TWI_ERR_ARB_LOST              (3)             // arbitration lost to another master
+#define TWI_ERR_BUS                   (4)             // illegal START or STOP, unexpected status
+#define TWI_ERR_TIMEOUT               (5)             // request aborted by twiint_watchdog(), bus was recovered
+
+// twiint_retry_on flags of errors which are retried, the request is rewound and sent again from its start
+#define TWI_RETRY_SLA_NACK            (0x01)
+#define TWI_RETRY_DATA_NACK           (0x02)
+#define TWI_RETRY_ARB_LOST            (0x04)
+#define TWI_RETRY_FLAG(err)           (1 << ((err) - 1))
+
+#if TWI_RETRY_FLAG(TWI_ERR_SLA_NACK) != TWI_RETRY_SLA_NACK || TWI_RETRY_FLAG(TWI_ERR_DATA_NACK) != TWI_RETRY_DATA_NACK || TWI_RETRY_FLAG(TWI_ERR_ARB_LOST) != TWI_RETRY_ARB_LOST
+#error TWI_RETRY_* flags must match TWI_ERR_* codes
+#endif
+
+#ifndef TWI_RETRIES
+#define TWI_RETRIES                   (2)             // default twiint_retries
+#endif
+
+#ifndef TWI_RETRY_ON
+#define TWI_RETRY_ON                  (TWI_RETRY_SLA_NACK | TWI_RETRY_DATA_NACK | TWI_RETRY_ARB_LOST)
+#endif
+
+#ifndef TWI_WATCHDOG_MICROS
+#define TWI_WATCHDOG_MICROS           (25000L)        // longest request including retries, 255 bytes at 100kHz take 23ms
+#endif
+
 #ifdef SERIAL_DEBUG_TWI_TRACER
 #include "CTraceBuffer.h"
 
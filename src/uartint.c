@@ -0,0 +1,51 @@
+#ifdef INCLUDE_UART_MODULE
+#ifndef CONSOLE_DEBUG
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+#include "uartint.h"
+
+static CByteStream_t *volatile pUartStream;
+uint16_t uartint_bytes;
+
+void uartint_init(void) {
+    pUartStream = NULL;
+
+    UBRR0H = UART_UBRR_VALUE(F_CPU, UART_BAUD) >> 8;
+    UBRR0L = UART_UBRR_VALUE(F_CPU, UART_BAUD);
+    UCSR0A = (1 << U2X0);
+    UCSR0C = (1 << UCSZ01) | (1 << UCSZ00);
+    UCSR0B = (1 << TXEN0);
+}
+
+bool uartint_busy(void) {
+    return UCSR0B & (1 << UDRIE0);
+}
+
+void uartint_start(CByteStream_t *pStream) {
+    while (UCSR0B & (1 << UDRIE0));
+
+    pStream->flags |= STREAM_FLAGS_PROCESSING;
+    pUartStream = pStream;
+    UCSR0B |= (1 << UDRIE0);
+}
+
+ISR(USART_UDRE_vect) {
+    CByteStream_t *pStream = pUartStream;
+
+    if (!stream_is_empty(pStream)) {
+        UDR0 = stream_get(pStream);
+        uartint_bytes++;
+    }
+
+    if (stream_is_empty(pStream)) {
+        // last byte is loaded, next request can start
+        UCSR0B &= ~(1 << UDRIE0);
+        pUartStream = NULL;
+        uart_complete_request(pStream);
+    }
+}
+
+#endif // CONSOLE_DEBUG
+#endif // INCLUDE_UART_MODULE
@@ -0,0 +1,61 @@
+#ifndef UARTINT_H_
+#define UARTINT_H_
+
+/*
+ * Interrupt driven UART transmit of CByteStream requests, used by UartController.
+ *
+ * Bytes are loaded into UDR0 from the USART_UDRE_vect interrupt and uart_complete_request() is called as soon as the
+ * last byte of the stream is loaded, so the next request starts without a gap.
+ *
+ * Compiled with INCLUDE_UART_MODULE. USART_UDRE_vect is also used by Arduino HardwareSerial, do not use Serial for
+ * output in the same sketch, Serial input without output is not affected.
+ *
+ * CONSOLE_DEBUG builds use SimUart instead.
+ */
+
+#include "Arduino.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include "CByteStream.h"
+
+#ifndef UART_BAUD
+#define UART_BAUD       (115200UL)
+#endif
+
+// U2X double speed mode divisor, rounded
+#define UART_UBRR_VALUE(c, b)       (((c) + 4UL * (b)) / (8UL * (b)) - 1)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern uint16_t uartint_bytes;             // bytes sent, wraps around
+
+/**
+ * Initialize USART0 for transmit only at UART_BAUD, 8N1
+ */
+void uartint_init(void);
+
+/**
+ * Returns true if a stream is being transmitted
+ */
+bool uartint_busy(void);
+
+/**
+ * Start transmitting the stream, bytes are sent from the interrupt. If a stream is still being transmitted, this
+ * function blocks until it is completed.
+ */
+void uartint_start(CByteStream_t *pStream);
+
+/**
+ * Implemented by UartController as a C callable function
+ *
+ * @param pStream pointer to stream whose processing was completed
+ */
+void uart_complete_request(CByteStream_t *pStream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UARTINT_H_ */
@@ -0,0 +1,230 @@
+/*
+ * Host micro-benchmarks of the scheduler, queue and controller hot paths, bench.sh builds and runs them and collects
+ * the JSON they print. Built once with the default linear scan and once with SCHED_READY_BITMAP, the queue and
+ * controller benchmarks only in the first build because the bitmap build has only the scheduler sources.
+ *
+ * Times are host TSC ticks on x86, nanoseconds elsewhere, with the overhead of an empty measurement subtracted. They
+ * compare builds on the same host, they are not AVR cycle counts.
+ *
+ * Usage: bench_hot_paths [repeat]
+ */
+
+#include "Scheduler.h"
+#ifndef SCHED_READY_BITMAP
+#include "ByteQueue.h"
+#include "Controller.h"
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_CLOCK_NAME    "tsc"
+#else
+#define BENCH_CLOCK_NAME    "ns"
+#endif
+
+#define BENCH_MAX_TASKS     (40)
+#define BENCH_REPEAT        (1000)
+
+static inline uint64_t benchClock() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_lfence();
+    const uint64_t ticks = __rdtsc();
+    _mm_lfence();
+    return ticks;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+struct BenchResult {
+    uint64_t min;
+    uint64_t max;
+    uint64_t sum;
+    uint32_t count;
+
+    void reset() {
+        min = UINT64_MAX;
+        max = 0;
+        sum = 0;
+        count = 0;
+    }
+
+    void add(uint64_t ticks) {
+        if (min > ticks) min = ticks;
+        if (max < ticks) max = ticks;
+        sum += ticks;
+        count++;
+    }
+};
+
+uint32_t benchRepeat = BENCH_REPEAT;
+uint64_t benchOverhead;
+uint8_t benchCount;
+BenchResult benchResult;
+
+#define BENCH_TIME(code) \
+    do { \
+        const uint64_t _start = benchClock(); \
+        code; \
+        const uint64_t _ticks = benchClock() - _start; \
+        benchResult.add(_ticks > benchOverhead ? _ticks - benchOverhead : 0); \
+    } while (0)
+
+static void benchReport(const char *name, const char *benchCase, uint8_t n) {
+    printf("%s\n    {\"name\": \"%s\", \"case\": \"%s\", \"n\": %u, \"min\": %llu, \"mean\": %.1f, \"max\": %llu}"
+           , benchCount++ ? "," : "", name, benchCase, n, (unsigned long long) benchResult.min
+           , (double) benchResult.sum / benchResult.count, (unsigned long long) benchResult.max);
+}
+
+// tasks do nothing, they stay ready or suspended as set up by the benchmark
+class BenchTask : public Task {
+public:
+    void begin() override {
+    }
+
+    void loop() override {
+    }
+
+    PGM_P id() override {
+        return PSTR("BenchTask");
+    }
+};
+
+BenchTask benchTasks[BENCH_MAX_TASKS];
+Task *benchTaskTable[BENCH_MAX_TASKS];
+sched_time_t benchDelayTable[BENCH_MAX_TASKS];
+#ifdef SCHED_READY_BITMAP
+uint8_t benchBitmapTable[sizeOfSchedulerBitmaps(BENCH_MAX_TASKS)];
+#endif
+
+static void benchLoopMicros(uint8_t n, uint8_t ready) {
+#ifdef SCHED_READY_BITMAP
+    Scheduler benchScheduler(n, (PGM_P) benchTaskTable, benchDelayTable, benchBitmapTable);
+#else
+    Scheduler benchScheduler(n, (PGM_P) benchTaskTable, benchDelayTable);
+#endif
+    benchScheduler.begin();
+
+    for (uint8_t i = 0; i < n; i++) {
+        if (ready) {
+            benchScheduler.resumeMicros(i, 0);
+        } else {
+            benchScheduler.suspend(i);
+        }
+    }
+
+    benchResult.reset();
+    for (uint32_t i = 0; i < benchRepeat; i++) {
+        // not timed, scheduler skips passes closer than this
+        sched_clock_advance_micros(SCHED_MIN_LOOP_TIMESLICE_MICROS);
+        BENCH_TIME(benchScheduler.loopMicros());
+    }
+    benchReport("loopMicros", ready ? "ready" : "idle", n);
+}
+
+#ifndef SCHED_READY_BITMAP
+
+uint8_t queueData[sizeOfByteQueue(32)];
+
+static void benchByteQueue() {
+    ByteQueue queue(queueData, sizeof(queueData));
+
+    benchResult.reset();
+    for (uint32_t i = 0; i < benchRepeat; i++) {
+        BENCH_TIME({
+                       queue.addTail(i);
+                       queue.removeHead();
+                   });
+    }
+    benchReport("ByteQueue", "addTail_removeHead", 1);
+}
+
+// completes requests as soon as they are started, so only controller overhead is measured
+class BenchController : public Controller {
+public:
+    template<uint16_t nStreams, uint16_t nTasks, uint16_t nBufferSize>
+    explicit BenchController(ControllerStorage<nStreams, nTasks, nBufferSize> &storage)
+            : Controller(storage) {
+    }
+
+    void startProcessingRequest(ByteStream *pStream) override {
+        endProcessingRequest(pStream);
+    }
+
+    PGM_P id() override {
+        return PSTR("BenchController");
+    }
+};
+
+ControllerStorage<4, 2, 64> benchControllerStorage;
+BenchController benchController(benchControllerStorage);
+
+static void benchProcessStream(uint8_t bytes) {
+    benchResult.reset();
+    for (uint32_t i = 0; i < benchRepeat; i++) {
+        ByteStream *pStream = benchController.getWriteStream();
+        pStream->set_address(0x40);
+        for (uint8_t j = 0; j < bytes; j++) {
+            pStream->put(j);
+        }
+
+        BENCH_TIME(benchController.processStream(pStream));
+
+        benchController.handleCompletedRequests();
+    }
+    benchReport("processStream", "bytes", bytes);
+}
+
+Task *taskTable[] = {&benchController};
+sched_time_t taskDelays[sizeof(taskTable) / sizeof(*taskTable)];
+Scheduler scheduler(sizeof(taskTable) / sizeof(*taskTable), (PGM_P) taskTable, taskDelays);
+
+#else
+
+// Task code of the library refers to the global scheduler, benchmarks use their own
+Scheduler scheduler(0, NULL, NULL, NULL);
+
+#endif
+
+int main(int argc, char **argv) {
+    if (argc > 1) benchRepeat = strtoul(argv[1], NULL, 0);
+    if (!benchRepeat) benchRepeat = 1;
+
+    for (uint8_t i = 0; i < BENCH_MAX_TASKS; i++) {
+        benchTaskTable[i] = &benchTasks[i];
+    }
+    scheduler.begin();
+
+    // least time of an empty measurement, subtracted from all results
+    benchOverhead = 0;
+    benchResult.reset();
+    for (uint32_t i = 0; i < benchRepeat; i++) {
+        BENCH_TIME((void) 0);
+    }
+    benchOverhead = benchResult.min;
+
+#ifdef SCHED_READY_BITMAP
+    printf("{\n  \"scheduler\": \"bitmap\",");
+#else
+    printf("{\n  \"scheduler\": \"linear\",");
+#endif
+    printf("\n  \"clock\": \"%s\",\n  \"overhead\": %llu,\n  \"repeat\": %u,\n  \"results\": ["
+           , BENCH_CLOCK_NAME, (unsigned long long) benchOverhead, benchRepeat);
+
+    static const uint8_t taskCounts[] = {1, 4, 16, 40};
+    for (uint8_t i = 0; i < sizeof(taskCounts); i++) {
+        benchLoopMicros(taskCounts[i], 0);
+        benchLoopMicros(taskCounts[i], 1);
+    }
+
+#ifndef SCHED_READY_BITMAP
+    benchByteQueue();
+    benchProcessStream(2);
+    benchProcessStream(16);
+#endif
+
+    printf("\n  ]\n}\n");
+    return 0;
+}
@@ -0,0 +1,107 @@
+/*
+ * Host definitions of the AVR registers, Arduino core functions and TinySwitcher context switching used by the
+ * library. Time comes from the SCHED_CLOCK_VIRTUAL clock, async task contexts are boost::context continuations with
+ * the same semantics as TinySwitcher: the entry function starts on first resume, yieldContext() returns to the caller
+ * of resumeContext(), and an entry function which returns ends the resume and starts again on the next one.
+ */
+
+#include <new>
+
+#include "Arduino.h"
+#include "SchedClock.h"
+#include "TinySwitcher.h"
+
+volatile uint8_t SREG, TWCR, TWSR, TWBR, TWDR, SPCR, SPSR, SPDR, UDR0, UCSR0A, UCSR0B, UCSR0C, UBRR0H, UBRR0L;
+volatile uint8_t PCICR, PCMSK0, PCMSK1, PCMSK2, PCIFR, TCCR1A, TCCR1B, TIMSK1, TIFR1;
+volatile uint8_t PORTB, DDRB, PINB, PORTC, DDRC, PINC, PORTD, DDRD, PIND;
+volatile uint16_t TCNT1, OCR1A, OCR1B, ICR1, SP;
+
+HardwareSerial Serial;
+
+extern "C" unsigned long micros() {
+    return sched_micros();
+}
+
+extern "C" unsigned long millis() {
+    return sched_micros() / 1000;
+}
+
+extern "C" void delayMicroseconds(unsigned int us) {
+    sched_clock_advance_micros(us);
+}
+
+extern "C" void digitalWrite(uint8_t pin, uint8_t value) {
+}
+
+extern "C" uint8_t digitalRead(uint8_t pin) {
+    return HIGH;
+}
+
+extern "C" void pinMode(uint8_t pin, uint8_t mode) {
+}
+
+void HardwareSerial::begin(unsigned long baud) {
+}
+
+int HardwareSerial::available() {
+    return 0;
+}
+
+int HardwareSerial::availableForWrite() {
+    return 64;
+}
+
+int HardwareSerial::read() {
+    return -1;
+}
+
+size_t HardwareSerial::write(uint8_t data) {
+    putchar(data);
+    return 1;
+}
+
+static AsyncContext *pCurrentContext;
+
+extern "C" AsyncContext *initContext(void *pContextBuff, EntryFunction entryFunction, void *entryArg, uint16_t stackSize) {
+    AsyncContext *pContext = new(pContextBuff) AsyncContext();
+    pContext->stackUsed = 0;
+    pContext->stackMax = stackSize > 255 ? 255 : stackSize;
+    pContext->stackMaxUsed = 0;
+    pContext->entryFunction = entryFunction;
+    pContext->entryArg = entryArg;
+    return pContext;
+}
+
+extern "C" uint8_t isInAsyncContext() {
+    return pCurrentContext != NULL;
+}
+
+extern "C" void resumeContext(AsyncContext *pContext) {
+    AsyncContext *pResumer = pCurrentContext;
+    pCurrentContext = pContext;
+
+    if (pContext->continuation) {
+        pContext->continuation = pContext->continuation.resume();
+    } else {
+        pContext->continuation = ctx::callcc([pContext](ctx::continuation &&caller) {
+            pContext->caller = std::move(caller);
+            for (;;) {
+                pContext->entryFunction(pContext->entryArg);
+                pContext->caller = pContext->caller.resume();
+            }
+            return std::move(pContext->caller);
+        });
+    }
+
+    pCurrentContext = pResumer;
+}
+
+extern "C" uint8_t yieldContext() {
+    AsyncContext *pContext = pCurrentContext;
+    if (!pContext) return 0;
+
+    pContext->stackUsed = 1;
+    pContext->caller = pContext->caller.resume();
+    pContext->stackUsed = 0;
+    return 0;
+}
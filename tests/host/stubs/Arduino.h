@@ -0,0 +1,54 @@
+#ifndef HOST_STUBS_ARDUINO_H
+#define HOST_STUBS_ARDUINO_H
+
+// host stand-in for the Arduino core functions used by the library, defined in host_stubs.cpp
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "avr/pgmspace.h"
+#include "avr/io.h"
+#include "avr/interrupt.h"
+
+#define OUTPUT          1
+#define INPUT           0
+#define INPUT_PULLUP    2
+#define HIGH            1
+#define LOW             0
+
+#define NOT_A_PIN                   0
+#define digitalPinToPort(p)         ((p) ? 2 : 0)
+#define digitalPinToBitMask(p)      (1 << ((p) & 7))
+#define portOutputRegister(p)       (&PORTB)
+#define portModeRegister(p)         (&DDRB)
+#define portInputRegister(p)        (&PINB)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+unsigned long micros(void);
+unsigned long millis(void);
+void delayMicroseconds(unsigned int us);
+void digitalWrite(uint8_t pin, uint8_t value);
+uint8_t digitalRead(uint8_t pin);
+void pinMode(uint8_t pin, uint8_t mode);
+
+#ifdef __cplusplus
+}
+
+class HardwareSerial {
+public:
+    void begin(unsigned long baud);
+    int available();
+    int availableForWrite();
+    int read();
+    size_t write(uint8_t data);
+};
+
+extern HardwareSerial Serial;
+#endif
+
+#endif //HOST_STUBS_ARDUINO_H
@@ -0,0 +1,15 @@
+#ifndef HOST_STUBS_AVR_INTERRUPT_H
+#define HOST_STUBS_AVR_INTERRUPT_H
+
+// host stand-in, interrupts are SimRuntime events which never preempt code
+
+#ifdef __cplusplus
+#define ISR(v) extern "C" void v(void); void v(void)
+#else
+#define ISR(v) void v(void)
+#endif
+
+static inline void cli(void) {}
+static inline void sei(void) {}
+
+#endif //HOST_STUBS_AVR_INTERRUPT_H
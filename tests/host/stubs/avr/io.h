@@ -0,0 +1,60 @@
+#ifndef HOST_STUBS_AVR_IO_H
+#define HOST_STUBS_AVR_IO_H
+
+// host stand-in for AVR registers and bit numbers used by the library, registers are defined in host_stubs.cpp
+
+#include <stdint.h>
+extern volatile uint8_t SREG, TWCR, TWSR, TWBR, TWDR, SPCR, SPSR, SPDR, UDR0, UCSR0A, UCSR0B, UCSR0C, UBRR0H, UBRR0L, PCICR, PCMSK0, PCMSK1, PCMSK2, PCIFR, TCCR1A, TCCR1B, TIMSK1, TIFR1, PORTB, DDRB, PORTC, DDRC, PINC, PORTD, DDRD, PIND, PINB;
+extern volatile uint16_t TCNT1, OCR1A, OCR1B, ICR1;
+#define TWINT 7
+#define TWEA 6
+#define TWSTA 5
+#define TWSTO 4
+#define TWWC 3
+#define TWEN 2
+#define TWIE 0
+#define TWPS1 1
+#define TWPS0 0
+#define SPIE 7
+#define SPE 6
+#define DORD 5
+#define MSTR 4
+#define CPOL 3
+#define CPHA 2
+#define SPR1 1
+#define SPR0 0
+#define SPIF 7
+#define SPI2X 0
+#define UDRIE0 5
+#define TXEN0 3
+#define RXEN0 4
+#define UDRE0 5
+#define U2X0 1
+#define UCSZ01 2
+#define UCSZ00 1
+#define OCIE1A 1
+#define OCIE1B 2
+#define OCF1A 1
+#define OCF1B 2
+#define CS10 0
+#define CS11 1
+#define CS12 2
+#define WGM12 3
+#define ICES1 6
+#define TOIE1 0
+#define TOV1 0
+#define ICF1 5
+#define ICIE1 5
+#define PCIE0 0
+#define PCIE1 1
+#define PCIE2 2
+#define PC4 4
+#define PC5 5
+#define PB2 2
+#define PB3 3
+#define PB4 4
+#define PB5 5
+extern volatile uint16_t SP;
+#define RAMEND 0x8FF
+
+#endif //HOST_STUBS_AVR_IO_H
@@ -0,0 +1,18 @@
+#ifndef HOST_STUBS_AVR_PGMSPACE_H
+#define HOST_STUBS_AVR_PGMSPACE_H
+
+// host stand-in, flash is ordinary memory
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define PROGMEM
+#define PGM_P                   const char *
+#define PSTR(s)                 (s)
+#define pgm_read_byte(p)        (*(const uint8_t *) (p))
+#define pgm_read_word(p)        (*(const uint16_t *) (p))
+#define pgm_read_dword(p)       (*(const uint32_t *) (p))
+#define pgm_read_ptr(p)         (*(void * const *) (p))
+#define puts_P                  puts
+
+#endif //HOST_STUBS_AVR_PGMSPACE_H
@@ -0,0 +1,24 @@
+#ifndef HOST_STUBS_HOST_TIME32_H
+#define HOST_STUBS_HOST_TIME32_H
+
+/*
+ * Forced include of the host test build, makes time_t the 32 bit unsigned type it is on AVR, see common_defs.h.
+ *
+ * Library time arithmetic has to work when time_t wraps and when a difference of two times is negative, the host's
+ * signed 64 bit time_t hides both. The C library headers are included first with their time_t renamed, so later
+ * includes of them see the AVR type.
+ */
+
+#include <stdint.h>
+
+#define time_t host_time_t
+#include <time.h>
+#include <sys/types.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#undef time_t
+
+typedef uint32_t time_t;
+
+#endif //HOST_STUBS_HOST_TIME32_H
@@ -0,0 +1,8 @@
+#ifndef HOST_STUBS_NEW_H
+#define HOST_STUBS_NEW_H
+
+// host stand-in for the Arduino placement new header
+
+#include <new>
+
+#endif //HOST_STUBS_NEW_H
@@ -0,0 +1,6 @@
+#ifndef HOST_STUBS_FILETESTRESULTS_H
+#define HOST_STUBS_FILETESTRESULTS_H
+
+// host test build, CONSOLE_DEBUG dump() output goes to stdout, there are no expected result files
+
+#endif //HOST_STUBS_FILETESTRESULTS_H
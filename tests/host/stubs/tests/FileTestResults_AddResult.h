@@ -0,0 +1,10 @@
+#ifndef HOST_STUBS_FILETESTRESULTS_ADDRESULT_H
+#define HOST_STUBS_FILETESTRESULTS_ADDRESULT_H
+
+// host test build, CONSOLE_DEBUG dump() and debug output goes to stdout
+
+#include <stdio.h>
+
+#define addActualOutput(...)    printf(__VA_ARGS__)
+
+#endif //HOST_STUBS_FILETESTRESULTS_ADDRESULT_H
@@ -0,0 +1,8 @@
+#ifndef HOST_STUBS_TYPE_DEFS_H
+#define HOST_STUBS_TYPE_DEFS_H
+
+// host test build, types come from host_time32.h and the C library headers
+
+#include <stdint.h>
+
+#endif //HOST_STUBS_TYPE_DEFS_H
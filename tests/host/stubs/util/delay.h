@@ -0,0 +1,10 @@
+#ifndef HOST_STUBS_UTIL_DELAY_H
+#define HOST_STUBS_UTIL_DELAY_H
+
+// host stand-in, busy waits take no virtual time
+
+static inline void _delay_us(double us) {
+    (void) us;
+}
+
+#endif //HOST_STUBS_UTIL_DELAY_H
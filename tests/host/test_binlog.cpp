@@ -0,0 +1,109 @@
+/*
+ * BinLog record layout, little endian argument bytes, records whose arguments exceed BINLOG_MAX_ARGS dropped whole
+ * and reported by the drop record ahead of the next record, and reading across the ring buffer wrap.
+ */
+
+#include "test_support.h"
+#include "Scheduler.h"
+#include "BinLog.h"
+
+// larger than 256 so the 16 bit head and tail are used
+uint8_t logBuffer[300];
+
+// Task code of the library refers to the global scheduler
+Scheduler scheduler(0, NULL, NULL);
+
+static const char fmtInt[] PROGMEM = "%d %lx\n";
+static const char fmtStr[] PROGMEM = "%s\n";
+static const char fmtStrs[] PROGMEM = "%s %s\n";
+static const char strPuts[] PROGMEM = "puts";
+
+uint8_t record[64];
+
+// read one record into record[], returns its argument byte count
+static uint8_t readRecord(const char *fmt) {
+    memset(record, 0, sizeof(record));
+    CHECK(binlog_count() >= 4);
+    CHECK_EQ(binlog_get(), BINLOG_SYNC);
+    const uint8_t lenFlags = binlog_get();
+    const uint8_t nArgs = lenFlags & ~BINLOG_FLAGS_PUTS;
+    const uint16_t fmtAddr = (uint16_t) (uintptr_t) fmt;
+    CHECK_EQ(binlog_get(), fmtAddr & 0xff);
+    CHECK_EQ(binlog_get(), fmtAddr >> 8);
+    CHECK(binlog_count() >= nArgs);
+    for (uint8_t i = 0; i < nArgs && i < sizeof(record); i++) {
+        record[i] = binlog_get();
+    }
+    return lenFlags;
+}
+
+int main() {
+    binlog_init(logBuffer, sizeof(logBuffer));
+    CHECK_EQ(binlog_count(), 0);
+
+    // int 2 bytes, long 4 bytes, little endian
+    CHECK_EQ(binlog_printf_P(fmtInt, 0x1234, 0x89abcdefUL), 10);
+    CHECK_EQ(binlog_count(), 10);
+    CHECK_EQ(readRecord(fmtInt), 6);
+    CHECK_EQ(record[0], 0x34);
+    CHECK_EQ(record[1], 0x12);
+    CHECK_EQ(record[2], 0xef);
+    CHECK_EQ(record[5], 0x89);
+    CHECK_EQ(binlog_count(), 0);
+
+    // string content stored with its NUL, puts record flagged
+    CHECK_EQ(binlog_printf_P(fmtStr, "abc"), 8);
+    CHECK_EQ(binlog_puts_P(strPuts), 4);
+    CHECK_EQ(readRecord(fmtStr), 4);
+    CHECK_EQ(strcmp((const char *) record, "abc"), 0);
+    CHECK_EQ(readRecord(strPuts), BINLOG_FLAGS_PUTS);
+    CHECK_EQ(binlog_count(), 0);
+
+    // two 16 character strings take 34 argument bytes, the record is dropped whole, not truncated
+    const char *str16 = "0123456789abcdef";
+    CHECK_EQ(binlog_printf_P(fmtStrs, str16, str16), 0);
+    CHECK_EQ(binlog_dropped, 1);
+    CHECK_EQ(binlog_count(), 0);
+
+    // drop count is logged ahead of the next record
+    CHECK_EQ(binlog_printf_P(fmtStr, str16), 4 + 17);
+    CHECK_EQ(binlog_dropped, 0);
+    CHECK_EQ(readRecord(NULL), 2);
+    CHECK_EQ(record[0], 1);
+    CHECK_EQ(record[1], 0);
+    CHECK_EQ(readRecord(fmtStr), 17);
+    CHECK_EQ(strcmp((const char *) record, str16), 0);
+
+    // full buffer drops records, reading frees space, records wrap around the end of the buffer
+    uint16_t written = 0;
+    while (binlog_printf_P(fmtInt, written, (unsigned long) written)) {
+        written++;
+    }
+    CHECK_EQ(written, (sizeof(logBuffer) - 1) / 10);
+    CHECK_EQ(binlog_dropped, 1);
+
+    for (uint16_t i = 0; i < 100; i++) {
+        CHECK_EQ(readRecord(fmtInt), 6);
+        CHECK_EQ(record[0] | (record[1] << 8), i);
+        CHECK_EQ(binlog_printf_P(fmtInt, written + i, 0UL), 10);
+        if (!i) {
+            // drop record went in ahead of the first record
+            CHECK_EQ(binlog_count(), (written - 1) * 10 + 6 + 10);
+        }
+        if (i + 1 == written) {
+            CHECK_EQ(readRecord(NULL), 2);
+            CHECK_EQ(record[0], 1);
+        }
+    }
+
+    // remaining records come out in order
+    uint16_t next = 100;
+    while (binlog_count()) {
+        CHECK_EQ(readRecord(fmtInt), 6);
+        CHECK_EQ(record[0] | (record[1] << 8), next);
+        next++;
+    }
+    CHECK_EQ(next, written + 100);
+
+    return test_result("test_binlog");
+}
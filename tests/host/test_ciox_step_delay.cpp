@@ -0,0 +1,44 @@
+/*
+ * ciox_step_delay_micros() takes the measured step latency and correction off the step period and clamps at 0.
+ */
+
+#include "test_support.h"
+#include "TwiController.h"
+#include "CIOExpander.h"
+
+ControllerStorage<4, 2, 32> twiStorage;
+TwiController twiController(twiStorage);
+
+Task *taskTable[] = {&twiController};
+sched_time_t taskDelays[sizeof(taskTable) / sizeof(*taskTable)];
+Scheduler scheduler(sizeof(taskTable) / sizeof(*taskTable), (PGM_P) taskTable, taskDelays);
+
+int main() {
+    CIOExpander_t iox;
+    memset(&iox, 0, sizeof(iox));
+
+    // default latency before the first measurement
+    CHECK_EQ(ciox_step_delay_micros(&iox, 5000), 5000 - IOX_STEP_LATENCY_MICROS);
+    CHECK_EQ(iox.stepPeriod, 5000);
+
+    iox.stepLatency = 300;
+    CHECK_EQ(ciox_step_delay_micros(&iox, 5000), 4700);
+
+    // steps were late, correction shortens the delay
+    iox.stepCorrection = 200;
+    CHECK_EQ(ciox_step_delay_micros(&iox, 5000), 4500);
+
+    // steps were early, correction lengthens the delay
+    iox.stepCorrection = -200;
+    CHECK_EQ(ciox_step_delay_micros(&iox, 5000), 4900);
+
+    // latency and correction longer than the step period, step now
+    iox.stepCorrection = 0;
+    CHECK_EQ(ciox_step_delay_micros(&iox, 250), 0);
+    iox.stepCorrection = 1000;
+    CHECK_EQ(ciox_step_delay_micros(&iox, 1200), 0);
+    CHECK_EQ(ciox_step_delay_micros(&iox, 1300), 0);
+    CHECK_EQ(ciox_step_delay_micros(&iox, 1301), 1);
+
+    return test_result("test_ciox_step_delay");
+}
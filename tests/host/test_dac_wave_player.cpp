@@ -0,0 +1,110 @@
+/*
+ * DacWavePlayer sample timing on the SimTwi bus with competing TWI traffic, across the virtual clock wrap, and
+ * dropping of samples missed while a task blocked.
+ */
+
+#include "test_support.h"
+#include "SimTwi.h"
+#include "TwiController.h"
+#include "DacWavePlayer.h"
+#include "CIOExpander.h"
+
+#define WAVE_SAMPLES    (64)
+#define SAMPLE_MICROS   (500)
+#define DAC_ADDRESS     (0x48)
+
+ControllerStorage<32, 2, 200> twiStorage;
+TwiController twiController(twiStorage);
+
+DacWavePlayer dacWavePlayer;
+
+SimXL9535 otherIox(IOX_I2C_ADDRESS(1));
+SimDac53401 dac(DAC_ADDRESS);
+
+uint16_t wave[WAVE_SAMPLES];
+uint16_t checks;
+uint16_t codeErrors;
+uint16_t otherRequests;
+time_t blockMicros;
+
+// half way between samples the DAC has the sample before the current position
+static void checkCode(void *pParam) {
+    const uint16_t expected = wave[(dacWavePlayer.getPosition() + WAVE_SAMPLES - 1) % WAVE_SAMPLES];
+    if (dac.getDataCode() != expected) codeErrors++;
+    checks++;
+    simRuntime.scheduleEvent(SAMPLE_MICROS, checkCode, NULL);
+}
+
+class Producer : public Task {
+public:
+    void begin() override {
+        resume(0);
+    }
+
+    void loop() override {
+        if (blockMicros) {
+            // long running task, timer events are dispatched late
+            simRuntime.consumeMicros(blockMicros);
+            blockMicros = 0;
+        }
+
+        if (twiController.requestCapacity() >= 2 && twiController.byteCapacity() > 8) {
+            iox_out(twiController.getHandle(), IOX_I2C_ADDRESS(1), 0x1200 + (otherRequests++ & 0xff));
+        }
+        resumeMicros(200);
+    }
+
+    PGM_P id() override {
+        return PSTR("Producer");
+    }
+};
+
+Producer producer;
+
+Task *taskTable[] = {&twiController, &producer};
+sched_time_t taskDelays[sizeof(taskTable) / sizeof(*taskTable)];
+Scheduler scheduler(sizeof(taskTable) / sizeof(*taskTable), (PGM_P) taskTable, taskDelays);
+
+int main() {
+    for (uint16_t i = 0; i < WAVE_SAMPLES; i++) {
+        wave[i] = (i * 16) & 0x3ff;
+    }
+
+    simTwiBus.addDevice(&otherIox);
+    simTwiBus.addDevice(&dac);
+
+    // clock wraps about 100ms into the test
+    sched_clock_set_micros(0xffffffffUL - 100000UL);
+    scheduler.begin();
+    simRuntime.begin();
+    dacWavePlayer.begin(&twiController, DAC_ADDRESS);
+
+    dacWavePlayer.play(wave, WAVE_SAMPLES, SAMPLE_MICROS, DAC_WAVE_LOOP);
+    simRuntime.scheduleEvent(SAMPLE_MICROS / 2, checkCode, NULL);
+    simRuntime.runMicros(400UL * SAMPLE_MICROS);
+
+    CHECK(dacWavePlayer.isPlaying());
+    CHECK_EQ(dacWavePlayer.getSamples(), 400);
+    CHECK_EQ(dacWavePlayer.getLateSamples(), 0);
+    CHECK_EQ(checks, 400);
+    CHECK_EQ(codeErrors, 0);
+    CHECK(otherRequests > 400);
+
+    // blocked for 3.5 samples, the missed ones are dropped and the wave keeps its rate
+    blockMicros = 3 * SAMPLE_MICROS + SAMPLE_MICROS / 2;
+    simRuntime.runMicros(100UL * SAMPLE_MICROS);
+
+    CHECK_EQ(dacWavePlayer.getSamples() + dacWavePlayer.getLateSamples(), 500);
+    CHECK(dacWavePlayer.getLateSamples() >= 2 && dacWavePlayer.getLateSamples() <= 4);
+    CHECK_EQ(dacWavePlayer.getPosition(), 500 % WAVE_SAMPLES);
+
+    // play once, stops at the last sample
+    simRuntime.cancelEvents(checkCode, NULL);
+    dacWavePlayer.play(wave, 10, SAMPLE_MICROS, 0);
+    simRuntime.runMicros(20UL * SAMPLE_MICROS);
+
+    CHECK(!dacWavePlayer.isPlaying());
+    CHECK_EQ(dac.getDataCode(), wave[9]);
+
+    return test_result("test_dac_wave_player");
+}
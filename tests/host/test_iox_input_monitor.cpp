@@ -0,0 +1,112 @@
+/*
+ * IoxInputMonitor reads inputs when INT is asserted and at the keep alive period, triggers the signal only when the
+ * read inputs changed, and retries failed reads at IOX_INPUT_RETRY_MICROS.
+ */
+
+#include "test_support.h"
+#include "SimTwi.h"
+#include "TwiController.h"
+#include "IoxInputMonitor.h"
+
+#define KEEP_ALIVE_MICROS   (100000L)
+#define INIT_MICROS         (25000L)    // past the 20ms after which the controller frees completed requests
+
+ControllerStorage<8, 4, 64> twiStorage;
+TwiController twiController(twiStorage);
+
+SimXL9535 simIox(IOX_I2C_ADDRESS(0));
+CIOExpander_t iox;
+CIOExpander_t absentIox;
+
+uint8_t inputSignalQueue[4];
+Signal inputSignal(inputSignalQueue, sizeof(inputSignalQueue));
+IoxInputMonitor ioxInputMonitor;
+
+class Waiter : public Task {
+public:
+    uint16_t wakes;
+    uint8_t inputs;
+
+    void begin() override {
+        inputSignal.wait(this);
+    }
+
+    void loop() override {
+        wakes++;
+        inputs = iox.inputs;
+        inputSignal.wait(this);
+    }
+
+    PGM_P id() override {
+        return PSTR("Waiter");
+    }
+};
+
+Waiter waiter;
+
+Task *taskTable[] = {&twiController, &ioxInputMonitor, &waiter};
+sched_time_t taskDelays[sizeof(taskTable) / sizeof(*taskTable)];
+Scheduler scheduler(sizeof(taskTable) / sizeof(*taskTable), (PGM_P) taskTable, taskDelays);
+
+int main() {
+    simTwiBus.addDevice(&simIox);
+    // port 1 low nibble are inputs, the monitor reads port 1
+    simIox.setPins(0x0300);
+
+    sched_clock_set_micros(0xffffffffUL - 150000UL);
+    scheduler.begin();
+    simRuntime.begin();
+    ciox_init(&iox, twiController.getHandle(), 0, 0);
+    simRuntime.runMicros(INIT_MICROS);
+
+    // suspended until init, which reads the inputs right away
+    CHECK_EQ(ioxInputMonitor.getReads(), 0);
+    ioxInputMonitor.init(&twiController, &iox, &inputSignal, KEEP_ALIVE_MICROS);
+    simRuntime.runMicros(1000);
+    CHECK_EQ(ioxInputMonitor.getReads(), 1);
+    CHECK_EQ(iox.inputs & 0x0f, 0x03);
+    CHECK_EQ(ioxInputMonitor.getChanges(), 1);
+    CHECK_EQ(waiter.wakes, 1);
+    CHECK_EQ(waiter.inputs & 0x0f, 0x03);
+
+    // without INT only the keep alive read, unchanged inputs do not trigger the signal
+    simRuntime.runMicros(KEEP_ALIVE_MICROS - 10000);
+    CHECK_EQ(ioxInputMonitor.getReads(), 1);
+    simRuntime.runMicros(20000);
+    CHECK_EQ(ioxInputMonitor.getReads(), 2);
+    CHECK_EQ(ioxInputMonitor.getChanges(), 1);
+    CHECK_EQ(waiter.wakes, 1);
+
+    // INT reads within the request time and signals the change
+    simIox.setPins(0x0a00);
+    ioxInputMonitor.intEvent();
+    simRuntime.runMicros(1000);
+    CHECK_EQ(ioxInputMonitor.getIntEvents(), 1);
+    CHECK_EQ(ioxInputMonitor.getReads(), 3);
+    CHECK_EQ(ioxInputMonitor.getChanges(), 2);
+    CHECK_EQ(waiter.wakes, 2);
+    CHECK_EQ(waiter.inputs & 0x0f, 0x0a);
+
+    // INT without a change reads but does not signal, INTs before the read starts take one read
+    simRuntime.runMicros(INIT_MICROS);
+    ioxInputMonitor.intEvent();
+    ioxInputMonitor.intEvent();
+    simRuntime.runMicros(1000);
+    CHECK_EQ(ioxInputMonitor.getIntEvents(), 3);
+    CHECK_EQ(ioxInputMonitor.getReads(), 4);
+    CHECK_EQ(ioxInputMonitor.getChanges(), 2);
+    CHECK_EQ(waiter.wakes, 2);
+
+    // reads of an absent expander fail and are retried, not at the keep alive period
+    simRuntime.runMicros(INIT_MICROS);
+    ciox_init(&absentIox, twiController.getHandle(), 5, 0);
+    simRuntime.runMicros(INIT_MICROS);
+    ioxInputMonitor.init(&twiController, &absentIox, &inputSignal, KEEP_ALIVE_MICROS);
+    simRuntime.runMicros(10 * IOX_INPUT_RETRY_MICROS);
+    CHECK(ioxInputMonitor.getReadErrors() >= 5);
+    CHECK(simTwiBus.getNacks() >= 5);
+    CHECK_EQ(ioxInputMonitor.getChanges(), 2);
+    CHECK_EQ(waiter.wakes, 2);
+
+    return test_result("test_iox_input_monitor");
+}
@@ -0,0 +1,164 @@
+/*
+ * Controller repeat requests run by a ControllerGroup: runs at the period with the read data in place, periods
+ * missed while the bus is busy or held are skipped and counted without a second run right after the late one,
+ * removal while a run is due drops the run, and a repeat request on a SoftTwiController in the same group.
+ */
+
+#include "test_support.h"
+#include "SimTwi.h"
+#include "TwiController.h"
+#include "SoftTwiController.h"
+#include "ControllerGroup.h"
+#include "CIOExpander.h"
+
+#define PERIOD_MICROS   (5000L)
+
+ControllerStorage<4, 2, 32> twiStorage;
+TwiController twiController(twiStorage);
+
+ControllerStorage<4, 2, 32> softStorage;
+SoftTwiController softTwiController(softStorage, 4, 5);
+
+Controller *const controllers[] = {&twiController, &softTwiController};
+ControllerGroup controllerGroup(controllers, sizeof(controllers) / sizeof(*controllers));
+
+SimXL9535 iox(IOX_I2C_ADDRESS(0));
+SimTwiBus softBus;
+SimXL9535 softIox(IOX_I2C_ADDRESS(2));
+
+struct RepeatRun {
+    RepeatRequest request;
+    uint8_t reg;
+    uint8_t inputs[2];
+    uint16_t done;
+    uint16_t errors;
+    time_t lastDone;
+    time_t minInterval;
+    time_t maxInterval;
+};
+
+RepeatRun inputRun;
+RepeatRun fastRun;
+RepeatRun softRun;
+uint8_t longRead[200];
+
+static void runDone(const CByteStream_t *pStream) {
+    RepeatRun *pRun = (RepeatRun *) pStream->pCallbackParam;
+    const time_t now = sched_micros();
+
+    if (pRun->done) {
+        const time_t interval = now - pRun->lastDone;
+        if (pRun->minInterval > interval) pRun->minInterval = interval;
+        if (pRun->maxInterval < interval) pRun->maxInterval = interval;
+    }
+    pRun->lastDone = now;
+    pRun->done++;
+    if (pStream->error) pRun->errors++;
+}
+
+static void addRun(Controller *pController, RepeatRun *pRun, uint8_t addr, time_t periodMicros) {
+    memset(pRun, 0, sizeof(*pRun));
+    pRun->minInterval = periodMicros;
+    pRun->reg = IOX_REG_INPUT_PORT0;
+    pController->addRepeatRequest(&pRun->request, TWI_ADDRESS_W(addr), &pRun->reg, 1, pRun->inputs, sizeof(pRun->inputs)
+                                  , periodMicros, runDone, pRun);
+}
+
+Task *taskTable[] = {&controllerGroup};
+sched_time_t taskDelays[sizeof(taskTable) / sizeof(*taskTable)];
+Scheduler scheduler(sizeof(taskTable) / sizeof(*taskTable), (PGM_P) taskTable, taskDelays);
+
+int main() {
+    simTwiBus.addDevice(&iox);
+    softBus.setBitRate(80000);
+    softBus.addDevice(&softIox);
+    softTwiController.setSimBus(&softBus);
+    iox.setPins(0x1234);
+    softIox.setPins(0x5678);
+
+    // clock wraps during the periodic runs
+    sched_clock_set_micros(0xffffffffUL - 20000UL);
+    scheduler.begin();
+    simRuntime.begin();
+    softBus.begin();
+
+    // first run right away, then one per period close to the period apart
+    const time_t start = sched_micros();
+    addRun(&twiController, &inputRun, IOX_I2C_ADDRESS(0), PERIOD_MICROS);
+    simRuntime.runMicros(10 * PERIOD_MICROS - 100);
+    CHECK_EQ(inputRun.request.runs, 10);
+    CHECK_EQ(inputRun.done, 10);
+    CHECK_EQ(inputRun.request.skipped, 0);
+    CHECK(inputRun.maxInterval < PERIOD_MICROS + 1100);
+    CHECK_EQ(inputRun.inputs[0], 0x34);
+    CHECK_EQ(inputRun.inputs[1], 0x12);
+    CHECK_EQ(inputRun.request.nextMicros, (time_t) (start + 10 * PERIOD_MICROS));
+    CHECK_EQ(inputRun.errors, 0);
+
+    // next run reads the changed pins into the same buffer
+    iox.setPins(0xabcd);
+    simRuntime.runMicros(PERIOD_MICROS);
+    CHECK_EQ(inputRun.done, 11);
+    CHECK_EQ(inputRun.inputs[0], 0xcd);
+
+    // long read holds the bus for about 4.5ms, the 1ms request skips the periods it missed and keeps its run times
+    const time_t fastStart = sched_micros();
+    addRun(&twiController, &fastRun, IOX_I2C_ADDRESS(0), 1000);
+    simRuntime.runMicros(2500);
+    CHECK_EQ(fastRun.request.skipped, 0);
+    iox_rcv_data(twiController.getHandle(), IOX_I2C_ADDRESS(0), IOX_REG_INPUT_PORT0, longRead, sizeof(longRead));
+    simRuntime.runMicros(10000);
+    CHECK(fastRun.request.skipped >= 3);
+    CHECK_EQ(fastRun.request.runs + fastRun.request.skipped, (fastRun.request.nextMicros - fastStart) / 1000);
+    CHECK_EQ((fastRun.request.nextMicros - fastStart) % 1000, 0);
+    CHECK((int32_t) (fastRun.request.nextMicros - sched_micros()) <= 1000);
+    CHECK_EQ(fastRun.errors, 0);
+
+    // held requests do not start runs, the periods missed while held are skipped
+    const uint16_t heldSkipped = fastRun.request.skipped;
+    const uint16_t heldDone = fastRun.done;
+    CLI();
+    twiController.holdRequests();
+    SEI();
+    simRuntime.runMicros(5500);
+    CHECK_EQ(fastRun.done, heldDone);
+    CLI();
+    twiController.releaseRequests();
+    SEI();
+    simRuntime.runMicros(500);
+    CHECK_EQ(fastRun.done, heldDone + 1);
+    CHECK(fastRun.request.skipped >= heldSkipped + 4);
+
+    // a late run is not followed right away by another one
+    CHECK(fastRun.minInterval > 500);
+
+    // removed while due and held, the run is dropped and the other request keeps running
+    CLI();
+    twiController.holdRequests();
+    SEI();
+    simRuntime.runMicros(1500);
+    const uint16_t removedDone = fastRun.done;
+    CHECK(((ByteStream *) &fastRun.request.stream)->isPending());
+    CHECK(twiController.removeRepeatRequest(&fastRun.request));
+    CHECK(!((ByteStream *) &fastRun.request.stream)->isPending());
+    CHECK(!twiController.removeRepeatRequest(&fastRun.request));
+    CLI();
+    twiController.releaseRequests();
+    SEI();
+    const uint16_t inputDone = inputRun.done;
+    simRuntime.runMicros(3 * PERIOD_MICROS);
+    CHECK_EQ(fastRun.done, removedDone);
+    CHECK(inputRun.done >= inputDone + 2);
+
+    // soft controller runs its repeat request from the group's service
+    addRun(&softTwiController, &softRun, IOX_I2C_ADDRESS(2), PERIOD_MICROS);
+    simRuntime.runMicros(3 * PERIOD_MICROS - 100);
+    CHECK_EQ(softRun.done, 3);
+    CHECK_EQ(softRun.inputs[0], 0x78);
+    CHECK_EQ(softRun.inputs[1], 0x56);
+    CHECK_EQ(softRun.errors, 0);
+    CHECK(twiController.removeRepeatRequest(&inputRun.request));
+    CHECK(softTwiController.removeRepeatRequest(&softRun.request));
+
+    return test_result("test_repeat_request");
+}
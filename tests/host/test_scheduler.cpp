@@ -0,0 +1,145 @@
+/*
+ * Scheduler with 40 mostly idle tasks: only ready tasks run, in id order, sleeping tasks wake at their resume time
+ * across the clock wrap, suspend cancels a pending resume and the pass after a time slice ends continues with the
+ * next task. Built once with the default linear scan and once with SCHED_READY_BITMAP.
+ */
+
+#include "test_support.h"
+#include "Scheduler.h"
+
+#define TASK_COUNT      (40)
+
+char order[64];
+uint8_t nOrder;
+
+static void clearOrder() {
+    memset(order, 0, sizeof(order));
+    nOrder = 0;
+}
+
+class TestTask : public Task {
+public:
+    uint8_t again;          // resume(0) after loop(), otherwise suspend
+    time_t loopMicros;      // time taken by loop()
+    time_t lastRun;
+
+    void begin() override {
+    }
+
+    void loop() override {
+        // order holds task ids as printable characters, '0' + id
+        if (nOrder < sizeof(order) - 1) order[nOrder++] = (char) ('0' + getTaskId());
+        lastRun = sched_micros();
+        sched_clock_advance_micros(loopMicros);
+
+        if (again) {
+            resume(0);
+        } else {
+            suspend();
+        }
+    }
+
+    PGM_P id() override {
+        return PSTR("TestTask");
+    }
+};
+
+TestTask tasks[TASK_COUNT];
+Task *taskTable[TASK_COUNT];
+sched_time_t taskDelays[TASK_COUNT];
+
+#ifdef SCHED_READY_BITMAP
+uint8_t taskBitmaps[sizeOfSchedulerBitmaps(TASK_COUNT)];
+Scheduler scheduler(TASK_COUNT, (PGM_P) taskTable, taskDelays, taskBitmaps);
+#else
+Scheduler scheduler(TASK_COUNT, (PGM_P) taskTable, taskDelays);
+#endif
+
+// advance past SCHED_MIN_LOOP_TIMESLICE_MICROS so the pass is not skipped
+static void runPass(time_t advance, time_t timeSlice = 0) {
+    sched_clock_advance_micros(advance);
+    scheduler.loopMicros(timeSlice);
+}
+
+int main() {
+    for (uint8_t i = 0; i < TASK_COUNT; i++) {
+        taskTable[i] = &tasks[i];
+    }
+
+    // clock wraps while tasks 5 and 20 sleep
+    const time_t start = 0xffffffffUL - 700UL;
+    sched_clock_set_micros(start);
+    scheduler.begin();
+
+    for (uint8_t i = 0; i < TASK_COUNT; i++) {
+        CHECK(scheduler.isSuspended(&tasks[i]));
+    }
+
+    // ready tasks run once each, in id order, whatever order they were resumed in
+    scheduler.resumeMicros(39, 0);
+    scheduler.resumeMicros(3, 0);
+    scheduler.resumeMicros(17, 0);
+    scheduler.resumeMicros(7, 0);
+    scheduler.suspend(7);
+#ifdef SCHED_READY_BITMAP
+    CHECK(scheduler.isTaskReady(3));
+    CHECK(!scheduler.isTaskReady(7));
+    CHECK(!scheduler.isTaskReady(8));
+#endif
+    runPass(250);
+    CHECK_EQ(strcmp(order, "3AW"), 0);
+    runPass(250);
+    CHECK_EQ(strcmp(order, "3AW"), 0);
+
+    // sleeping tasks run when their delay elapses, not before
+    clearOrder();
+    scheduler.resumeMicros(5, 1000);
+    scheduler.resumeMicros(20, 500);
+    runPass(250);
+    CHECK_EQ(nOrder, 0);
+    runPass(250);
+    CHECK_EQ(strcmp(order, "D"), 0);
+    CHECK_EQ(tasks[20].lastRun, start + 1000);
+    runPass(250);
+    CHECK_EQ(strcmp(order, "D"), 0);
+    runPass(250);
+    CHECK_EQ(strcmp(order, "D5"), 0);
+    CHECK_EQ(tasks[5].lastRun, start + 1500);
+
+    // suspend cancels a pending resume
+    clearOrder();
+    scheduler.resumeMicros(9, 300);
+    scheduler.suspend(9);
+    runPass(250);
+    runPass(250);
+    CHECK_EQ(nOrder, 0);
+    CHECK(scheduler.isSuspended(&tasks[9]));
+
+    // task 10 ends the time slice, next pass starts with task 11 and wraps around to 2 and 10
+    clearOrder();
+    tasks[2].again = 1;
+    tasks[10].again = 1;
+    tasks[10].loopMicros = 600;
+    tasks[30].again = 1;
+    scheduler.resumeMicros(2, 0);
+    scheduler.resumeMicros(10, 0);
+    scheduler.resumeMicros(30, 0);
+    runPass(250, 500);
+    CHECK_EQ(strcmp(order, "2:"), 0);
+    runPass(250, 500);
+    CHECK_EQ(strcmp(order, "2:N2:"), 0);
+
+    // without a time slice all ready tasks run, starting where the last pass stopped
+    clearOrder();
+    tasks[10].loopMicros = 0;
+    runPass(250);
+    CHECK_EQ(strcmp(order, "N2:"), 0);
+    runPass(250);
+    CHECK_EQ(strcmp(order, "N2:2:N"), 0);
+
+#ifdef SCHED_READY_BITMAP
+    return test_result("test_scheduler_bitmap");
+#else
+    return test_result("test_scheduler");
+#endif
+}
@@ -0,0 +1,118 @@
+/*
+ * SimSpi bus behind SpiController, chip select routing, SPI mode, read buffer and transfer timing.
+ */
+
+#include "test_support.h"
+#include "SimSpi.h"
+#include "SpiController.h"
+#include "TwiController.h"
+
+ControllerStorage<4, 2, 32> spiStorage;
+SpiController spiController(spiStorage);
+
+ControllerStorage<4, 2, 32> twiStorage;
+TwiController twiController(twiStorage);
+
+// returns command + byte index for each byte after the command
+class CounterDevice : public SimSpiDevice {
+public:
+    uint8_t selects;
+    uint8_t mode;
+    uint8_t command;
+    uint8_t index;
+
+    explicit CounterDevice(uint8_t csPin) : SimSpiDevice(csPin), selects(0), mode(0), command(0), index(0) {}
+
+    void select(uint8_t mode) override {
+        this->mode = mode;
+        index = 0;
+        selects++;
+    }
+
+    uint8_t transfer(uint8_t data) override {
+        if (index++ == 0) {
+            command = data;
+            return 0;
+        }
+        return command + index;
+    }
+};
+
+CounterDevice devA(10);
+CounterDevice devB(9);
+
+uint8_t readData[3];
+uint8_t unmappedData[2];
+uint8_t done;
+
+class Producer : public Task {
+    uint8_t reserved;
+
+public:
+    Producer() : reserved(0) {}
+
+    void begin() override {
+        resume(0);
+    }
+
+    void loop() override {
+        if (!reserved && spiController.reserveResources(2, 4)) {
+            reserved = 1;
+            return;
+        }
+        reserved = 0;
+
+        ByteStream *pStream = spiController.getWriteStream();
+        pStream->setAddress(SPI_ADDRESS(9, SPI_MODE3));
+        pStream->put(0x40);
+        pStream->setRdBuffer(0, readData, sizeof(readData));
+        spiController.processStream(pStream);
+
+        pStream = spiController.getWriteStream();
+        pStream->setAddress(SPI_ADDRESS(4, SPI_MODE0));
+        pStream->put(0x11);
+        pStream->setRdBuffer(0, unmappedData, sizeof(unmappedData));
+        spiController.processStream(pStream);
+
+        spiController.releaseResources();
+        done++;
+        suspend();
+    }
+
+    PGM_P id() override {
+        return PSTR("Producer");
+    }
+};
+
+Producer producer;
+
+Task *taskTable[] = {&spiController, &producer};
+sched_time_t taskDelays[sizeof(taskTable) / sizeof(*taskTable)];
+Scheduler scheduler(sizeof(taskTable) / sizeof(*taskTable), (PGM_P) taskTable, taskDelays);
+
+int main() {
+    simSpi.addDevice(&devA);
+    simSpi.addDevice(&devB);
+
+    sched_clock_set_micros(0xffffffffUL - 100UL);
+    scheduler.begin();
+    simRuntime.begin();
+    simSpi.begin();
+    simRuntime.runMicros(20000);
+
+    CHECK_EQ(done, 1);
+    CHECK_EQ(devA.selects, 0);
+    CHECK_EQ(devB.selects, 1);
+    CHECK_EQ(devB.mode, SPI_MODE3);
+    CHECK_EQ(devB.command, 0x40);
+    CHECK_EQ(readData[0], 0x42);
+    CHECK_EQ(readData[1], 0x43);
+    CHECK_EQ(readData[2], 0x44);
+    CHECK_EQ(unmappedData[0], 0xff);
+    CHECK_EQ(unmappedData[1], 0xff);
+    CHECK_EQ(simSpi.getRequests(), 2);
+    CHECK_EQ(simSpi.getBytes(), 7);
+    CHECK(simSpi.getBusyMicros() > 0);
+
+    return test_result("test_sim_spi");
+}
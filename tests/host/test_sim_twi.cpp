@@ -0,0 +1,88 @@
+/*
+ * SimTwi bus with XL9535 and DAC53401 models behind TwiController, queued requests and twi_wait() busy waits.
+ */
+
+#include "test_support.h"
+#include "SimTwi.h"
+#include "TwiController.h"
+#include "CIOExpander.h"
+#include "CDac53401.h"
+
+ControllerStorage<8, 4, 64> twiStorage;
+TwiController twiController(twiStorage);
+
+SimXL9535 iox(IOX_I2C_ADDRESS(0));
+SimDac53401 dac(0x48);
+
+uint8_t inputPort0;
+uint8_t presentSent = 0xff;
+uint8_t absentSent = 0xff;
+time_t presentMicros;
+time_t absentMicros;
+
+class Waiter : public Task {
+public:
+    void begin() override {
+    }
+
+    void loop() override {
+        time_t start = sched_micros();
+        presentSent = iox_rcv_byte_wait(twiController.getHandle(), IOX_I2C_ADDRESS(0), IOX_REG_INPUT_PORT0, &inputPort0);
+        presentMicros = sched_micros() - start;
+
+        start = sched_micros();
+        absentSent = iox_rcv_byte_wait(twiController.getHandle(), IOX_I2C_ADDRESS(5), IOX_REG_INPUT_PORT0, &inputPort0);
+        absentMicros = sched_micros() - start;
+        suspend();
+    }
+
+    PGM_P id() override {
+        return PSTR("Waiter");
+    }
+};
+
+Waiter waiter;
+
+Task *taskTable[] = {&twiController, &waiter};
+sched_time_t taskDelays[sizeof(taskTable) / sizeof(*taskTable)];
+Scheduler scheduler(sizeof(taskTable) / sizeof(*taskTable), (PGM_P) taskTable, taskDelays);
+
+int main() {
+    simTwiBus.addDevice(&iox);
+    simTwiBus.addDevice(&dac);
+    iox.setPins(0x00a5);
+
+    // start with the virtual clock just before it wraps
+    sched_clock_set_micros(0xffffffffUL - 50000UL);
+    scheduler.begin();
+    simRuntime.begin();
+    simTwiBus.begin();
+
+    // queued writes
+    iox_send_word(twiController.getHandle(), IOX_I2C_ADDRESS(0), IOX_REG_CONFIGURATION_PORT0, 0x00f0);
+    iox_out(twiController.getHandle(), IOX_I2C_ADDRESS(0), 0x1234);
+    dac_write(twiController.getHandle(), 0x48, REG_DATA, WR_DATA_DAC(0x155));
+    simRuntime.runMicros(10000);
+
+    CHECK_EQ(iox.getConfiguration(), 0x00f0);
+    CHECK_EQ(iox.getOutputs(), 0x1234 & ~0x00f0);
+    CHECK_EQ(dac.getDataCode(), 0x155);
+    CHECK_EQ(simTwiBus.getRequests(), 3);
+    CHECK_EQ(simTwiBus.getNacks(), 0);
+    CHECK(simTwiBus.getBusyMicros() > 0);
+
+    // busy waits across the clock wrap, absent device is NACKed
+    waiter.resume(0);
+    simRuntime.runMicros(100000);
+
+    CHECK_EQ(presentSent, 1);
+    // port 0 low nibble is output 0x4, high nibble input pins 0xa
+    CHECK_EQ(inputPort0, 0xa4);
+    CHECK(presentMicros > 0 && presentMicros < 1000);
+    CHECK_EQ(absentSent, 0);
+    CHECK(simTwiBus.getNacks() > 0);
+    CHECK(absentMicros < 1000);
+    CHECK(sched_micros() < 0xffffffffUL - 50000UL);
+
+    return test_result("test_sim_twi");
+}
@@ -0,0 +1,80 @@
+/*
+ * SimUart behind UartController, output capture, flow control through reserveResources() and baud rate timing.
+ */
+
+#include "test_support.h"
+#include "SimUart.h"
+#include "UartController.h"
+#include "TwiController.h"
+
+ControllerStorage<4, 2, 32> uartStorage;
+UartController uartController(uartStorage);
+
+ControllerStorage<4, 2, 32> twiStorage;
+TwiController twiController(twiStorage);
+
+uint16_t lines;
+
+class Producer : public Task {
+    uint8_t reserved;
+
+public:
+    Producer() : reserved(0) {}
+
+    void begin() override {
+        resume(0);
+    }
+
+    void loop() override {
+        if (!reserved && uartController.reserveResources(1, 12)) {
+            reserved = 1;
+            return;
+        }
+        reserved = 0;
+
+        ByteStream *pStream = uartController.getWriteStream();
+        char buffer[16];
+        const int length = snprintf(buffer, sizeof(buffer), "line %03u\n", lines++);
+        for (int i = 0; i < length; i++) {
+            pStream->put(buffer[i]);
+        }
+        uartController.processStream(pStream);
+        uartController.releaseResources();
+        resumeMicros(100);
+    }
+
+    PGM_P id() override {
+        return PSTR("Producer");
+    }
+};
+
+Producer producer;
+
+Task *taskTable[] = {&uartController, &producer};
+sched_time_t taskDelays[sizeof(taskTable) / sizeof(*taskTable)];
+Scheduler scheduler(sizeof(taskTable) / sizeof(*taskTable), (PGM_P) taskTable, taskDelays);
+
+int main() {
+    sched_clock_set_micros(0xffffffffUL - 5000UL);
+    scheduler.begin();
+    simRuntime.begin();
+    simUart.begin();
+    simUart.setBaud(115200);
+
+    simRuntime.runMicros(20000);
+    producer.suspend();
+    simRuntime.runMicros(20000);
+
+    // 9 bytes per line at 86.8us per byte, about 780us per line regardless of producer rate
+    const char *pOutput = simUart.getOutput();
+    const size_t length = strlen(pOutput);
+    CHECK(lines > 20 && lines < 30);
+    CHECK_EQ(simUart.getRequests(), lines);
+    CHECK_EQ(simUart.getBytes(), lines * 9);
+    CHECK_EQ(length, lines * 9);
+    CHECK(strncmp(pOutput, "line 000\nline 001\n", 18) == 0);
+    CHECK(simUart.getBusyMicros() >= (sim_time_t) lines * 9 * 86);
+    CHECK(!simUart.isBusy());
+
+    return test_result("test_sim_uart");
+}
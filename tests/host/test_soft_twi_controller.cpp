@@ -0,0 +1,83 @@
+/*
+ * SoftTwiController on its own SimTwiBus, requests are transferred by service() and not from processStream() or
+ * the completion of the previous request.
+ */
+
+#include "test_support.h"
+#include "SimTwi.h"
+#include "TwiController.h"
+#include "SoftTwiController.h"
+#include "CIOExpander.h"
+
+ControllerStorage<4, 2, 32> twiStorage;
+TwiController twiController(twiStorage);
+
+ControllerStorage<4, 2, 32> softStorage;
+SoftTwiController softTwiController(softStorage, 4, 5);
+
+SimTwiBus softBus;
+SimXL9535 iox(IOX_I2C_ADDRESS(2));
+
+uint8_t presentSent = 0xff;
+uint8_t absentSent = 0xff;
+uint16_t inputs;
+
+class Waiter : public Task {
+public:
+    void begin() override {
+    }
+
+    void loop() override {
+        presentSent = iox_in_wait(softTwiController.getHandle(), IOX_I2C_ADDRESS(2), &inputs);
+        absentSent = iox_in_wait(softTwiController.getHandle(), IOX_I2C_ADDRESS(6), &inputs);
+        suspend();
+    }
+
+    PGM_P id() override {
+        return PSTR("Waiter");
+    }
+};
+
+Waiter waiter;
+
+Task *taskTable[] = {&twiController, &softTwiController, &waiter};
+sched_time_t taskDelays[sizeof(taskTable) / sizeof(*taskTable)];
+Scheduler scheduler(sizeof(taskTable) / sizeof(*taskTable), (PGM_P) taskTable, taskDelays);
+
+int main() {
+    softBus.setBitRate(80000);
+    softBus.addDevice(&iox);
+    softTwiController.setSimBus(&softBus);
+    iox.setPins(0x5a00);
+
+    scheduler.begin();
+    simRuntime.begin();
+    softBus.begin();
+
+    iox_send_word(softTwiController.getHandle(), IOX_I2C_ADDRESS(2), IOX_REG_CONFIGURATION_PORT0, 0xff00);
+    iox_out(softTwiController.getHandle(), IOX_I2C_ADDRESS(2), 0x0011);
+    iox_out(softTwiController.getHandle(), IOX_I2C_ADDRESS(2), 0x0022);
+
+    // nothing is transferred until the controller's task runs
+    CHECK_EQ(softBus.getRequests(), 0);
+    CHECK(!softTwiController.isProcessingRequest());
+
+    simRuntime.runMicros(10000);
+
+    CHECK_EQ(softBus.getRequests(), 3);
+    CHECK_EQ(iox.getConfiguration(), 0xff00);
+    CHECK_EQ(iox.getOutputs(), 0x0022);
+    CHECK_EQ(softTwiController.requestCapacity(), 4);
+    CHECK(!softTwiController.isProcessingRequest());
+
+    // twi_wait_sent() services the controller while it waits
+    waiter.resume(0);
+    simRuntime.runMicros(100000);
+
+    CHECK_EQ(presentSent, 1);
+    CHECK_EQ(inputs & 0xff00, 0x5a00);
+    CHECK_EQ(absentSent, 0);
+    CHECK_EQ(softBus.getRequests(), 5);
+
+    return test_result("test_soft_twi_controller");
+}
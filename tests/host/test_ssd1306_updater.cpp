@@ -0,0 +1,110 @@
+/*
+ * Ssd1306Updater sends the whole frame after init(), then only the changed column span of each dirty page: marks on
+ * one page merge into one span, rectangles spanning pages send each page and marks are clipped to the display.
+ */
+
+#include "test_support.h"
+#include "SimTwi.h"
+#include "TwiController.h"
+#include "Ssd1306Updater.h"
+
+#define WIDTH           (128)
+#define PAGES           (8)
+#define RUN_MICROS      (100000L)   // past the 20ms after which the controller frees completed requests
+
+ControllerStorage<4, 2, 32> twiStorage;
+TwiController twiController(twiStorage);
+
+SimSsd1306 simDisplay(SSD1306_I2C_ADDRESS);
+Ssd1306Updater displayUpdater;
+
+uint8_t frame[PAGES * WIDTH];
+
+Task *taskTable[] = {&twiController, &displayUpdater};
+sched_time_t taskDelays[sizeof(taskTable) / sizeof(*taskTable)];
+Scheduler scheduler(sizeof(taskTable) / sizeof(*taskTable), (PGM_P) taskTable, taskDelays);
+
+// display RAM bytes which differ from the frame buffer
+static uint16_t frameDiffs() {
+    uint16_t diffs = 0;
+    for (uint8_t p = 0; p < PAGES; p++) {
+        const uint8_t *pRam = simDisplay.getPage(p);
+        for (uint8_t x = 0; x < WIDTH; x++) {
+            if (pRam[x] != frame[p * WIDTH + x]) diffs++;
+        }
+    }
+    return diffs;
+}
+
+static void draw(uint8_t x0, uint8_t page, uint8_t x1, uint8_t value) {
+    for (uint8_t x = x0; x <= x1; x++) {
+        frame[page * WIDTH + x] = value;
+    }
+}
+
+int main() {
+    simTwiBus.addDevice(&simDisplay);
+
+    for (uint16_t i = 0; i < sizeof(frame); i++) {
+        frame[i] = i * 7 + 1;
+    }
+
+    sched_clock_set_micros(0xffffffffUL - 50000UL);
+    scheduler.begin();
+    simRuntime.begin();
+
+    // whole frame after init
+    displayUpdater.init(&twiController, frame);
+    CHECK(displayUpdater.isDirty());
+    simRuntime.runMicros(RUN_MICROS);
+    CHECK(!displayUpdater.isDirty());
+    CHECK(!displayUpdater.isSending());
+    CHECK_EQ(displayUpdater.getPagesSent(), PAGES);
+    CHECK_EQ(displayUpdater.getBytesSent(), PAGES * (SSD1306_PAGE_HEADER + WIDTH));
+    CHECK_EQ(simDisplay.getDataBytes(), PAGES * WIDTH);
+    CHECK_EQ(frameDiffs(), 0);
+
+    // changed span of one page
+    draw(10, 2, 19, 0x55);
+    displayUpdater.markDirty(10, 16, 19, 23);
+    simRuntime.runMicros(RUN_MICROS);
+    CHECK_EQ(displayUpdater.getPagesSent(), PAGES + 1);
+    CHECK_EQ(simDisplay.getDataBytes(), PAGES * WIDTH + 10);
+    CHECK_EQ(frameDiffs(), 0);
+
+    // two marks on a page merge into the span covering both, the page is sent once
+    draw(5, 4, 9, 0x11);
+    draw(30, 4, 34, 0x22);
+    displayUpdater.markDirty(5, 32, 9, 33);
+    displayUpdater.markDirty(30, 39, 34, 39);
+    simRuntime.runMicros(RUN_MICROS);
+    CHECK_EQ(displayUpdater.getPagesSent(), PAGES + 2);
+    CHECK_EQ(simDisplay.getDataBytes(), PAGES * WIDTH + 10 + 30);
+    CHECK_EQ(frameDiffs(), 0);
+
+    // rectangle across pages 5 to 7 sends each of them
+    draw(100, 5, 103, 0x33);
+    draw(100, 6, 103, 0x33);
+    draw(100, 7, 103, 0x33);
+    displayUpdater.markDirty(100, 44, 103, 60);
+    simRuntime.runMicros(RUN_MICROS);
+    CHECK_EQ(displayUpdater.getPagesSent(), PAGES + 5);
+    CHECK_EQ(simDisplay.getDataBytes(), PAGES * WIDTH + 10 + 30 + 12);
+    CHECK_EQ(frameDiffs(), 0);
+
+    // marks outside the display are ignored, partly outside are clipped
+    displayUpdater.markDirty(WIDTH, 0, WIDTH + 10, 7);
+    displayUpdater.markDirty(0, PAGES * 8, 10, PAGES * 8 + 5);
+    displayUpdater.markDirty(10, 5, 5, 7);
+    CHECK(!displayUpdater.isDirty());
+    draw(0, 0, 3, 0x44);
+    draw(WIDTH - 2, 7, WIDTH - 1, 0x66);
+    displayUpdater.markDirty(-5, -5, 3, 3);
+    displayUpdater.markDirty(WIDTH - 2, 60, WIDTH + 20, 100);
+    simRuntime.runMicros(RUN_MICROS);
+    CHECK_EQ(displayUpdater.getPagesSent(), PAGES + 7);
+    CHECK_EQ(simDisplay.getDataBytes(), PAGES * WIDTH + 10 + 30 + 12 + 4 + 2);
+    CHECK_EQ(frameDiffs(), 0);
+
+    return test_result("test_ssd1306_updater");
+}
@@ -0,0 +1,162 @@
+/*
+ * StaticScheduler dispatch order, resume timing across the clock wrap, StaticAsyncTask yield and resume, and
+ * continuing after the task which ended the time slice.
+ */
+
+#include "test_support.h"
+#include "StaticScheduler.h"
+
+char order[32];
+uint8_t nOrder;
+
+static void ran(char id) {
+    if (nOrder < sizeof(order) - 1) order[nOrder++] = id;
+}
+
+static void clearOrder() {
+    memset(order, 0, sizeof(order));
+    nOrder = 0;
+}
+
+class Ticker : public StaticTask<Ticker> {
+public:
+    uint16_t runs;
+
+    void begin() {
+        resume(0);
+    }
+
+    void loop() {
+        runs++;
+        ran('T');
+        resumeMicros(1000);
+    }
+} ticker;
+
+// takes 600us of the time slice per run
+class Hog : public StaticTask<Hog> {
+public:
+    void begin() {
+    }
+
+    void loop() {
+        ran('H');
+        sched_clock_advance_micros(600);
+        resume(0);
+    }
+} hog;
+
+class Sleeper : public StaticTask<Sleeper> {
+public:
+    uint16_t runs;
+
+    void begin() {
+    }
+
+    void loop() {
+        runs++;
+        ran('S');
+        suspend();
+    }
+} sleeper;
+
+uint8_t yielderStack[sizeOfStack(64)];
+
+class Yielder : public StaticAsyncTask<Yielder> {
+public:
+    time_t yieldedAt;
+    time_t resumedAt;
+
+    Yielder() : StaticAsyncTask(yielderStack, sizeof(yielderStack)) {
+    }
+
+    void begin() {
+        resume(0);
+    }
+
+    void loop() {
+        ran('A');
+        yieldedAt = sched_micros();
+        yieldResumeMicros(2000);
+        resumedAt = sched_micros();
+        ran('B');
+        suspend();
+    }
+} yielder;
+
+typedef StaticScheduler<staticTaskEntry(ticker), staticTaskEntry(hog), staticTaskEntry(sleeper), staticTaskEntry(yielder)> TestScheduler;
+
+TestScheduler staticScheduler;
+
+// Task code of the library refers to the global scheduler, static tasks do not use it
+Scheduler scheduler(0, NULL, NULL);
+
+// advance past SCHED_MIN_LOOP_TIMESLICE_MICROS so the pass is not skipped
+static void runPass(time_t advance, time_t timeSlice = 0) {
+    sched_clock_advance_micros(advance);
+    staticScheduler.loopMicros(timeSlice);
+}
+
+int main() {
+    // clock wraps between the yield and the resume of yielder
+    const time_t start = 0xffffffffUL - 1500UL;
+    sched_clock_set_micros(start);
+    staticScheduler.begin();
+
+    CHECK_EQ(TestScheduler::getTaskCount(), 4);
+    CHECK_EQ(TestScheduler::getTaskId<staticTaskEntry(sleeper)>(), 2);
+    CHECK_EQ(TestScheduler::getTaskId<staticTaskEntry(yielder)>(), 3);
+    CHECK(!TestScheduler::isAsyncTask(0));
+    CHECK(TestScheduler::isAsyncTask(3));
+    CHECK(hog.isSuspended());
+    CHECK(sleeper.isSuspended());
+
+    // ready tasks run in list order, yielder yields in the middle of its loop()
+    runPass(250);
+    CHECK_EQ(strcmp(order, "TA"), 0);
+    CHECK(yielder.hasYielded());
+    CHECK_EQ(yielder.yieldedAt, start + 250);
+
+    runPass(1000);
+    runPass(999);
+    CHECK_EQ(strcmp(order, "TAT"), 0);
+    CHECK(yielder.hasYielded());
+
+    // yielder resumes after its loop() yield, not from the start of loop()
+    runPass(251);
+    CHECK_EQ(strcmp(order, "TATTB"), 0);
+    CHECK_EQ(yielder.resumedAt, start + 2500);
+    CHECK(!yielder.hasYielded());
+    CHECK(yielder.isSuspended());
+    CHECK_EQ(ticker.runs, 3);
+
+    // suspended task runs once after its resume delay
+    clearOrder();
+    sleeper.resumeMicros(300);
+    runPass(250);
+    CHECK_EQ(sleeper.runs, 0);
+    runPass(250);
+    CHECK_EQ(sleeper.runs, 1);
+    CHECK_EQ(strcmp(order, "S"), 0);
+    CHECK(sleeper.isSuspended());
+
+    // hog ends the time slice, next pass continues with sleeper and yielder before ticker and hog
+    clearOrder();
+    ticker.resume(0);
+    hog.resume(0);
+    yielder.resume(0);
+    runPass(250, 500);
+    CHECK_EQ(strcmp(order, "TH"), 0);
+    runPass(250, 500);
+    CHECK_EQ(strcmp(order, "THAH"), 0);
+    CHECK(yielder.hasYielded());
+
+    // hog ended the slice again, the pass starts after it
+    clearOrder();
+    hog.suspend();
+    sleeper.resume(0);
+    runPass(250);
+    CHECK_EQ(strcmp(order, "ST"), 0);
+
+    return test_result("test_static_scheduler");
+}
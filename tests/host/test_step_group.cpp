@@ -0,0 +1,153 @@
+/*
+ * CStepGroup Bresenham interpolation: each axis takes its steps spread over the ticks of the longest axis, in its
+ * direction, and every tick sends one output write per expander with due axes, combining the expander's motor and a
+ * motor with its own phase table on the same expander. INT16_MIN deltas are clamped.
+ */
+
+#include "test_support.h"
+#include "SimTwi.h"
+#include "TwiController.h"
+#include "CStepGroup.h"
+
+#define AXES            (4)
+#define TICK_MICROS     (25000L)    // past the 20ms after which the controller frees completed requests
+
+ControllerStorage<8, 2, 64> twiStorage;
+TwiController twiController(twiStorage);
+
+SimXL9535 simIox0(IOX_I2C_ADDRESS(0));
+SimXL9535 simIox1(IOX_I2C_ADDRESS(1));
+CIOExpander_t iox0;
+CIOExpander_t iox1;
+CApmStepper_t apm;
+CStepGroup_t group;
+
+// second motor on iox0 LED outputs
+const uint8_t ledPhases[4] PROGMEM = {IOX_OUT_LED_RED, IOX_OUT_LED_GREEN, IOX_OUT_LED_BLUE, IOX_OUT_LED_RED | IOX_OUT_LED_BLUE};
+
+uint16_t writes0;
+uint16_t writes1;
+
+static void stepDone(const CByteStream_t *pStream, CIOExpander_t *pIox) {
+    if (pIox == &iox0) writes0++;
+    if (pIox == &iox1) writes1++;
+}
+
+Task *taskTable[] = {&twiController};
+sched_time_t taskDelays[sizeof(taskTable) / sizeof(*taskTable)];
+Scheduler scheduler(sizeof(taskTable) / sizeof(*taskTable), (PGM_P) taskTable, taskDelays);
+
+// phase of each axis, in the order added
+static void getPhases(uint8_t *pPhases) {
+    pPhases[0] = IOX_FLAGS_TO_STEPPER_PHASE(iox0.flags);
+    pPhases[1] = STG_FLAGS_TO_PHASE(group.axes[1].flags);
+    pPhases[2] = IOX_FLAGS_TO_STEPPER_PHASE(iox1.flags);
+    pPhases[3] = APM_FLAGS_TO_STEPPER_PHASE(apm.flags);
+}
+
+static void runMove(const int16_t *pDeltas, uint16_t expectedTicks) {
+    uint16_t steps[AXES];
+    uint16_t misplaced = 0;
+    uint16_t wrongDir = 0;
+    uint16_t wrongWrites = 0;
+    uint8_t phases[AXES];
+    uint8_t lastPhases[AXES];
+
+    memset(steps, 0, sizeof(steps));
+    getPhases(lastPhases);
+
+    const uint16_t ticks = stg_move(&group, pDeltas);
+    CHECK_EQ(ticks, expectedTicks);
+
+    for (uint16_t tick = 1; tick <= ticks; tick++) {
+        const uint16_t lastWrites0 = writes0;
+        const uint16_t lastWrites1 = writes1;
+
+        CHECK_EQ(stg_step(&group), ticks - tick);
+        simRuntime.runMicros(TICK_MICROS);
+        getPhases(phases);
+
+        for (uint8_t i = 0; i < AXES; i++) {
+            if (phases[i] == lastPhases[i]) continue;
+
+            steps[i]++;
+            if (((lastPhases[i] + (pDeltas[i] < 0 ? -1 : 1)) & 3) != phases[i]) wrongDir++;
+        }
+
+        // centered Bresenham, steps after this tick
+        for (uint8_t i = 0; i < AXES; i++) {
+            const uint32_t absDelta = pDeltas[i] < 0 ? -pDeltas[i] : pDeltas[i];
+            if (steps[i] != ((uint32_t) tick * absDelta + (ticks >> 1)) / ticks) misplaced++;
+        }
+
+        // one write for iox0 if either of its axes stepped
+        if (writes0 - lastWrites0 != (phases[0] != lastPhases[0] || phases[1] != lastPhases[1])) wrongWrites++;
+        if (writes1 - lastWrites1 != (phases[2] != lastPhases[2])) wrongWrites++;
+
+        memcpy(lastPhases, phases, sizeof(lastPhases));
+    }
+
+    CHECK(stg_is_done(&group));
+    CHECK_EQ(stg_step(&group), 0);
+    CHECK_EQ(misplaced, 0);
+    CHECK_EQ(wrongDir, 0);
+    CHECK_EQ(wrongWrites, 0);
+}
+
+int main() {
+    simTwiBus.addDevice(&simIox0);
+    simTwiBus.addDevice(&simIox1);
+
+    sched_clock_set_micros(0xffffffffUL - 100000UL);
+    scheduler.begin();
+    simRuntime.begin();
+    ciox_init(&iox0, twiController.getHandle(), 0, 0);
+    ciox_init(&iox1, twiController.getHandle(), 1, 0);
+    iox0.fStepCallback = stepDone;
+    iox1.fStepCallback = stepDone;
+    capm_init(&apm, 2, 3, 4, 5);
+    simRuntime.runMicros(TICK_MICROS);
+    const uint32_t initRequests = simTwiBus.getRequests();
+
+    stg_init(&group);
+    CHECK_EQ(stg_add_iox(&group, &iox0, NULL), 0);
+    CHECK_EQ(stg_add_iox(&group, &iox0, ledPhases), 1);
+    CHECK_EQ(stg_add_iox(&group, &iox1, NULL), 2);
+    CHECK_EQ(stg_add_apm(&group, &apm), 3);
+    CHECK_EQ(stg_add_apm(&group, &apm), STG_NO_AXIS);
+
+    // major axis steps every tick, the others spread over the move
+    const int16_t move1[AXES] = {400, -200, 133, -57};
+    runMove(move1, 400);
+    CHECK_EQ(writes0, 400);
+    CHECK_EQ(writes1, 133);
+    CHECK_EQ(simTwiBus.getRequests() - initRequests, 400 + 133);
+
+    // iox0 outputs combine the expander motor phase with the LED motor phase
+    const uint8_t ledPhase = STG_FLAGS_TO_PHASE(group.axes[1].flags);
+    CHECK_EQ(ledPhase, (uint8_t) -200 & 3);
+    CHECK_EQ(iox0.outputs & (IOX_OUT_LED | IOX_OUT_MOT_EN), pgm_read_byte(ledPhases + ledPhase) | IOX_OUT_MOT_EN);
+
+    // major axis on the other expander, idle axis and odd ticks
+    writes0 = 0;
+    writes1 = 0;
+    const int16_t move2[AXES] = {-3, 0, -7, 7};
+    runMove(move2, 7);
+    CHECK_EQ(writes0, 3);
+    CHECK_EQ(writes1, 7);
+
+    // no steps
+    const int16_t move3[AXES] = {0, 0, 0, 0};
+    CHECK_EQ(stg_move(&group, move3), 0);
+    CHECK(stg_is_done(&group));
+    CHECK_EQ(stg_step(&group), 0);
+
+    // INT16_MIN is taken as -32767, not overflowed to 32768 steps
+    const int16_t move4[AXES] = {INT16_MIN, INT16_MAX, 0, 1};
+    CHECK_EQ(stg_move(&group, move4), INT16_MAX);
+    CHECK_EQ(group.axes[0].steps, INT16_MAX);
+    CHECK(group.axes[0].flags & STG_AXIS_FLAGS_CCW);
+    CHECK(!(group.axes[1].flags & STG_AXIS_FLAGS_CCW));
+
+    return test_result("test_step_group");
+}
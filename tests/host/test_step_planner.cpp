@@ -0,0 +1,126 @@
+/*
+ * stp_plan() and stp_next_interval(): first interval, ramp up and its exact mirror on the ramp down, cruise at the
+ * ramp end interval, short moves with odd and even step counts which ramp up for half the move, S-curve ramps and
+ * moves of 0 to 2 steps.
+ */
+
+#include "test_support.h"
+#include "Scheduler.h"
+#include "CStepPlanner.h"
+
+#define ACCEL           (2000)
+#define MIN_MICROS      (1000)
+#define FIRST_MICROS    (21377)     // 0.676 * sqrt(2 / ACCEL) s
+#define MAX_STEPS       (1000)
+
+// Task code of the library refers to the global scheduler
+Scheduler scheduler(0, NULL, NULL);
+
+time_t intervals[MAX_STEPS];
+uint16_t nIntervals;
+
+static void runPlan(uint8_t profile, uint16_t steps, uint16_t accel, time_t minStepMicros, CStepPlanner_t *pPlan) {
+    stp_plan(pPlan, profile, steps, accel, minStepMicros);
+    nIntervals = 0;
+
+    time_t interval;
+    while ((interval = stp_next_interval(pPlan)) && nIntervals < MAX_STEPS) {
+        intervals[nIntervals++] = interval;
+    }
+    CHECK(stp_is_done(pPlan));
+    CHECK_EQ(stp_next_interval(pPlan), 0);
+}
+
+// ramp down intervals equal the ramp up intervals in reverse
+static void checkMirror() {
+    uint16_t mismatched = 0;
+    for (uint16_t i = 0; i < nIntervals; i++) {
+        if (intervals[i] != intervals[nIntervals - 1 - i]) mismatched++;
+    }
+    CHECK_EQ(mismatched, 0);
+}
+
+// ramp up does not slow down and ramp down does not speed up
+static void checkRamps(time_t minStepMicros) {
+    uint16_t faster = 0;
+    uint16_t belowMin = 0;
+    for (uint16_t i = 1; i < nIntervals; i++) {
+        if (i <= nIntervals / 2 ? intervals[i] > intervals[i - 1] : intervals[i] < intervals[i - 1]) faster++;
+        if (intervals[i] < minStepMicros) belowMin++;
+    }
+    CHECK_EQ(faster, 0);
+    CHECK_EQ(belowMin, 0);
+}
+
+int main() {
+    CStepPlanner_t plan;
+
+    // long trapezoid move, 250 step ramps and cruise between them
+    runPlan(STP_PROFILE_TRAPEZOID, 1000, ACCEL, MIN_MICROS, &plan);
+    CHECK_EQ(plan.rampSteps, 250);
+    CHECK_EQ(nIntervals, 999);
+    CHECK_EQ(intervals[0], FIRST_MICROS);
+    CHECK(intervals[1] < intervals[0]);
+    checkMirror();
+    checkRamps(MIN_MICROS);
+    // recurrence ends within 1% of the cruise interval, cruise keeps the last ramp interval
+    CHECK(intervals[249] <= MIN_MICROS + MIN_MICROS / 100);
+    for (uint16_t i = 250; i < 749; i++) {
+        CHECK_EQ(intervals[i], intervals[249]);
+    }
+
+    // short odd move ramps for half the intervals each, the two middle intervals at ramp end speed
+    runPlan(STP_PROFILE_TRAPEZOID, 101, ACCEL, MIN_MICROS, &plan);
+    CHECK_EQ(plan.rampSteps, 50);
+    CHECK_EQ(nIntervals, 100);
+    CHECK_EQ(intervals[0], FIRST_MICROS);
+    checkMirror();
+    checkRamps(MIN_MICROS);
+    CHECK_EQ(intervals[49], intervals[50]);
+    CHECK(intervals[49] > 2 * MIN_MICROS);
+
+    // short even move has one more interval at ramp end speed in the middle
+    runPlan(STP_PROFILE_TRAPEZOID, 100, ACCEL, MIN_MICROS, &plan);
+    CHECK_EQ(plan.rampSteps, 49);
+    CHECK_EQ(nIntervals, 99);
+    checkMirror();
+    checkRamps(MIN_MICROS);
+    CHECK_EQ(intervals[48], intervals[49]);
+    CHECK_EQ(intervals[49], intervals[50]);
+    CHECK(intervals[47] > intervals[48]);
+
+    // S-curve ramps are 1.5 times longer, start slow and reach the cruise interval
+    runPlan(STP_PROFILE_SCURVE, 1000, ACCEL, MIN_MICROS, &plan);
+    CHECK_EQ(plan.rampSteps, 375);
+    CHECK_EQ(nIntervals, 999);
+    CHECK(intervals[0] >= FIRST_MICROS);
+    checkMirror();
+    checkRamps(MIN_MICROS);
+    CHECK_EQ(intervals[375], MIN_MICROS);
+    CHECK_EQ(intervals[499], MIN_MICROS);
+
+    // short S-curve move peaks at the reachable speed, not the cruise speed
+    runPlan(STP_PROFILE_SCURVE, 101, ACCEL, MIN_MICROS, &plan);
+    CHECK_EQ(plan.rampSteps, 50);
+    checkMirror();
+    checkRamps(MIN_MICROS);
+    CHECK(intervals[50] > 2 * MIN_MICROS);
+
+    // cruise interval is clamped to 100us
+    runPlan(STP_PROFILE_TRAPEZOID, 1000, 60000, 10, &plan);
+    CHECK_EQ(plan.minDelay >> STP_DELAY_SHIFT, 100);
+    checkRamps(100);
+
+    // 2 steps have one interval, 1 and 0 steps none
+    runPlan(STP_PROFILE_TRAPEZOID, 2, ACCEL, MIN_MICROS, &plan);
+    CHECK_EQ(nIntervals, 1);
+    CHECK_EQ(intervals[0], FIRST_MICROS);
+    runPlan(STP_PROFILE_TRAPEZOID, 1, ACCEL, MIN_MICROS, &plan);
+    CHECK_EQ(nIntervals, 0);
+    CHECK_EQ(plan.step, 1);
+    runPlan(STP_PROFILE_SCURVE, 0, ACCEL, MIN_MICROS, &plan);
+    CHECK_EQ(nIntervals, 0);
+    CHECK_EQ(plan.step, 0);
+
+    return test_result("test_step_planner");
+}
@@ -0,0 +1,118 @@
+/*
+ * StepQueue step timing on the SimTwi bus with competing TWI traffic, steps due now or in the past and the virtual
+ * clock wrapping while steps are queued.
+ */
+
+#include "test_support.h"
+#include "SimTwi.h"
+#include "TwiController.h"
+#include "StepQueue.h"
+#include "CIOExpander.h"
+
+#define STEP_MICROS     (1733)
+#define MAX_STEPS       (200)
+
+ControllerStorage<32, 2, 200> twiStorage;
+TwiController twiController(twiStorage);
+
+StepQueue stepQueue;
+
+SimXL9535 stepIox(IOX_I2C_ADDRESS(0));
+SimXL9535 otherIox(IOX_I2C_ADDRESS(1));
+CIOExpander_t iox;
+
+time_t stepTimes[MAX_STEPS];
+uint16_t stepsAdded;
+uint16_t stepsDone;
+int32_t maxEarly;
+int32_t maxLate;
+uint8_t lastPhases;
+uint16_t repeatedPhases;
+uint16_t otherRequests;
+
+static void stepDone(const CByteStream_t *pStream, CIOExpander_t *pIox) {
+    // outputs change when the request completes, latency compensation aims that at the step time
+    const int32_t error = (int32_t) (sched_micros() - stepTimes[stepsDone++]);
+    if (maxEarly > error) maxEarly = error;
+    if (maxLate < error) maxLate = error;
+
+    const uint8_t phases = stepIox.getOutputs() & IOX_OUT_MOT_PHASES;
+    if (phases == lastPhases) repeatedPhases++;
+    lastPhases = phases;
+}
+
+class Producer : public Task {
+public:
+    void begin() override {
+        resume(0);
+    }
+
+    void loop() override {
+        if (twiController.requestCapacity() >= 2 && twiController.byteCapacity() > 8) {
+            iox_out(twiController.getHandle(), IOX_I2C_ADDRESS(1), 0x1200 + (otherRequests++ & 0xff));
+        }
+        resumeMicros(50);
+    }
+
+    PGM_P id() override {
+        return PSTR("Producer");
+    }
+};
+
+class Stepper : public Task {
+    time_t nextStep;
+
+public:
+    void begin() override {
+        // first step is already due
+        nextStep = sched_micros();
+        resume(0);
+    }
+
+    void loop() override {
+        while (stepsAdded < MAX_STEPS && stepQueue.getCapacity()) {
+            stepTimes[stepsAdded++] = nextStep;
+            stepQueue.add(nextStep, 0);
+            nextStep += STEP_MICROS;
+        }
+        resumeMicros(5000);
+    }
+
+    PGM_P id() override {
+        return PSTR("Stepper");
+    }
+};
+
+Producer producer;
+Stepper stepper;
+
+Task *taskTable[] = {&twiController, &producer, &stepper};
+sched_time_t taskDelays[sizeof(taskTable) / sizeof(*taskTable)];
+Scheduler scheduler(sizeof(taskTable) / sizeof(*taskTable), (PGM_P) taskTable, taskDelays);
+
+int main() {
+    simTwiBus.addDevice(&stepIox);
+    simTwiBus.addDevice(&otherIox);
+
+    // clock wraps about 100ms into the test
+    sched_clock_set_micros(0xffffffffUL - 100000UL);
+    scheduler.begin();
+    simRuntime.begin();
+    ciox_init(&iox, twiController.getHandle(), 0, 0);
+    iox.fStepCallback = stepDone;
+    stepQueue.begin(&iox);
+
+    simRuntime.runMicros((sim_time_t) MAX_STEPS * STEP_MICROS + 10000);
+
+    CHECK_EQ(stepsAdded, MAX_STEPS);
+    CHECK_EQ(stepsDone, MAX_STEPS);
+    CHECK_EQ(stepQueue.getSteps(), MAX_STEPS);
+    CHECK(stepQueue.isEmpty());
+    CHECK_EQ(repeatedPhases, 0);
+    CHECK(otherRequests > MAX_STEPS);
+    CHECK(maxEarly > -(int32_t) STEP_QUEUE_LOOKAHEAD_MICROS);
+    CHECK(maxLate < (int32_t) STEP_QUEUE_LOOKAHEAD_MICROS);
+    printf("steps %u late %u error %ld..%ld us\n", stepsDone, stepQueue.getLateSteps(), (long) maxEarly, (long) maxLate);
+
+    return test_result("test_step_queue");
+}
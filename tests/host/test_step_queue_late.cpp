@@ -0,0 +1,69 @@
+/*
+ * StepQueue late step count: steps due while a long read holds the bus retry until it completes and are each
+ * counted late once, not once per retry.
+ */
+
+#include "test_support.h"
+#include "SimTwi.h"
+#include "TwiController.h"
+#include "StepQueue.h"
+#include "CIOExpander.h"
+
+#define LATE_STEPS      (3)
+
+ControllerStorage<8, 2, 32> twiStorage;
+TwiController twiController(twiStorage);
+
+StepQueue stepQueue;
+
+SimXL9535 stepIox(IOX_I2C_ADDRESS(0));
+SimXL9535 otherIox(IOX_I2C_ADDRESS(1));
+CIOExpander_t iox;
+
+uint8_t readData[200];
+uint16_t stepsDone;
+
+static void stepDone(const CByteStream_t *pStream, CIOExpander_t *pIox) {
+    stepsDone++;
+}
+
+Task *taskTable[] = {&twiController};
+sched_time_t taskDelays[sizeof(taskTable) / sizeof(*taskTable)];
+Scheduler scheduler(sizeof(taskTable) / sizeof(*taskTable), (PGM_P) taskTable, taskDelays);
+
+int main() {
+    simTwiBus.addDevice(&stepIox);
+    simTwiBus.addDevice(&otherIox);
+
+    sched_clock_set_micros(0xffffffffUL - 10000UL);
+    scheduler.begin();
+    simRuntime.begin();
+    ciox_init(&iox, twiController.getHandle(), 0, 0);
+    iox.fStepCallback = stepDone;
+    stepQueue.begin(&iox);
+
+    // on time step with the bus free
+    stepQueue.add(sched_micros() + 1000, 0);
+    simRuntime.runMicros(3000);
+    CHECK_EQ(stepsDone, 1);
+    CHECK_EQ(stepQueue.getLateSteps(), 0);
+
+    // read of 200 bytes holds the bus for several ms, steps due during it retry every STEP_QUEUE_RETRY_MICROS
+    iox_rcv_data(twiController.getHandle(), IOX_I2C_ADDRESS(1), IOX_REG_INPUT_PORT0, readData, sizeof(readData));
+    simRuntime.runMicros(100);
+    CHECK(twiController.isProcessingRequest());
+
+    const time_t start = sched_micros();
+    for (uint8_t i = 0; i < LATE_STEPS; i++) {
+        stepQueue.add(start + 600 + i * 100, 0);
+    }
+    simRuntime.runMicros(20000);
+
+    CHECK(simTwiBus.getBusyMicros() > 4000);
+    CHECK_EQ(stepsDone, 1 + LATE_STEPS);
+    CHECK_EQ(stepQueue.getSteps(), 1 + LATE_STEPS);
+    CHECK(stepQueue.isEmpty());
+    CHECK_EQ(stepQueue.getLateSteps(), LATE_STEPS);
+
+    return test_result("test_step_queue_late");
+}
@@ -0,0 +1,12 @@
+#include "test_support.h"
+
+int testFailures = 0;
+
+int test_result(const char *name) {
+    if (testFailures) {
+        printf("%s: %d check(s) failed\n", name, testFailures);
+        return 1;
+    }
+    printf("%s: passed\n", name);
+    return 0;
+}
@@ -0,0 +1,47 @@
+#ifndef HOST_TEST_SUPPORT_H
+#define HOST_TEST_SUPPORT_H
+
+/*
+ * Minimal checks for the host tests, a failed check prints its location and makes test_result() return 1.
+ *
+ * Usage:
+ *
+ *     CHECK(simUart.getRequests() > 0);
+ *     CHECK_EQ(rd[0], 0x41);
+ *     return test_result("test_sim_uart");
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+static_assert(sizeof(time_t) == 4 && (time_t) -1 > 0, "host tests need the AVR 32 bit unsigned time_t, see host_time32.h");
+
+extern int testFailures;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            testFailures++; \
+        } \
+    } while (0)
+
+#define CHECK_EQ(actual, expected) \
+    do { \
+        const long long _actual = (long long) (actual); \
+        const long long _expected = (long long) (expected); \
+        if (_actual != _expected) { \
+            printf("%s:%d: CHECK_EQ(%s, %s) failed, %lld != %lld\n", __FILE__, __LINE__, #actual, #expected, _actual, _expected); \
+            testFailures++; \
+        } \
+    } while (0)
+
+/**
+ * Print test result
+ *
+ * @param name  test name
+ * @return      process exit code, 0 if all checks passed
+ */
+extern int test_result(const char *name);
+
+#endif //HOST_TEST_SUPPORT_H
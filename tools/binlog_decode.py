@@ -0,0 +1,185 @@
+#!/usr/bin/env python3
+"""
+Decoder for BinLog binary debug output, see src/BinLog.h.
+
+Reads records from a file, serial device or stdin and prints them formatted with the format strings found at
+the record's PROGMEM address in the firmware ELF file.
+
+Usage:
+    binlog_decode.py firmware.elf [input]
+
+    input is a file or serial device, stdin if not given. Set serial port mode first, e.g.:
+        stty -F /dev/ttyUSB0 115200 raw
+"""
+
+import re
+import struct
+import sys
+
+BINLOG_SYNC = 0xB1
+BINLOG_FLAGS_PUTS = 0x80
+AVR_DATA_OFFSET = 0x800000  # ELF addresses of RAM sections start here, flash sections below it
+
+CONVERSION = re.compile(r'%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d+))?(h|l)?([diouxXcsSpeEfFgG%])')
+
+
+class Flash:
+    """Flash content of the firmware from ELF32 little endian section headers"""
+
+    def __init__(self, path):
+        with open(path, 'rb') as f:
+            data = f.read()
+
+        if data[:4] != b'\x7fELF' or data[4] != 1 or data[5] != 1:
+            raise ValueError('%s: not a 32 bit little endian ELF file' % path)
+
+        shoff, = struct.unpack_from('<I', data, 0x20)
+        shentsize, shnum = struct.unpack_from('<HH', data, 0x2E)
+
+        self.sections = []
+        for i in range(shnum):
+            sh_type, sh_flags, sh_addr, sh_offset, sh_size = struct.unpack_from('<4xIIIII', data, shoff + i * shentsize)
+            # SHT_PROGBITS and SHF_ALLOC in flash address space
+            if sh_type == 1 and (sh_flags & 2) and sh_addr < AVR_DATA_OFFSET:
+                self.sections.append((sh_addr, data[sh_offset:sh_offset + sh_size]))
+
+    def string(self, addr):
+        for start, content in self.sections:
+            if start <= addr < start + len(content):
+                end = content.find(b'\0', addr - start)
+                if end < 0:
+                    end = len(content)
+                return content[addr - start:end].decode('latin-1')
+        return None
+
+
+class Args:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def take(self, size, fmt):
+        if self.pos + size > len(self.data):
+            self.pos = len(self.data)
+            return None
+        value, = struct.unpack_from(fmt, self.data, self.pos)
+        self.pos += size
+        return value
+
+    def string(self):
+        end = self.data.find(b'\0', self.pos)
+        if end < 0:
+            end = len(self.data)
+        value = self.data[self.pos:end].decode('latin-1')
+        self.pos = end + 1
+        return value
+
+
+def format_record(flash, fmt, data):
+    args = Args(data)
+    out = []
+    pos = 0
+
+    for m in CONVERSION.finditer(fmt):
+        out.append(fmt[pos:m.start()])
+        pos = m.end()
+
+        flags, width, precision, length, conv = m.groups()
+        if conv == '%':
+            out.append('%')
+            continue
+
+        if width == '*':
+            width = args.take(2, '<h')
+            width = '' if width is None else str(width)
+        if precision == '*':
+            precision = args.take(2, '<h')
+            precision = '' if precision is None else str(precision)
+
+        spec = '%' + flags + (width or '') + ('.' + precision if precision is not None else '')
+
+        if conv == 's':
+            value = args.string()
+        elif conv == 'S':
+            addr = args.take(2, '<H')
+            value = None if addr is None else flash.string(addr)
+            if value is None and addr is not None:
+                value = '<0x%04x>' % addr
+            conv = 's'
+        elif conv == 'p':
+            value = args.take(2, '<H')
+            spec, conv = '0x%04', 'x'
+        elif conv in 'eEfFgG':
+            value = args.take(4, '<f')
+        elif conv in 'di':
+            value = args.take(4, '<i') if length == 'l' else args.take(2, '<h')
+            conv = 'd'
+        elif conv == 'c':
+            value = args.take(2, '<H')
+            value = None if value is None else chr(value & 0xff)
+        else:
+            value = args.take(4, '<I') if length == 'l' else args.take(2, '<H')
+
+        out.append('?' if value is None else (spec + conv) % value)
+
+    out.append(fmt[pos:])
+    return ''.join(out)
+
+
+def decode(flash, stream, output):
+    buf = bytearray()
+    read = getattr(stream, 'read1', stream.read)
+
+    while True:
+        chunk = read(256)
+        if not chunk:
+            break
+        buf.extend(chunk)
+
+        while len(buf) >= 4:
+            if buf[0] != BINLOG_SYNC:
+                # lost sync, skip to next sync byte
+                del buf[0]
+                continue
+
+            nArgs = buf[1] & ~BINLOG_FLAGS_PUTS
+            if len(buf) < 4 + nArgs:
+                break
+
+            addr = buf[2] | (buf[3] << 8)
+            data = bytes(buf[4:4 + nArgs])
+
+            if addr == 0:
+                output.write('<binlog: %d records dropped>\n' % struct.unpack('<H', data[:2].ljust(2, b'\0'))[0])
+            else:
+                fmt = flash.string(addr)
+                if fmt is None:
+                    # not a record start
+                    del buf[0]
+                    continue
+
+                output.write(format_record(flash, fmt, data))
+                if buf[1] & BINLOG_FLAGS_PUTS:
+                    output.write('\n')
+
+            output.flush()
+            del buf[:4 + nArgs]
+
+
+def main(argv):
+    if len(argv) < 2:
+        sys.stderr.write('usage: %s firmware.elf [input]\n' % argv[0])
+        return 1
+
+    flash = Flash(argv[1])
+
+    if len(argv) > 2:
+        with open(argv[2], 'rb', buffering=0) as stream:
+            decode(flash, stream, sys.stdout)
+    else:
+        decode(flash, sys.stdin.buffer, sys.stdout)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))